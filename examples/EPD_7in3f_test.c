@@ -38,6 +38,10 @@
 #include <stdlib.h> // malloc() free()
 #include <string.h>
 
+//Display list for the screens drawn without an image cache
+#define LIST_OPS 128
+static PAINT_OP ListOps[LIST_OPS];
+
 int EPD_7in3f_display_BMP(const char *path, float vol)
 {
     printf("e-Paper Init and Clear...\r\n");
@@ -95,19 +99,15 @@ int EPD_7in3f_display(float vol)
     printf("e-Paper Init and Clear...\r\n");
     EPD_7IN3F_Init();
 
-    //Create a new image cache
-    UBYTE *BlackImage;
-    UDOUBLE Imagesize = ((EPD_7IN3F_WIDTH % 2 == 0)? (EPD_7IN3F_WIDTH / 2 ): (EPD_7IN3F_WIDTH / 2 + 1)) * EPD_7IN3F_HEIGHT;
-    if((BlackImage = (UBYTE *)malloc(Imagesize)) == NULL) {
-        printf("Failed to apply for black memory...\r\n");
-        return -1;
-    }
+    //Record the drawing instead of painting a 192 KB image cache: the panel
+    //pulls it back band by band while the previous band goes out over SPI
+    PAINT_LIST List;
     printf("Paint_NewImage\r\n");
-    Paint_NewImage(BlackImage, EPD_7IN3F_WIDTH, EPD_7IN3F_HEIGHT, 0, EPD_7IN3F_WHITE);
+    Paint_NewImage(NULL, EPD_7IN3F_WIDTH, EPD_7IN3F_HEIGHT, 0, EPD_7IN3F_WHITE);
     Paint_SetScale(7);
+    Paint_ListBegin(&List, ListOps, LIST_OPS, NULL, 0);
 
     printf("Display BMP\r\n");
-    Paint_SelectImage(BlackImage);
     Paint_Clear(EPD_7IN3F_WHITE);
     
     Paint_DrawBitMap(Image7color);
@@ -119,14 +119,13 @@ int EPD_7in3f_display(float vol)
         Paint_DrawString_EN(10, 10, "Low voltage, please charge in time.", &Font16, EPD_7IN3F_BLACK, EPD_7IN3F_WHITE);
         Paint_DrawString_EN(10, 26, strvol, &Font16, EPD_7IN3F_BLACK, EPD_7IN3F_WHITE);
     }
+    Paint_ListEnd();
 
     printf("EPD_Display\r\n");
-    EPD_7IN3F_Display(BlackImage);
+    EPD_7IN3F_DisplayStream(Paint_ListRows, &List);
 
     printf("Goto Sleep...\r\n\r\n");
     EPD_7IN3F_Sleep();
-    free(BlackImage);
-    BlackImage = NULL;
 
     return 0;
 }
@@ -136,21 +135,16 @@ int EPD_7in3f_test(void)
     printf("e-Paper Init and Clear...\r\n");
     EPD_7IN3F_Init();
 
-    //Create a new image cache
-    UBYTE *BlackImage;
-    UDOUBLE Imagesize = ((EPD_7IN3F_WIDTH % 2 == 0)? (EPD_7IN3F_WIDTH / 2 ): (EPD_7IN3F_WIDTH / 2 + 1)) * EPD_7IN3F_HEIGHT;
-    if((BlackImage = (UBYTE *)malloc(Imagesize)) == NULL) {
-        printf("Failed to apply for black memory...\r\n");
-        return -1;
-    }
+    //Record the drawing; no image cache
+    PAINT_LIST List;
     printf("Paint_NewImage\r\n");
-    Paint_NewImage(BlackImage, EPD_7IN3F_WIDTH, EPD_7IN3F_HEIGHT, 0, EPD_7IN3F_WHITE);
+    Paint_NewImage(NULL, EPD_7IN3F_WIDTH, EPD_7IN3F_HEIGHT, 0, EPD_7IN3F_WHITE);
     Paint_SetScale(7);
 
 #if 1   // Drawing on the image
-    //1.Select Image
-    printf("SelectImage:BlackImage\r\n");
-    Paint_SelectImage(BlackImage);
+    //1.Start recording
+    printf("ListBegin\r\n");
+    Paint_ListBegin(&List, ListOps, LIST_OPS, NULL, 0);
     Paint_Clear(EPD_7IN3F_WHITE);
 
     int hNumber, hWidth, vNumber, vWidth;
@@ -160,7 +154,7 @@ int EPD_7in3f_test(void)
 	vWidth = EPD_7IN3F_WIDTH/vNumber; // 480/10
 	
     // 2.Drawing on the image
-    printf("Drawing:BlackImage\r\n");
+    printf("Drawing:List\r\n");
 	for(int i=0; i<vNumber; i++) {
 		Paint_DrawRectangle(1, 1+i*vWidth, 800, vWidth*(i+1), EPD_7IN3F_GREEN + (i % 5), DOT_PIXEL_1X1, DRAW_FILL_FULL);
 	}
@@ -170,16 +164,14 @@ int EPD_7in3f_test(void)
 			Paint_DrawRectangle(1+i*hWidth, 1, hWidth*(1+i), 480, j%2 ? EPD_7IN3F_BLACK : EPD_7IN3F_WHITE, DOT_PIXEL_1X1, DRAW_FILL_FULL);
 		}
 	}
+    Paint_ListEnd();
 
     printf("EPD_Display\r\n");
-    EPD_7IN3F_Display(BlackImage);
+    EPD_7IN3F_DisplayStream(Paint_ListRows, &List);
 #endif
 
     printf("Goto Sleep...\r\n");
     EPD_7IN3F_Sleep();
-    free(BlackImage);
-    BlackImage = NULL;
 
     return 0;
 }
-
@@ -56,6 +56,74 @@ void DEV_SPI_Write_nByte(UBYTE *pData, uint32_t Len)
     spi_write_blocking(EPD_SPI_PORT, pData, Len);
 }
 
+/**
+ * SPI DMA: one channel feeding the EPD_SPI_PORT TX FIFO. Completion comes
+ * in on DMA_IRQ_1, shared with anyone else using it (the SD driver uses
+ * DMA_IRQ_0).
+**/
+static int spi_dma_chan = -1;
+static volatile int spi_dma_busy = 0;
+static void (*spi_dma_done)(void *Ctx) = NULL;
+static void *spi_dma_ctx = NULL;
+
+static void DEV_SPI_DMA_IRQ(void)
+{
+	if (spi_dma_chan < 0 || !dma_channel_get_irq1_status(spi_dma_chan))
+		return;
+	dma_channel_acknowledge_irq1(spi_dma_chan);
+	spi_dma_busy = 0;
+	if (spi_dma_done)
+		spi_dma_done(spi_dma_ctx);
+}
+
+static void DEV_SPI_DMA_Init(void)
+{
+	spi_dma_chan = dma_claim_unused_channel(false);
+	if (spi_dma_chan < 0)
+		return;  // DEV_SPI_Write_nByte_DMA() falls back to blocking writes
+	dma_channel_config c = dma_channel_get_default_config(spi_dma_chan);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, true);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, spi_get_dreq(EPD_SPI_PORT, true));
+	dma_channel_configure(spi_dma_chan, &c, &spi_get_hw(EPD_SPI_PORT)->dr,
+	                      NULL, 0, false);
+	dma_channel_set_irq1_enabled(spi_dma_chan, true);
+	irq_add_shared_handler(DMA_IRQ_1, DEV_SPI_DMA_IRQ,
+	                       PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+	irq_set_enabled(DMA_IRQ_1, true);
+}
+
+void DEV_SPI_Write_nByte_DMA(const UBYTE *pData, UDOUBLE Len,
+                             void (*Done)(void *Ctx), void *Ctx)
+{
+	while (spi_dma_busy)
+		tight_loop_contents();
+	if (spi_dma_chan < 0 || Len == 0) {
+		spi_write_blocking(EPD_SPI_PORT, pData, Len);
+		if (Done)
+			Done(Ctx);
+		return;
+	}
+	spi_dma_done = Done;
+	spi_dma_ctx = Ctx;
+	spi_dma_busy = 1;
+	dma_channel_transfer_from_buffer_now(spi_dma_chan, pData, Len);
+}
+
+void DEV_SPI_DMA_Wait(void)
+{
+	while (spi_dma_busy)
+		tight_loop_contents();
+	while (spi_is_busy(EPD_SPI_PORT))
+		tight_loop_contents();
+	// Nothing reads the RX side during a DMA write: drain it and clear the
+	// overrun, as spi_write_blocking() does.
+	while (spi_is_readable(EPD_SPI_PORT))
+		(void)spi_get_hw(EPD_SPI_PORT)->dr;
+	spi_get_hw(EPD_SPI_PORT)->icr = SPI_SSPICR_RORIC_BITS;
+}
+
 /**
  * @brief I2C write byte
  * 
@@ -104,6 +172,72 @@ void DEV_Delay_ms(UDOUBLE xms)
 	watchdog_update();
 }
 
+uint64_t DEV_Deadline_ms(UDOUBLE xms)
+{
+	return time_us_64() + (uint64_t)xms * 1000;
+}
+
+/**
+ * BUSY edges
+**/
+volatile UDOUBLE dev_busy_rises = 0;
+volatile UDOUBLE dev_busy_falls = 0;
+volatile uint64_t dev_busy_rise_us = 0;
+volatile uint64_t dev_busy_fall_us = 0;
+
+static void DEV_GPIO_IRQ(uint gpio, uint32_t events)
+{
+	if (gpio != EPD_BUSY_PIN)
+		return;
+	uint64_t now = time_us_64();
+	if (events & GPIO_IRQ_EDGE_FALL) {
+		dev_busy_falls++;
+		dev_busy_fall_us = now;
+	}
+	if (events & GPIO_IRQ_EDGE_RISE) {
+		dev_busy_rises++;
+		dev_busy_rise_us = now;
+	}
+}
+
+// Only here to end the __wfi in DEV_Wait_Pin() at its deadline.
+static int64_t DEV_Wake_Alarm(alarm_id_t id, void *user_data)
+{
+	(void)id;
+	(void)user_data;
+	return 0;
+}
+
+int DEV_Wait_Pin(UWORD Pin, UBYTE Value, UDOUBLE timeout_ms)
+{
+	absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+	alarm_id_t alarm = add_alarm_at(deadline, DEV_Wake_Alarm, NULL, false);
+	int rc = 0;
+	for (;;) {
+		// Checked with interrupts masked, so an edge between the check and
+		// the __wfi still ends it (as a pending interrupt).
+		uint32_t save = save_and_disable_interrupts();
+		if (gpio_get(Pin) == Value) {
+			restore_interrupts(save);
+			break;
+		}
+		if (time_reached(deadline)) {
+			restore_interrupts(save);
+			rc = -1;
+			break;
+		}
+		if (alarm > 0)
+			__wfi();
+		restore_interrupts(save);
+		if (alarm <= 0)
+			sleep_ms(1);  // no alarm slot: poll instead
+		watchdog_update();
+	}
+	if (alarm > 0)
+		cancel_alarm(alarm);
+	return rc;
+}
+
 void DEV_GPIO_Init(void)
 {
 	// EPD
@@ -111,6 +245,9 @@ void DEV_GPIO_Init(void)
 	DEV_GPIO_Mode(EPD_DC_PIN, 1);
 	DEV_GPIO_Mode(EPD_CS_PIN, 1);
 	DEV_GPIO_Mode(EPD_BUSY_PIN, 0);
+	gpio_set_irq_enabled_with_callback(EPD_BUSY_PIN,
+	                                   GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL,
+	                                   true, DEV_GPIO_IRQ);
 	// LED
 	DEV_GPIO_Mode(LED_ACT, 1);
 	DEV_GPIO_Mode(LED_PWR, 1);
@@ -148,6 +285,7 @@ UBYTE DEV_Module_Init(void)
     spi_init(EPD_SPI_PORT, 8000 * 1000);
     gpio_set_function(EPD_CLK_PIN, GPIO_FUNC_SPI);
     gpio_set_function(EPD_MOSI_PIN, GPIO_FUNC_SPI);
+    DEV_SPI_DMA_Init();
 	
 	spi_init(SD_SPI_PORT, 12500 * 1000);
 	gpio_set_function(SD_CLK_PIN, GPIO_FUNC_SPI);
@@ -50,6 +50,9 @@
 
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "hardware/i2c.h"
 #include "hardware/adc.h"
 #include "hardware/watchdog.h"
@@ -104,11 +107,30 @@ UBYTE DEV_Digital_Read(UWORD Pin);
 
 void DEV_SPI_WriteByte(UBYTE Value);
 void DEV_SPI_Write_nByte(UBYTE *pData, UDOUBLE Len);
+// DMA write on EPD_SPI_PORT: returns at once, Done(Ctx) runs from the DMA
+// IRQ once pData may be reused. Waits for a write still in flight first.
+// Without a free DMA channel it is a blocking write.
+void DEV_SPI_Write_nByte_DMA(const UBYTE *pData, UDOUBLE Len,
+                             void (*Done)(void *Ctx), void *Ctx);
+// Wait until the last DMA write has left the SPI shift register.
+void DEV_SPI_DMA_Wait(void);
 
 void I2C_Write_Byte(UBYTE Reg, UBYTE Value);
 UBYTE I2C_Read_Byte(UBYTE Reg);
 
 void DEV_Delay_ms(UDOUBLE xms);
+// time_us_64() xms from now on the DEV_Delay_ms() clock: a delay the caller
+// waits out itself.
+uint64_t DEV_Deadline_ms(UDOUBLE xms);
+
+// EPD_BUSY_PIN edges, counted and timestamped (us since boot) by a GPIO IRQ.
+extern volatile UDOUBLE dev_busy_rises;
+extern volatile UDOUBLE dev_busy_falls;
+extern volatile uint64_t dev_busy_rise_us;
+extern volatile uint64_t dev_busy_fall_us;
+// Sleep (__wfi) until Pin reads Value, waking on BUSY edges and a timer
+// alarm for the timeout. Returns 0, or -1 after timeout_ms.
+int DEV_Wait_Pin(UWORD Pin, UBYTE Value, UDOUBLE timeout_ms);
 
 UBYTE DEV_Module_Init(void);
 void DEV_Module_Exit(void);
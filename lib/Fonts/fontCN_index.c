@@ -0,0 +1,35 @@
+// Generated by tools/cn_index.c from the CH_CN tables; do not edit.
+// See that file for how to regenerate it.
+
+#include "fonts.h"
+
+static const uint16_t Font12CN_Code[9] = {
+  0x4100, 0x6100, 0x6200, 0x6300, 0xBAC3, 0xC4E3, 0xC5C9, 0xCAF7,
+  0xDDAE,
+};
+
+static const uint16_t Font12CN_Entry[9] = {
+  8, 5, 6, 7, 1, 0, 4, 2,
+  3,
+};
+
+static const uint16_t Font24CN_Code[26] = {
+  0x4100, 0x6100, 0x6200, 0x6300, 0xB4CB, 0xB5C4, 0xB5E3, 0xB5E7,
+  0xB6D4, 0xBAC3, 0xBADA, 0xC4E3, 0xC5C9, 0xC8ED, 0xCAF7, 0xCCE5,
+  0xCEA2, 0xCEAA, 0xCFC2, 0xD1A9, 0xD1C5, 0xD3A6, 0xD5F3, 0xD7D3,
+  0xD7D6, 0xDDAE,
+};
+
+static const uint16_t Font24CN_Entry[26] = {
+  19, 20, 21, 22, 6, 12, 13, 25,
+  10, 1, 5, 0, 18, 3, 16, 8,
+  2, 15, 9, 24, 4, 11, 14, 26,
+  7, 17,
+};
+
+const cFONT_INDEX FontCN_Index[2] = {
+  {&Font12CN, Font12CN_Code, Font12CN_Entry, 9, 9},
+  {&Font24CN, Font24CN_Code, Font24CN_Entry, 26, 27},
+};
+
+const uint16_t FontCN_IndexCount = 2;
@@ -86,6 +86,21 @@ extern sFONT Font8;
 
 extern cFONT Font12CN;
 extern cFONT Font24CN;
+
+//Sorted code index over a cFONT table, generated by tools/cn_index.c
+//into fontCN_index.c: Code[] ascending (index[0] << 8 | index[1], or
+//index[0] << 8 for ASCII), Entry[] the table position of each
+typedef struct
+{
+  const cFONT *font;
+  const uint16_t *Code;
+  const uint16_t *Entry;
+  uint16_t size;
+  uint16_t table_size;          // font->size when generated
+}cFONT_INDEX;
+
+extern const cFONT_INDEX FontCN_Index[];
+extern const uint16_t FontCN_IndexCount;
 #ifdef __cplusplus
 }
 #endif
@@ -85,6 +85,795 @@
 
 PAINT Paint;
 
+//Display list being recorded (Paint_ListBegin), NULL when drawing
+static PAINT_LIST *Paint_List = NULL;
+
+/******************************************************************************
+Pixel writers: one per rotation/mirror combination and scale, picked by
+Paint_Resolve() whenever the canvas state changes, so that drawing a pixel
+does no switching. They do no checking either: Paint_SetPixel() keeps the
+pixel inside [Paint_ClipX0, Paint_ClipX1) x [Paint_ClipY0, Paint_ClipY1),
+the canvas area behind the image (or band) in Paint.Image, and primitives
+that know their whole shape lies inside it call Paint_Writer directly.
+******************************************************************************/
+typedef void (*PAINT_WRITER)(UWORD Xpoint, UWORD Ypoint, UWORD Color);
+
+static void Paint_WriterNone(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    (void)Xpoint;
+    (void)Ypoint;
+    (void)Color;
+}
+
+static PAINT_WRITER Paint_Writer = Paint_WriterNone;
+static UWORD Paint_ClipX0, Paint_ClipY0, Paint_ClipX1, Paint_ClipY1;
+//Paint.Dirty[Paint.DirtyLast] in canvas pixels [X0, X1) x [Y0, Y1), clipped,
+//empty when unknown: Paint_SetPixel() inside it needs no other check
+static UWORD Paint_HitX0, Paint_HitY0, Paint_HitX1, Paint_HitY1;
+//Swap << 2 | FlipX << 1 | FlipY of the writer, for Paint_FillRect()
+static UBYTE Paint_Transform;
+
+static inline void Paint_Put2(UWORD X, UWORD Y, UWORD Color)
+{
+    UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
+    UBYTE Rdata = Paint.Image[Addr];
+    if(Color == BLACK)
+        Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
+    else
+        Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
+}
+
+static inline void Paint_Put4(UWORD X, UWORD Y, UWORD Color)
+{
+    UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
+    Color = Color % 4;//Guaranteed color scale is 4  --- 0~3
+    UBYTE Rdata = Paint.Image[Addr];
+
+    Rdata = Rdata & (~(0xC0 >> ((X % 4)*2)));//Clear first, then set value
+    Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4)*2));
+}
+
+static inline void Paint_Put7(UWORD X, UWORD Y, UWORD Color)
+{
+    UDOUBLE Addr = X / 2  + Y * Paint.WidthByte;
+    UBYTE Rdata = Paint.Image[Addr];
+    Rdata = Rdata & (~(0xF0 >> ((X % 2)*4)));//Clear first, then set value
+    Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2)*4));
+}
+
+//Canvas (Xpoint, Ypoint) to memory: swap the axes, then flip X and/or Y
+#define PAINT_WRITER_DEFINE(Scale, Swap, FlipX, FlipY)                                   \
+static void Paint_Writer##Scale##_##Swap##FlipX##FlipY(UWORD Xpoint, UWORD Ypoint, UWORD Color) \
+{                                                                                         \
+    UWORD X = (Swap)? Ypoint : Xpoint;                                                    \
+    UWORD Y = (Swap)? Xpoint : Ypoint;                                                    \
+    if(FlipX)                                                                             \
+        X = Paint.WidthMemory - X - 1;                                                    \
+    if(FlipY)                                                                             \
+        Y = Paint.HeightMemory - Y - 1;                                                   \
+    Paint_Put##Scale(X, Y - Paint.BandY, Color);                                          \
+}
+
+#define PAINT_WRITERS_DEFINE(Scale)         \
+    PAINT_WRITER_DEFINE(Scale, 0, 0, 0)     \
+    PAINT_WRITER_DEFINE(Scale, 0, 0, 1)     \
+    PAINT_WRITER_DEFINE(Scale, 0, 1, 0)     \
+    PAINT_WRITER_DEFINE(Scale, 0, 1, 1)     \
+    PAINT_WRITER_DEFINE(Scale, 1, 0, 0)     \
+    PAINT_WRITER_DEFINE(Scale, 1, 0, 1)     \
+    PAINT_WRITER_DEFINE(Scale, 1, 1, 0)     \
+    PAINT_WRITER_DEFINE(Scale, 1, 1, 1)
+
+#define PAINT_WRITERS(Scale) {                                          \
+    Paint_Writer##Scale##_000, Paint_Writer##Scale##_001,               \
+    Paint_Writer##Scale##_010, Paint_Writer##Scale##_011,               \
+    Paint_Writer##Scale##_100, Paint_Writer##Scale##_101,               \
+    Paint_Writer##Scale##_110, Paint_Writer##Scale##_111 }
+
+PAINT_WRITERS_DEFINE(2)
+PAINT_WRITERS_DEFINE(4)
+PAINT_WRITERS_DEFINE(7)
+
+//[scale 2, 4, 7][Swap << 2 | FlipX << 1 | FlipY]
+static const PAINT_WRITER Paint_Writers[3][8] = {
+    PAINT_WRITERS(2), PAINT_WRITERS(4), PAINT_WRITERS(7),
+};
+
+/******************************************************************************
+function: Pick the pixel writer and clip area for the current rotation,
+          mirror, scale and band
+parameter:
+******************************************************************************/
+static void Paint_Resolve(void)
+{
+    UBYTE Swap = 0, FlipX = 0, FlipY = 0;
+    switch(Paint.Rotate) {
+    case 0:
+        break;
+    case 90:
+        Swap = 1;
+        FlipX = 1;
+        break;
+    case 180:
+        FlipX = 1;
+        FlipY = 1;
+        break;
+    case 270:
+        Swap = 1;
+        FlipY = 1;
+        break;
+    default:
+        Paint_Writer = Paint_WriterNone;
+        Paint_ClipX0 = Paint_ClipX1 = Paint_ClipY0 = Paint_ClipY1 = 0;
+        Paint_HitX0 = Paint_HitX1 = Paint_HitY0 = Paint_HitY1 = 0;
+        return;
+    }
+    if(Paint.Mirror & MIRROR_HORIZONTAL)
+        FlipX ^= 1;
+    if(Paint.Mirror & MIRROR_VERTICAL)
+        FlipY ^= 1;
+
+    //The band's memory rows, as canvas rows (columns if the axes swap)
+    UWORD R0 = Paint.BandY, R1 = Paint.BandY + Paint.BandRows;
+    if(R1 > Paint.HeightMemory)
+        R1 = Paint.HeightMemory;
+    if(R0 > R1)
+        R0 = R1;
+    if(FlipY) {
+        UWORD T = Paint.HeightMemory - R1;
+        R1 = Paint.HeightMemory - R0;
+        R0 = T;
+    }
+    Paint_ClipX0 = 0;
+    Paint_ClipY0 = 0;
+    Paint_ClipX1 = Paint.Width;
+    Paint_ClipY1 = Paint.Height;
+    if(Swap) {
+        Paint_ClipX0 = R0;
+        Paint_ClipX1 = R1;
+    } else {
+        Paint_ClipY0 = R0;
+        Paint_ClipY1 = R1;
+    }
+
+    UBYTE Index = Swap << 2 | FlipX << 1 | FlipY;
+    Paint_Transform = Index;
+    Paint_HitX0 = Paint_HitX1 = Paint_HitY0 = Paint_HitY1 = 0;
+    if(Paint.Scale == 2)
+        Paint_Writer = Paint_Writers[0][Index];
+    else if(Paint.Scale == 4)
+        Paint_Writer = Paint_Writers[1][Index];
+    else if(Paint.Scale == 7)
+        Paint_Writer = Paint_Writers[2][Index];
+    else
+        Paint_Writer = Paint_WriterNone;
+}
+
+//Paint_SetPixel() without the Paint_Dirty() check, for drawing calls that
+//have noted their whole area already
+static void Paint_PutPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    if(Xpoint < Paint_ClipX0 || Xpoint >= Paint_ClipX1 ||
+       Ypoint < Paint_ClipY0 || Ypoint >= Paint_ClipY1) {
+        if(Xpoint >= Paint.Width || Ypoint >= Paint.Height) {
+            Debug("Exceeding display boundaries\r\n");
+        }
+        return;
+    }
+    Paint_Writer(Xpoint, Ypoint, Color);
+}
+
+//Whether [X0, X1) x [Y0, Y1) lies inside the clip area, for Paint_Writer
+static inline int Paint_Inside(int X0, int Y0, int X1, int Y1)
+{
+    return X0 >= Paint_ClipX0 && Y0 >= Paint_ClipY0 &&
+           X1 <= Paint_ClipX1 && Y1 <= Paint_ClipY1;
+}
+
+/******************************************************************************
+function: Fill Len bytes with Data, a word at a time where aligned
+parameter:
+******************************************************************************/
+static void Paint_FillBytes(UBYTE *Addr, UDOUBLE Len, UBYTE Data)
+{
+    while(Len && ((uintptr_t)Addr & 3)) {
+        *Addr++ = Data;
+        Len--;
+    }
+    uint32_t Word = Data * 0x01010101u;
+    for(; Len >= 4; Len -= 4, Addr += 4)
+        memcpy(__builtin_assume_aligned(Addr, 4), &Word, sizeof(Word));
+    while(Len--)
+        *Addr++ = Data;
+}
+
+/******************************************************************************
+function: Fill pixels X0..X1-1 of one memory row
+parameter:
+    Row     :   The row in Paint.Image
+    Bits    :   Bits per pixel (1, 2, 4 for scale 2, 4, 7)
+    Data    :   A byte of pixels in the fill colour
+info:
+    Pixels sharing a byte with pixels outside the span are merged in under a
+    mask; the bytes in between are stored whole.
+******************************************************************************/
+static void Paint_FillSpan(UBYTE *Row, UWORD X0, UWORD X1, UBYTE Bits, UBYTE Data)
+{
+    UBYTE PerByte = 8 / Bits;
+    UWORD First = X0 / PerByte, End = X1 / PerByte;
+    UBYTE Lead = X0 % PerByte, Trail = X1 % PerByte;
+    UBYTE Mask;
+
+    if(First == End) {  //inside one byte
+        Mask = (0xFF >> (Lead * Bits)) & ~(0xFF >> (Trail * Bits));
+        Row[First] = (Row[First] & ~Mask) | (Data & Mask);
+        return;
+    }
+    if(Lead) {
+        Mask = 0xFF >> (Lead * Bits);
+        Row[First] = (Row[First] & ~Mask) | (Data & Mask);
+        First++;
+    }
+    Paint_FillBytes(Row + First, End - First, Data);
+    if(Trail) {
+        Mask = ~(0xFF >> (Trail * Bits));
+        Row[End] = (Row[End] & ~Mask) | (Data & Mask);
+    }
+}
+
+/******************************************************************************
+function: Map canvas [X0, X1) x [Y0, Y1) to memory columns [*MX0, *MX1) and
+          rows [*MY0, *MY1): a rectangle under every rotation and mirror
+parameter:
+******************************************************************************/
+static void Paint_ToMemory(int X0, int Y0, int X1, int Y1, int *MX0, int *MY0, int *MX1, int *MY1)
+{
+    int T;
+    if(Paint_Transform & 4) {
+        T = X0; X0 = Y0; Y0 = T;
+        T = X1; X1 = Y1; Y1 = T;
+    }
+    if(Paint_Transform & 2) {
+        T = Paint.WidthMemory - X1;
+        X1 = Paint.WidthMemory - X0;
+        X0 = T;
+    }
+    if(Paint_Transform & 1) {
+        T = Paint.HeightMemory - Y1;
+        Y1 = Paint.HeightMemory - Y0;
+        Y0 = T;
+    }
+    *MX0 = X0;
+    *MY0 = Y0;
+    *MX1 = X1;
+    *MY1 = Y1;
+}
+
+//Paint_ToMemory() undone: memory rectangle R in canvas pixels, clipped, as
+//Paint_Hit*
+static void Paint_DirtyHit(const PAINT_RECT *R)
+{
+    int X0 = R->X0, Y0 = R->Y0, X1 = R->X1, Y1 = R->Y1, T;
+    if(Paint_Transform & 1) {
+        T = Paint.HeightMemory - Y1;
+        Y1 = Paint.HeightMemory - Y0;
+        Y0 = T;
+    }
+    if(Paint_Transform & 2) {
+        T = Paint.WidthMemory - X1;
+        X1 = Paint.WidthMemory - X0;
+        X0 = T;
+    }
+    if(Paint_Transform & 4) {
+        T = X0; X0 = Y0; Y0 = T;
+        T = X1; X1 = Y1; Y1 = T;
+    }
+    Paint_HitX0 = (X0 > Paint_ClipX0)? X0 : Paint_ClipX0;
+    Paint_HitY0 = (Y0 > Paint_ClipY0)? Y0 : Paint_ClipY0;
+    Paint_HitX1 = (X1 < Paint_ClipX1)? X1 : Paint_ClipX1;
+    Paint_HitY1 = (Y1 < Paint_ClipY1)? Y1 : Paint_ClipY1;
+}
+
+/******************************************************************************
+function: Add memory pixels [X0, X1) x [Y0, Y1) to Paint.Dirty
+parameter:
+info:
+    Merged with every rectangle it overlaps or touches, and the result with
+    every one that overlaps or touches that; with no room left, merged into
+    the one whose area grows least.
+******************************************************************************/
+static void Paint_AddDirty(int X0, int Y0, int X1, int Y1)
+{
+    for(;;) {
+        UBYTE Merge = PAINT_DIRTY_MAX;
+        for(UBYTE i = 0; i < Paint.DirtyCount; i++) {
+            const PAINT_RECT *R = &Paint.Dirty[i];
+            if(X0 <= R->X1 && R->X0 <= X1 && Y0 <= R->Y1 && R->Y0 <= Y1) {
+                Merge = i;
+                break;
+            }
+        }
+        if(Merge == PAINT_DIRTY_MAX) {
+            if(Paint.DirtyCount < PAINT_DIRTY_MAX) {
+                PAINT_RECT *R = &Paint.Dirty[Paint.DirtyCount];
+                R->X0 = X0;
+                R->Y0 = Y0;
+                R->X1 = X1;
+                R->Y1 = Y1;
+                Paint.DirtyLast = Paint.DirtyCount++;
+                return;
+            }
+            UDOUBLE Least = ~(UDOUBLE)0;
+            for(UBYTE i = 0; i < Paint.DirtyCount; i++) {
+                const PAINT_RECT *R = &Paint.Dirty[i];
+                UDOUBLE Grown = (UDOUBLE)((X1 > R->X1? X1 : R->X1) - (X0 < R->X0? X0 : R->X0)) *
+                                ((Y1 > R->Y1? Y1 : R->Y1) - (Y0 < R->Y0? Y0 : R->Y0)) -
+                                (UDOUBLE)(R->X1 - R->X0) * (R->Y1 - R->Y0);
+                if(Grown < Least) {
+                    Least = Grown;
+                    Merge = i;
+                }
+            }
+        }
+        const PAINT_RECT *R = &Paint.Dirty[Merge];
+        X0 = (X0 < R->X0)? X0 : R->X0;
+        Y0 = (Y0 < R->Y0)? Y0 : R->Y0;
+        X1 = (X1 > R->X1)? X1 : R->X1;
+        Y1 = (Y1 > R->Y1)? Y1 : R->Y1;
+        Paint.Dirty[Merge] = Paint.Dirty[--Paint.DirtyCount];
+    }
+}
+
+/******************************************************************************
+function: Note that canvas pixels [X0, X1) x [Y0, Y1), clipped, may change
+parameter:
+info:
+    Drawing calls note the whole area they may draw in before drawing it, so
+    that the calls they make in turn end at the check on Paint.DirtyLast.
+******************************************************************************/
+static void Paint_Dirty(int X0, int Y0, int X1, int Y1)
+{
+    if(X0 < Paint_ClipX0)
+        X0 = Paint_ClipX0;
+    if(Y0 < Paint_ClipY0)
+        Y0 = Paint_ClipY0;
+    if(X1 > Paint_ClipX1)
+        X1 = Paint_ClipX1;
+    if(Y1 > Paint_ClipY1)
+        Y1 = Paint_ClipY1;
+    if(X0 >= X1 || Y0 >= Y1 || Paint_Writer == Paint_WriterNone)
+        return;
+
+    if(X0 >= Paint_HitX0 && Y0 >= Paint_HitY0 && X1 <= Paint_HitX1 && Y1 <= Paint_HitY1)
+        return;
+
+    int MX0, MY0, MX1, MY1;
+    Paint_ToMemory(X0, Y0, X1, Y1, &MX0, &MY0, &MX1, &MY1);
+    const PAINT_RECT *Last = &Paint.Dirty[Paint.DirtyLast];
+    if(!Paint.DirtyCount || MX0 < Last->X0 || MY0 < Last->Y0 ||
+       MX1 > Last->X1 || MY1 > Last->Y1)
+        Paint_AddDirty(MX0, MY0, MX1, MY1);
+    Paint_DirtyHit(&Paint.Dirty[Paint.DirtyLast]);
+}
+
+//Paint_Dirty() for the dots Paint_DrawPoint() draws at X0..X1, Y0..Y1 in
+//either style
+static void Paint_DirtyDots(int X0, int Y0, int X1, int Y1, DOT_PIXEL Dot_Pixel)
+{
+    Paint_Dirty(X0 - Dot_Pixel, Y0 - Dot_Pixel, X1 + Dot_Pixel - 1, Y1 + Dot_Pixel - 1);
+}
+
+/******************************************************************************
+function: Fill canvas pixels [X0, X1) x [Y0, Y1), clipped
+parameter:
+    Color   :   Painted colour, as for Paint_SetPixel()
+info:
+    Filled as spans along the memory rows.
+******************************************************************************/
+static void Paint_FillRect(int X0, int Y0, int X1, int Y1, UWORD Color)
+{
+    if(X0 < Paint_ClipX0)
+        X0 = Paint_ClipX0;
+    if(Y0 < Paint_ClipY0)
+        Y0 = Paint_ClipY0;
+    if(X1 > Paint_ClipX1)
+        X1 = Paint_ClipX1;
+    if(Y1 > Paint_ClipY1)
+        Y1 = Paint_ClipY1;
+    if(X0 >= X1 || Y0 >= Y1 || Paint_Writer == Paint_WriterNone)
+        return;
+    if(Paint.Scale == 7 && Color > 0x0F) {
+        //Not a colour index (IMAGE_BACKGROUND): spills over into the other
+        //nibble, so leave it to the writer
+        for(int Y = Y0; Y < Y1; Y++)
+            for(int X = X0; X < X1; X++)
+                Paint_Writer(X, Y, Color);
+        return;
+    }
+
+    int MX0, MY0, MX1, MY1;
+    Paint_ToMemory(X0, Y0, X1, Y1, &MX0, &MY0, &MX1, &MY1);
+
+    UBYTE Bits, Data;
+    if(Paint.Scale == 2) {
+        Bits = 1;
+        Data = (Color == BLACK)? 0x00 : 0xFF;
+    } else if(Paint.Scale == 4) {
+        Bits = 2;
+        Data = (Color % 4) * 0x55;
+    } else {
+        Bits = 4;
+        Data = Color * 0x11;
+    }
+    UBYTE *Row = Paint.Image + (UDOUBLE)(MY0 - Paint.BandY) * Paint.WidthByte;
+    for(int Y = MY0; Y < MY1; Y++, Row += Paint.WidthByte)
+        Paint_FillSpan(Row, MX0, MX1, Bits, Data);
+}
+
+/******************************************************************************
+Glyph blitter for scale 7: each font byte (8 pixels, MSB first) is looked up
+in a table of the 4 packed output bytes for the current foreground and
+background, and in one of 4 masks (0xF where the bit is set) for a
+transparent background.
+******************************************************************************/
+#define PAINT_GLYPH_MAX 48      //Side of the largest glyph blitted (Font24CN: 32x41)
+
+static UBYTE Paint_GlyphPixels[256][4];
+static UBYTE Paint_GlyphMasks[256][4];
+static UWORD Paint_GlyphFg = 0xFFFF, Paint_GlyphBg = 0xFFFF;
+//A glyph turned to memory orientation, when rotated or mirrored in X
+static UBYTE Paint_GlyphScratch[PAINT_GLYPH_MAX * (PAINT_GLYPH_MAX / 8)];
+
+static void Paint_GlyphTables(UWORD Fg, UWORD Bg)
+{
+    if(Fg == Paint_GlyphFg && Bg == Paint_GlyphBg)
+        return;
+    for(UWORD Byte = 0; Byte < 256; Byte++) {
+        for(UBYTE k = 0; k < 4; k++) {
+            UBYTE Hi = Byte & (0x80 >> (2 * k)), Lo = Byte & (0x40 >> (2 * k));
+            Paint_GlyphPixels[Byte][k] = ((Hi? Fg : Bg) << 4) | (Lo? Fg : Bg);
+            Paint_GlyphMasks[Byte][k] = (Hi? 0xF0 : 0) | (Lo? 0x0F : 0);
+        }
+    }
+    Paint_GlyphFg = Fg;
+    Paint_GlyphBg = Bg;
+}
+
+/******************************************************************************
+function: Draw a glyph through the tables, if it can be
+parameter:
+    Xpoint, Ypoint   : Top left on the canvas
+    Glyph            : Width x Height bits, rows padded to whole bytes
+    Color_Foreground : For set bits
+    Color_Background : For clear bits, FONT_BACKGROUND to leave them
+return:     0 if drawn; -1 if the caller has to draw it pixel by pixel (not
+            scale 7, not wholly inside the clip, too big, or a colour that
+            is not a 4-bit index)
+******************************************************************************/
+static int Paint_BlitGlyph(UWORD Xpoint, UWORD Ypoint, const UBYTE *Glyph, UWORD Width, UWORD Height,
+                           UWORD Color_Foreground, UWORD Color_Background)
+{
+    UBYTE Transparent = (Color_Background == FONT_BACKGROUND);
+    if(Paint.Scale != 7 || Paint_Writer == Paint_WriterNone ||
+       Color_Foreground > 0x0F || (!Transparent && Color_Background > 0x0F) ||
+       Width > PAINT_GLYPH_MAX || Height > PAINT_GLYPH_MAX ||
+       !Paint_Inside(Xpoint, Ypoint, Xpoint + Width, Ypoint + Height))
+        return -1;
+    Paint_GlyphTables(Color_Foreground, Transparent? 0 : Color_Background);
+
+    int MX0, MY0, MX1, MY1;
+    Paint_ToMemory(Xpoint, Ypoint, Xpoint + Width, Ypoint + Height, &MX0, &MY0, &MX1, &MY1);
+    UWORD MemWidth = MX1 - MX0, MemHeight = MY1 - MY0;
+    UWORD Stride = (Width + 7) / 8;
+    const UBYTE *Src = Glyph;
+    int SrcStride = Stride;
+
+    if(Paint_Transform == 1) {          //upside down: rows in reverse
+        Src = Glyph + (Height - 1) * Stride;
+        SrcStride = -(int)Stride;
+    } else if(Paint_Transform == 2 || Paint_Transform == 3) {
+        //Mirrored in X: each row byte reversed, then shifted into place
+        memset(Paint_GlyphScratch, 0, Stride * Height);
+        for(UWORD r = 0; r < Height; r++) {
+            UBYTE *Dst = Paint_GlyphScratch + ((Paint_Transform & 1)? Height - 1 - r : r) * Stride;
+            for(UWORD i = 0; i < Stride; i++) {
+                UBYTE Byte = Glyph[r * Stride + i];
+                if(!Byte)
+                    continue;
+                Byte = (Byte & 0xF0) >> 4 | (Byte & 0x0F) << 4;
+                Byte = (Byte & 0xCC) >> 2 | (Byte & 0x33) << 2;
+                Byte = (Byte & 0xAA) >> 1 | (Byte & 0x55) << 1;
+                int u = Width - 8 - 8 * i;      //where column 8i+7 lands
+                if(u < 0) {
+                    Dst[0] |= Byte << -u;
+                } else {
+                    Dst[u / 8] |= Byte >> (u % 8);
+                    if(u % 8)
+                        Dst[u / 8 + 1] |= Byte << (8 - u % 8);
+                }
+            }
+        }
+        Src = Paint_GlyphScratch;
+    } else if(Paint_Transform != 0) {
+        //Rotated a quarter turn: glyph columns become rows, bit by bit
+        SrcStride = (MemWidth + 7) / 8;
+        memset(Paint_GlyphScratch, 0, SrcStride * MemHeight);
+        for(UWORD r = 0; r < Height; r++) {
+            UWORD u = (Paint_Transform & 2)? MemWidth - 1 - r : r;
+            for(UWORD c = 0; c < Width; c++) {
+                UBYTE Byte = Glyph[r * Stride + c / 8];
+                if(!Byte) {
+                    c |= 7;
+                    continue;
+                }
+                if(!(Byte & (0x80 >> (c % 8))))
+                    continue;
+                UWORD v = (Paint_Transform & 1)? MemHeight - 1 - c : c;
+                Paint_GlyphScratch[v * SrcStride + u / 8] |= 0x80 >> (u % 8);
+            }
+        }
+        Src = Paint_GlyphScratch;
+    }
+
+    UBYTE Odd = MX0 & 1;
+    UBYTE *Row = Paint.Image + (UDOUBLE)(MY0 - Paint.BandY) * Paint.WidthByte + MX0 / 2;
+    for(UWORD v = 0; v < MemHeight; v++, Row += Paint.WidthByte, Src += SrcStride) {
+        UBYTE *Dst = Row;
+        UBYTE Carry = 0, CarryMask = 0;
+        for(UWORD u = 0; u < MemWidth; u += 8) {
+            UBYTE Byte = Src[u / 8];
+            if(Transparent && !Byte && !CarryMask) {    //nothing to draw
+                Dst += 4;
+                continue;
+            }
+            const UBYTE *Pixels = Paint_GlyphPixels[Byte];
+            UBYTE Masks[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+            if(Transparent)
+                memcpy(Masks, Paint_GlyphMasks[Byte], 4);
+            UWORD Left = MemWidth - u;
+            if(Left >= 8 && !Odd && !Transparent) {     //8 pixels at once
+                memcpy(Dst, Pixels, 4);
+                Dst += 4;
+                continue;
+            }
+            if(Left < 8) {                              //past the glyph
+                for(UBYTE k = 0; k < 4; k++) {
+                    if(2 * k >= Left)
+                        Masks[k] = 0;
+                    else if(2 * k + 1 == Left)
+                        Masks[k] &= 0xF0;
+                }
+            }
+            for(UBYTE k = 0; k < 4; k++, Dst++) {
+                UBYTE Data = Pixels[k], Mask = Masks[k];
+                if(Odd) {       //half a byte to the right
+                    UBYTE Next = Data & 0x0F, NextMask = Mask & 0x0F;
+                    Data = (Carry << 4) | (Data >> 4);
+                    Mask = (CarryMask << 4) | (Mask >> 4);
+                    Carry = Next;
+                    CarryMask = NextMask;
+                }
+                if(Mask)
+                    *Dst = (*Dst & ~Mask) | (Data & Mask);
+            }
+        }
+        if(Odd && CarryMask) {
+            UBYTE *Last = Row + (MemWidth + 1) / 2;
+            *Last = (*Last & ~(CarryMask << 4)) | ((Carry << 4) & (CarryMask << 4));
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+function: Fill what Paint_DrawPoint(X, Y, Color, Dot_Pixel, DOT_FILL_AROUND)
+          draws for every X0 <= X <= X1, Y0 <= Y <= Y1
+parameter:
+******************************************************************************/
+static void Paint_FillDots(int X0, int Y0, int X1, int Y1, UWORD Color, DOT_PIXEL Dot_Pixel)
+{
+    if(X0 > X1 || Y0 > Y1)
+        return;
+    Paint_FillRect(X0 - Dot_Pixel, Y0 - Dot_Pixel, X1 + Dot_Pixel - 1, Y1 + Dot_Pixel - 1, Color);
+}
+
+enum {
+    PAINT_OP_CLEAR,
+    PAINT_OP_CLEAR_WINDOWS,
+    PAINT_OP_POINT,
+    PAINT_OP_LINE,
+    PAINT_OP_RECTANGLE,
+    PAINT_OP_CIRCLE,
+    PAINT_OP_CHAR,
+    PAINT_OP_STRING_CN,
+    PAINT_OP_BITMAP,
+};
+
+/******************************************************************************
+function: Record a drawing call in the display list
+parameter:
+    Kind    :   PAINT_OP_*
+    X0, Y0  :   Top left of the canvas area it may touch
+    X1, Y1  :   Bottom right (may lie off the canvas)
+return:     The new entry to fill in, or NULL if the list is full
+******************************************************************************/
+static PAINT_OP *Paint_Record(UBYTE Kind, int X0, int Y0, int X1, int Y1)
+{
+    PAINT_LIST *List = Paint_List;
+    if(List->Count >= List->Size) {
+        List->Overflow = 1;
+        return NULL;
+    }
+    PAINT_OP *Op = &List->Ops[List->Count++];
+    memset(Op, 0, sizeof(*Op));
+    Op->Kind = Kind;
+    Op->Rotate = Paint.Rotate;
+    Op->Mirror = Paint.Mirror;
+
+    //The memory rows behind the area, as Paint_SetPixel() maps them
+    int Last = Paint.HeightMemory - 1;
+    int R0, R1;
+    switch(Paint.Rotate) {
+    case 90:
+        R0 = X0;
+        R1 = X1;
+        break;
+    case 180:
+        R0 = Last - Y1;
+        R1 = Last - Y0;
+        break;
+    case 270:
+        R0 = Last - X1;
+        R1 = Last - X0;
+        break;
+    default:
+        R0 = Y0;
+        R1 = Y1;
+        break;
+    }
+    if(Paint.Mirror & MIRROR_VERTICAL) {
+        int T = R0;
+        R0 = Last - R1;
+        R1 = Last - T;
+    }
+    Op->Row0 = (R0 < 0)? 0 : (R0 > Last)? Last + 1 : R0;
+    Op->Row1 = (R1 < 0)? 0 : (R1 > Last)? Last : R1;
+    if(R1 < 0)
+        Op->Row0 = 1;   //never in a band
+    return Op;
+}
+
+/******************************************************************************
+function: Start recording drawing calls into a display list
+parameter:
+    List     :   The list
+    Ops      :   Room for Size calls
+    Text     :   Room for TextSize bytes of Paint_DrawString_CN() text
+                 (NULL, 0 if not used)
+******************************************************************************/
+void Paint_ListBegin(PAINT_LIST *List, PAINT_OP *Ops, UWORD Size, char *Text, UWORD TextSize)
+{
+    List->Ops = Ops;
+    List->Size = Size;
+    List->Count = 0;
+    List->Text = Text;
+    List->TextSize = TextSize;
+    List->TextUsed = 0;
+    List->Overflow = 0;
+    Paint_List = List;
+}
+
+/******************************************************************************
+function: Stop recording; drawing calls draw into Paint.Image again
+parameter:
+******************************************************************************/
+void Paint_ListEnd(void)
+{
+    Paint_List = NULL;
+}
+
+/******************************************************************************
+function: Record a line or rectangle call
+parameter:
+    as Paint_DrawLine()
+******************************************************************************/
+static void Paint_RecordBox(UBYTE Kind, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                            UWORD Color, DOT_PIXEL Line_width, UBYTE Style)
+{
+    int X0 = (Xstart < Xend)? Xstart : Xend, X1 = (Xstart < Xend)? Xend : Xstart;
+    int Y0 = (Ystart < Yend)? Ystart : Yend, Y1 = (Ystart < Yend)? Yend : Ystart;
+    PAINT_OP *Op = Paint_Record(Kind, X0 - Line_width, Y0 - Line_width,
+                                X1 + Line_width, Y1 + Line_width);
+    if (Op) {
+        UWORD A[5] = {Xstart, Ystart, Xend, Yend, Color};
+        memcpy(Op->A, A, sizeof(A));
+        Op->B[0] = Line_width;
+        Op->B[1] = Style;
+    }
+}
+
+/******************************************************************************
+function: Draw one recorded call into the current band
+parameter:
+******************************************************************************/
+static void Paint_Replay(const PAINT_LIST *List, const PAINT_OP *Op)
+{
+    const UWORD *A = Op->A;
+    Paint.Mirror = Op->Mirror;
+    Paint_SetRotate(Op->Rotate);
+    switch(Op->Kind) {
+    case PAINT_OP_CLEAR:
+        Paint_Clear(A[0]);
+        break;
+    case PAINT_OP_CLEAR_WINDOWS:
+        Paint_ClearWindows(A[0], A[1], A[2], A[3], A[4]);
+        break;
+    case PAINT_OP_POINT:
+        Paint_DrawPoint(A[0], A[1], A[2], (DOT_PIXEL)Op->B[0], (DOT_STYLE)Op->B[1]);
+        break;
+    case PAINT_OP_LINE:
+        Paint_DrawLine(A[0], A[1], A[2], A[3], A[4], (DOT_PIXEL)Op->B[0], (LINE_STYLE)Op->B[1]);
+        break;
+    case PAINT_OP_RECTANGLE:
+        Paint_DrawRectangle(A[0], A[1], A[2], A[3], A[4], (DOT_PIXEL)Op->B[0], (DRAW_FILL)Op->B[1]);
+        break;
+    case PAINT_OP_CIRCLE:
+        Paint_DrawCircle(A[0], A[1], A[2], A[3], (DOT_PIXEL)Op->B[0], (DRAW_FILL)Op->B[1]);
+        break;
+    case PAINT_OP_CHAR:
+        Paint_DrawChar(A[0], A[1], (char)Op->B[0], (sFONT *)Op->Data, A[2], A[3]);
+        break;
+    case PAINT_OP_STRING_CN:
+        Paint_DrawString_CN(A[0], A[1], List->Text + A[4], (cFONT *)Op->Data, A[2], A[3]);
+        break;
+    case PAINT_OP_BITMAP:
+        Paint_DrawBitMap((const unsigned char *)Op->Data);
+        break;
+    }
+}
+
+/******************************************************************************
+function: Rasterize a band of the display list
+parameter:
+    Rows    :   Count rows of Paint.WidthByte bytes
+    Y       :   First memory row of the band
+    Count   :   Rows in the band
+    Ctx     :   The PAINT_LIST
+return:     0, or -1 if the list overflowed while recording
+info:
+    Calls that cannot touch the band are skipped; the others are drawn
+    whole, with Paint_SetPixel() dropping what falls outside. Without a
+    Paint_Clear() first, the band starts out in Paint.Color.
+******************************************************************************/
+int Paint_ListRows(UBYTE *Rows, UWORD Y, UWORD Count, void *Ctx)
+{
+    PAINT_LIST *List = (PAINT_LIST *)Ctx;
+    if(List->Overflow)
+        return -1;
+
+    PAINT Saved = Paint;
+    PAINT_LIST *Recording = Paint_List;
+    Paint_List = NULL;
+    Paint.Image = Rows;
+    Paint.BandY = Y;
+    Paint.BandRows = Count;
+    Paint_Resolve();
+    if(List->Count == 0 || List->Ops[0].Kind != PAINT_OP_CLEAR)
+        Paint_Clear(Paint.Color);
+
+    UWORD Last = Y + Count - 1;
+    for(UWORD i = 0; i < List->Count; i++) {
+        const PAINT_OP *Op = &List->Ops[i];
+        if(Op->Row0 <= Last && Op->Row1 >= Y)
+            Paint_Replay(List, Op);
+    }
+
+    Paint = Saved;
+    Paint_List = Recording;
+    Paint_Resolve();
+    return 0;
+}
+
 /******************************************************************************
 function: Create Image
 parameter:
@@ -109,6 +898,10 @@ void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD
    
     Paint.Rotate = Rotate;
     Paint.Mirror = MIRROR_NONE;
+    Paint.BandY = 0;
+    Paint.BandRows = Height;
+    Paint.DirtyCount = 0;
+    Paint.DirtyLast = 0;
     
     if(Rotate == ROTATE_0 || Rotate == ROTATE_180) {
         Paint.Width = Width;
@@ -117,6 +910,7 @@ void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD
         Paint.Width = Height;
         Paint.Height = Width;
     }
+    Paint_Resolve();
 }
 
 /******************************************************************************
@@ -127,6 +921,7 @@ parameter:
 void Paint_SelectImage(UBYTE *image)
 {
     Paint.Image = image;
+    Paint_ResetDirty();
 }
 
 /******************************************************************************
@@ -151,6 +946,7 @@ void Paint_SetRotate(UWORD Rotate)
             }
         }
         Paint.Rotate = Rotate;
+        Paint_Resolve();
     } else {
         Debug("rotate = 0, 90, 180, 270\r\n");
     }
@@ -177,6 +973,7 @@ void Paint_SetMirroring(UBYTE mirror)
         mirror == MIRROR_VERTICAL || mirror == MIRROR_ORIGIN) {
         Debug("mirror image x:%s, y:%s\r\n",(mirror & 0x01)? "mirror":"none", ((mirror >> 1) & 0x01)? "mirror":"none");
         Paint.Mirror = mirror;
+        Paint_Resolve();
     } else {
         Debug("mirror should be MIRROR_NONE, MIRROR_HORIZONTAL, \
         MIRROR_VERTICAL or MIRROR_ORIGIN\r\n");
@@ -198,6 +995,7 @@ void Paint_SetScale(UBYTE scale)
         Debug("Set Scale Input parameter error\r\n");
         Debug("Scale Only support: 2 4 7\r\n");
     }
+    Paint_Resolve();
 }
 /******************************************************************************
 function: Draw Pixels
@@ -206,77 +1004,28 @@ parameter:
     Ypoint : At point Y
     Color  : Painted colors
 ******************************************************************************/
-void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+//Paint_SetPixel() outside Paint_Hit*: kept out of line so that a pixel
+//inside costs no more than the compares and the writer call
+static void __attribute__((noinline)) Paint_SetPixelMiss(UWORD Xpoint, UWORD Ypoint, UWORD Color)
 {
-    if(Xpoint > Paint.Width || Ypoint > Paint.Height){
-        Debug("Exceeding display boundaries\r\n");
-        return;
-    }      
-    UWORD X, Y;
-    switch(Paint.Rotate) {
-    case 0:
-        X = Xpoint;
-        Y = Ypoint;  
-        break;
-    case 90:
-        X = Paint.WidthMemory - Ypoint - 1;
-        Y = Xpoint;
-        break;
-    case 180:
-        X = Paint.WidthMemory - Xpoint - 1;
-        Y = Paint.HeightMemory - Ypoint - 1;
-        break;
-    case 270:
-        X = Ypoint;
-        Y = Paint.HeightMemory - Xpoint - 1;
-        break;
-    default:
-        return;
-    }
-    
-    switch(Paint.Mirror) {
-    case MIRROR_NONE:
-        break;
-    case MIRROR_HORIZONTAL:
-        X = Paint.WidthMemory - X - 1;
-        break;
-    case MIRROR_VERTICAL:
-        Y = Paint.HeightMemory - Y - 1;
-        break;
-    case MIRROR_ORIGIN:
-        X = Paint.WidthMemory - X - 1;
-        Y = Paint.HeightMemory - Y - 1;
-        break;
-    default:
+    if(Xpoint < Paint_ClipX0 || Xpoint >= Paint_ClipX1 ||
+       Ypoint < Paint_ClipY0 || Ypoint >= Paint_ClipY1) {
+        if(Xpoint >= Paint.Width || Ypoint >= Paint.Height) {
+            Debug("Exceeding display boundaries\r\n");
+        }
         return;
     }
+    Paint_Dirty(Xpoint, Ypoint, Xpoint + 1, Ypoint + 1);
+    Paint_Writer(Xpoint, Ypoint, Color);
+}
 
-    if(X > Paint.WidthMemory || Y > Paint.HeightMemory){
-        Debug("Exceeding display boundaries\r\n");
-        return;
-    }
-    
-    if(Paint.Scale == 2){
-        UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
-        UBYTE Rdata = Paint.Image[Addr];
-        if(Color == BLACK)
-            Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
-        else
-            Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
-    }else if(Paint.Scale == 4){
-        UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
-        Color = Color % 4;//Guaranteed color scale is 4  --- 0~3
-        UBYTE Rdata = Paint.Image[Addr];
-        
-        Rdata = Rdata & (~(0xC0 >> ((X % 4)*2)));//Clear first, then set value
-        Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4)*2));
-    }else if(Paint.Scale == 7){
-		UDOUBLE Addr = X / 2  + Y * Paint.WidthByte;
-		UBYTE Rdata = Paint.Image[Addr];
-		Rdata = Rdata & (~(0xF0 >> ((X % 2)*4)));//Clear first, then set value
-		Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2)*4));
-		// printf("Add =  %d ,data = %d\r\n",Addr,Rdata);
-	}
+void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    if(Xpoint >= Paint_HitX0 && Xpoint < Paint_HitX1 &&
+       Ypoint >= Paint_HitY0 && Ypoint < Paint_HitY1)
+        Paint_Writer(Xpoint, Ypoint, Color);
+    else
+        Paint_SetPixelMiss(Xpoint, Ypoint, Color);
 }
 
 /******************************************************************************
@@ -285,21 +1034,19 @@ parameter:
     Color : Painted colors
 ******************************************************************************/
 void Paint_Clear(UWORD Color)
-{	
+{
+	if(Paint_List) {
+		PAINT_OP *Op = Paint_Record(PAINT_OP_CLEAR, 0, 0, Paint.Width - 1, Paint.Height - 1);
+		if(Op)
+			Op->A[0] = Color;
+		return;
+	}
+	Paint_Dirty(0, 0, Paint.Width, Paint.Height);
+	UDOUBLE Bytes = (UDOUBLE)Paint.BandRows * Paint.WidthByte;
 	if(Paint.Scale == 2 || Paint.Scale == 4){
-		for (UWORD Y = 0; Y < Paint.HeightByte; Y++) {
-			for (UWORD X = 0; X < Paint.WidthByte; X++ ) {//8 pixel =  1 byte
-				UDOUBLE Addr = X + Y*Paint.WidthByte;
-				Paint.Image[Addr] = Color;
-			}
-		}		
+		Paint_FillBytes(Paint.Image, Bytes, Color);//8 pixel =  1 byte
 	}else if(Paint.Scale == 7){
-		for (UWORD Y = 0; Y < Paint.HeightByte; Y++) {
-			for (UWORD X = 0; X < Paint.WidthByte; X++ ) {
-				UDOUBLE Addr = X + Y*Paint.WidthByte;
-				Paint.Image[Addr] = (Color<<4)|Color;
-			}
-		}		
+		Paint_FillBytes(Paint.Image, Bytes, (Color<<4)|Color);
 	}
 
 }
@@ -315,12 +1062,16 @@ parameter:
 ******************************************************************************/
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
 {
-    UWORD X, Y;
-    for (Y = Ystart; Y < Yend; Y++) {
-        for (X = Xstart; X < Xend; X++) {//8 pixel =  1 byte
-            Paint_SetPixel(X, Y, Color);
+    if (Paint_List) {
+        PAINT_OP *Op = Paint_Record(PAINT_OP_CLEAR_WINDOWS, Xstart, Ystart, Xend, Yend);
+        if (Op) {
+            UWORD A[5] = {Xstart, Ystart, Xend, Yend, Color};
+            memcpy(Op->A, A, sizeof(A));
         }
+        return;
     }
+    Paint_Dirty(Xstart, Ystart, Xend, Yend);
+    Paint_FillRect(Xstart, Ystart, Xend, Yend, Color);
 }
 
 /******************************************************************************
@@ -339,23 +1090,27 @@ void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
         Debug("Paint_DrawPoint Input exceeds the normal display range\r\n");
         return;
     }
-
-    int16_t XDir_Num , YDir_Num;
-    if (Dot_Style == DOT_FILL_AROUND) {
-        for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++) {
-            for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++) {
-                if(Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
-                    break;
-                // printf("x = %d, y = %d\r\n", Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel);
-                Paint_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
-            }
+    if (Paint_List) {
+        PAINT_OP *Op = Paint_Record(PAINT_OP_POINT, Xpoint - Dot_Pixel, Ypoint - Dot_Pixel,
+                                    Xpoint + Dot_Pixel, Ypoint + Dot_Pixel);
+        if (Op) {
+            UWORD A[3] = {Xpoint, Ypoint, Color};
+            memcpy(Op->A, A, sizeof(A));
+            Op->B[0] = Dot_Pixel;
+            Op->B[1] = Dot_Style;
         }
+        return;
+    }
+
+    Paint_DirtyDots(Xpoint, Ypoint, Xpoint, Ypoint, Dot_Pixel);
+    //The dot is the square up and left of the point (around it if
+    //DOT_FILL_AROUND), clipped
+    if (Dot_Pixel == DOT_PIXEL_1X1) {
+        Paint_PutPixel(Xpoint - 1, Ypoint - 1, Color);
+    } else if (Dot_Style == DOT_FILL_AROUND) {
+        Paint_FillDots(Xpoint, Ypoint, Xpoint, Ypoint, Color, Dot_Pixel);
     } else {
-        for (XDir_Num = 0; XDir_Num <  Dot_Pixel; XDir_Num++) {
-            for (YDir_Num = 0; YDir_Num <  Dot_Pixel; YDir_Num++) {
-                Paint_SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
-            }
-        }
+        Paint_FillRect(Xpoint - 1, Ypoint - 1, Xpoint + Dot_Pixel - 1, Ypoint + Dot_Pixel - 1, Color);
     }
 }
 
@@ -378,6 +1133,19 @@ void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
         Debug("Paint_DrawLine Input exceeds the normal display range\r\n");
         return;
     }
+    if (Paint_List) {
+        Paint_RecordBox(PAINT_OP_LINE, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Style);
+        return;
+    }
+    Paint_DirtyDots(Xstart < Xend? Xstart : Xend, Ystart < Yend? Ystart : Yend,
+                    Xstart < Xend? Xend : Xstart, Ystart < Yend? Yend : Ystart, Line_width);
+    //Solid horizontal and vertical lines are one rectangle of dots
+    if (Line_Style == LINE_STYLE_SOLID && (Xstart == Xend || Ystart == Yend)) {
+        Paint_FillDots(Xstart < Xend? Xstart : Xend, Ystart < Yend? Ystart : Yend,
+                       Xstart < Xend? Xend : Xstart, Ystart < Yend? Yend : Ystart,
+                       Color, Line_width);
+        return;
+    }
 
     UWORD Xpoint = Xstart;
     UWORD Ypoint = Ystart;
@@ -436,12 +1204,17 @@ void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
         Debug("Input exceeds the normal display range\r\n");
         return;
     }
+    if (Paint_List) {
+        Paint_RecordBox(PAINT_OP_RECTANGLE, Xstart, Ystart, Xend, Yend, Color, Line_width, Draw_Fill);
+        return;
+    }
+    Paint_DirtyDots(Xstart < Xend? Xstart : Xend, Ystart < Yend? Ystart : Yend,
+                    Xstart < Xend? Xend : Xstart, Ystart < Yend? Yend : Ystart, Line_width);
 
     if (Draw_Fill) {
-        UWORD Ypoint;
-        for(Ypoint = Ystart; Ypoint < Yend; Ypoint++) {
-            Paint_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color , Line_width, LINE_STYLE_SOLID);
-        }
+        //A solid line of Line_width dots for each Ypoint < Yend
+        Paint_FillDots(Xstart < Xend? Xstart : Xend, Ystart,
+                       Xstart < Xend? Xend : Xstart, (int)Yend - 1, Color, Line_width);
     } else {
         Paint_DrawLine(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
         Paint_DrawLine(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
@@ -468,6 +1241,20 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
         Debug("Paint_DrawCircle Input exceeds the normal display range\r\n");
         return;
     }
+    if (Paint_List) {
+        int R = Radius + Line_width;
+        PAINT_OP *Op = Paint_Record(PAINT_OP_CIRCLE, X_Center - R, Y_Center - R,
+                                    X_Center + R, Y_Center + R);
+        if (Op) {
+            UWORD A[4] = {X_Center, Y_Center, Radius, Color};
+            memcpy(Op->A, A, sizeof(A));
+            Op->B[0] = Line_width;
+            Op->B[1] = Draw_Fill;
+        }
+        return;
+    }
+    Paint_DirtyDots(X_Center - Radius, Y_Center - Radius, X_Center + Radius, Y_Center + Radius,
+                    Line_width);
 
     //Draw a circle from(0, R) as a starting point
     int16_t XCurrent, YCurrent;
@@ -477,22 +1264,19 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
     //Cumulative error,judge the next point of the logo
     int16_t Esp = 3 - (Radius << 1 );
 
-    int16_t sCountY;
     if (Draw_Fill == DRAW_FILL_FULL) {
+        //Row spans, each dot one up and left of its point: rows +-XCurrent
+        //reach out to YCurrent, and rows +-YCurrent, before it steps in, to
+        //XCurrent
+        int X0 = X_Center - 1, Y0 = Y_Center - 1;
         while (XCurrent <= YCurrent ) { //Realistic circles
-            for (sCountY = XCurrent; sCountY <= YCurrent; sCountY ++ ) {
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//1
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//2
-                Paint_DrawPoint(X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//3
-                Paint_DrawPoint(X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//4
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//5
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//6
-                Paint_DrawPoint(X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//7
-                Paint_DrawPoint(X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-            }
+            Paint_FillRect(X0 - YCurrent, Y0 + XCurrent, X0 + YCurrent + 1, Y0 + XCurrent + 1, Color);
+            Paint_FillRect(X0 - YCurrent, Y0 - XCurrent, X0 + YCurrent + 1, Y0 - XCurrent + 1, Color);
             if (Esp < 0 )
                 Esp += 4 * XCurrent + 6;
             else {
+                Paint_FillRect(X0 - XCurrent, Y0 + YCurrent, X0 + XCurrent + 1, Y0 + YCurrent + 1, Color);
+                Paint_FillRect(X0 - XCurrent, Y0 - YCurrent, X0 + XCurrent + 1, Y0 - YCurrent + 1, Color);
                 Esp += 10 + 4 * (XCurrent - YCurrent );
                 YCurrent --;
             }
@@ -539,9 +1323,26 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
         Debug("Paint_DrawChar Input exceeds the normal display range\r\n");
         return;
     }
+    if (Paint_List) {
+        PAINT_OP *Op = Paint_Record(PAINT_OP_CHAR, Xpoint, Ypoint,
+                                    Xpoint + Font->Width - 1, Ypoint + Font->Height - 1);
+        if (Op) {
+            UWORD A[4] = {Xpoint, Ypoint, Color_Foreground, Color_Background};
+            memcpy(Op->A, A, sizeof(A));
+            Op->B[0] = (UBYTE)Acsii_Char;
+            Op->Data = Font;
+        }
+        return;
+    }
 
+    Paint_Dirty(Xpoint, Ypoint, Xpoint + Font->Width, Ypoint + Font->Height);
     uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
     const unsigned char *ptr = &Font->table[Char_Offset];
+    if (Paint_BlitGlyph(Xpoint, Ypoint, ptr, Font->Width, Font->Height,
+                        Color_Foreground, Color_Background) == 0)
+        return;
+    PAINT_WRITER Put = Paint_Inside(Xpoint, Ypoint, Xpoint + Font->Width,
+                                    Ypoint + Font->Height)? Paint_Writer : Paint_PutPixel;
 
     for (Page = 0; Page < Font->Height; Page ++ ) {
         for (Column = 0; Column < Font->Width; Column ++ ) {
@@ -549,14 +1350,14 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
             //To determine whether the font background color and screen background color is consistent
             if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
                 if (*ptr & (0x80 >> (Column % 8)))
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                    Put(Xpoint + Column, Ypoint + Page, Color_Foreground);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             } else {
                 if (*ptr & (0x80 >> (Column % 8))) {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                    Put(Xpoint + Column, Ypoint + Page, Color_Foreground);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                 } else {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
+                    Put(Xpoint + Column, Ypoint + Page, Color_Background);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                 }
             }
@@ -613,6 +1414,83 @@ void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString,
 }
 
 
+/******************************************************************************
+function: Find the entry for a character in a GB2312 font
+parameter:
+    font : Font to look in
+    Code : Lead byte << 8 | second byte; ASCII lead byte << 8
+return:     The first entry with that code, or NULL if the font has none.
+            Fonts listed in FontCN_Index (lib/Fonts/fontCN_index.c, see
+            tools/cn_index.c) are searched by halves; a font that is not, a
+            table that has changed size since, or a code the index does not
+            hold, is scanned in order as before.
+******************************************************************************/
+static UWORD Paint_CodeCN(const CH_CN *Ch)
+{
+    UBYTE Lead = (UBYTE)Ch->index[0];
+    return (Lead <= 0x7F)? Lead << 8 : Lead << 8 | (UBYTE)Ch->index[1];
+}
+
+static const CH_CN *Paint_FindCN(const cFONT *font, UWORD Code)
+{
+    for(UWORD k = 0; k < FontCN_IndexCount; k++) {
+        const cFONT_INDEX *Index = &FontCN_Index[k];
+        if(Index->font != font)
+            continue;
+        if(Index->table_size != font->size)
+            break;
+        UWORD Lo = 0, Hi = Index->size;
+        while(Lo < Hi) {
+            UWORD Mid = (Lo + Hi) / 2;
+            if(Index->Code[Mid] < Code)
+                Lo = Mid + 1;
+            else
+                Hi = Mid;
+        }
+        if(Lo < Index->size && Index->Code[Lo] == Code && Index->Entry[Lo] < font->size &&
+           Paint_CodeCN(&font->table[Index->Entry[Lo]]) == Code)
+            return &font->table[Index->Entry[Lo]];
+        break;
+    }
+    for(UWORD Num = 0; Num < font->size; Num++)
+        if(Paint_CodeCN(&font->table[Num]) == Code)
+            return &font->table[Num];
+    return NULL;
+}
+
+/******************************************************************************
+function: Draw one GB2312 font entry, font->Width x font->Height
+parameter:
+    x, y             : Top left
+    Matrix           : The entry's bits, rows padded to whole bytes
+    font             : Font of the entry
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+******************************************************************************/
+static void Paint_DrawGlyphCN(int x, int y, const UBYTE *Matrix, const cFONT *font,
+                              UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_Dirty(x, y, x + font->Width, y + font->Height);
+    if (Paint_BlitGlyph(x, y, Matrix, font->Width, font->Height,
+                        Color_Foreground, Color_Background) == 0)
+        return;
+    PAINT_WRITER Put = Paint_Inside(x, y, x + font->Width, y + font->Height)?
+                       Paint_Writer : Paint_PutPixel;
+    const UBYTE *ptr = Matrix;
+    for (int j = 0; j < font->Height; j++) {
+        for (int i = 0; i < font->Width; i++) {
+            if (*ptr & (0x80 >> (i % 8)))
+                Put(x + i, y + j, Color_Foreground);
+            else if (FONT_BACKGROUND != Color_Background)
+                Put(x + i, y + j, Color_Background);
+            if (i % 8 == 7)
+                ptr++;
+        }
+        if (font->Width % 8 != 0)
+            ptr++;
+    }
+}
+
 /******************************************************************************
 function: Display the string
 parameter:
@@ -629,83 +1507,47 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT
 {
     const char* p_text = pString;
     int x = Xstart, y = Ystart;
-    int i, j,Num;
+
+    if (Paint_List) {
+        //Up to the right edge: the string does not wrap
+        size_t Len = strlen(pString) + 1;
+        PAINT_LIST *List = Paint_List;
+        if (List->TextUsed + Len > List->TextSize) {
+            List->Overflow = 1;
+            return;
+        }
+        PAINT_OP *Op = Paint_Record(PAINT_OP_STRING_CN, Xstart, Ystart,
+                                    Paint.Width - 1, Ystart + font->Height - 1);
+        if (Op) {
+            UWORD A[5] = {Xstart, Ystart, Color_Foreground, Color_Background, List->TextUsed};
+            memcpy(Op->A, A, sizeof(A));
+            Op->Data = font;
+            memcpy(List->Text + List->TextUsed, pString, Len);
+            List->TextUsed += Len;
+        }
+        return;
+    }
 
     /* Send the string character by character on EPD */
     while (*p_text != 0) {
-        if(*p_text <= 0x7F) {  //ASCII < 126
-            for(Num = 0; Num < font->size; Num++) {
-                if(*p_text== font->table[Num].index[0]) {
-                    const char* ptr = &font->table[Num].matrix[0];
-
-                    for (j = 0; j < font->Height; j++) {
-                        for (i = 0; i < font->Width; i++) {
-                            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            } else {
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                } else {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            }
-                            if (i % 8 == 7) {
-                                ptr++;
-                            }
-                        }
-                        if (font->Width % 8 != 0) {
-                            ptr++;
-                        }
-                    }
-                    break;
-                }
-            }
-            /* Point on the next character */
-            p_text += 1;
-            /* Decrement the column position by 16 */
-            x += font->ASCII_Width;
+        UBYTE Lead = (UBYTE)*p_text;
+        UWORD Code, Advance;
+        if(Lead <= 0x7F) {  //ASCII < 126
+            Code = Lead << 8;
+            Advance = font->ASCII_Width;
         } else {        //Chinese
-            for(Num = 0; Num < font->size; Num++) {
-                if((*p_text== font->table[Num].index[0]) && (*(p_text+1) == font->table[Num].index[1])) {
-                    const char* ptr = &font->table[Num].matrix[0];
-
-                    for (j = 0; j < font->Height; j++) {
-                        for (i = 0; i < font->Width; i++) {
-                            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            } else {
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                } else {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            }
-                            if (i % 8 == 7) {
-                                ptr++;
-                            }
-                        }
-                        if (font->Width % 8 != 0) {
-                            ptr++;
-                        }
-                    }
-                    break;
-                }
-            }
-            /* Point on the next character */
-            p_text += 2;
-            /* Decrement the column position by 16 */
-            x += font->Width;
+            if(p_text[1] == 0)
+                break;
+            Code = Lead << 8 | (UBYTE)p_text[1];
+            Advance = font->Width;
         }
+        const CH_CN *Ch = Paint_FindCN(font, Code);
+        if(Ch)
+            Paint_DrawGlyphCN(x, y, (const UBYTE *)Ch->matrix, font,
+                              Color_Foreground, Color_Background);
+        /* Point on the next character */
+        p_text += (Lead <= 0x7F)? 1 : 2;
+        x += Advance;
     }
 }
 
@@ -792,10 +1634,43 @@ void Paint_DrawBitMap(const unsigned char* image_buffer)
     UWORD x, y;
     UDOUBLE Addr = 0;
 
-    for (y = 0; y < Paint.HeightByte; y++) {
+    if (Paint_List) {
+        PAINT_OP *Op = Paint_Record(PAINT_OP_BITMAP, 0, 0, Paint.Width - 1, Paint.Height - 1);
+        if (Op)
+            Op->Data = image_buffer;
+        return;
+    }
+    Paint_Dirty(0, 0, Paint.Width, Paint.Height);
+    for (y = 0; y < Paint.BandRows; y++) {
         for (x = 0; x < Paint.WidthByte; x++) {//8 pixel =  1 byte
             Addr = x + y * Paint.WidthByte;
-            Paint.Image[Addr] = (unsigned char)image_buffer[Addr];
+            Paint.Image[Addr] = (unsigned char)image_buffer[Addr + (UDOUBLE)Paint.BandY * Paint.WidthByte];
         }
     }
 }
+
+/******************************************************************************
+function: The dirty rectangles of Paint.Image
+parameter:
+    Rects : Set to the first of them
+return:     How many there are (up to PAINT_DIRTY_MAX)
+info:
+    Memory pixels [X0, X1) x [Y0, Y1), so row Y of the image starts at
+    Paint.Image + Y * Paint.WidthByte whatever the rotation and mirror.
+******************************************************************************/
+UBYTE Paint_GetDirty(const PAINT_RECT **Rects)
+{
+    *Rects = Paint.Dirty;
+    return Paint.DirtyCount;
+}
+
+/******************************************************************************
+function: Forget the dirty rectangles, once what they cover has been used
+parameter:
+******************************************************************************/
+void Paint_ResetDirty(void)
+{
+    Paint.DirtyCount = 0;
+    Paint.DirtyLast = 0;
+    Paint_HitX0 = Paint_HitX1 = Paint_HitY0 = Paint_HitY1 = 0;
+}
@@ -73,6 +73,23 @@
 #include "DEV_Config.h"
 #include "../Fonts/fonts.h"
 
+/**
+ * Dirty rectangles: what the drawing calls since Paint_NewImage(),
+ * Paint_SelectImage() or Paint_ResetDirty() may have changed in Paint.Image
+ * (the calls recorded in a display list change nothing), as memory pixels
+ * [X0, X1) x [Y0, Y1) (Paint.Image row Y, whatever the rotation and mirror).
+ * Touching or overlapping areas are merged as they are drawn; when there are
+ * PAINT_DIRTY_MAX apart, a new one is merged into whichever grows least.
+**/
+#ifndef PAINT_DIRTY_MAX
+#define PAINT_DIRTY_MAX 8
+#endif
+
+typedef struct {
+    UWORD X0, Y0;
+    UWORD X1, Y1;
+} PAINT_RECT;
+
 /**
  * Image attributes
 **/
@@ -88,6 +105,11 @@ typedef struct {
     UWORD WidthByte;
     UWORD HeightByte;
     UWORD Scale;
+    UWORD BandY;        //Image holds memory rows BandY..BandY+BandRows-1
+    UWORD BandRows;
+    PAINT_RECT Dirty[PAINT_DIRTY_MAX];  //see Paint_GetDirty()
+    UBYTE DirtyCount;
+    UBYTE DirtyLast;    //the entry that grew last
 } PAINT;
 extern PAINT Paint;
 
@@ -208,6 +230,43 @@ void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
 //pic
 void Paint_DrawBitMap(const unsigned char* image_buffer);
 
+//Dirty rectangles
+UBYTE Paint_GetDirty(const PAINT_RECT **Rects);
+void Paint_ResetDirty(void);
+
+/**
+ * Display list: between Paint_ListBegin() and Paint_ListEnd() the drawing
+ * calls above are recorded instead of drawn (Paint.Image is not touched),
+ * and Paint_ListRows() rasterizes them a band of rows at a time, in call
+ * order, so later primitives cover earlier ones as on a full canvas.
+**/
+typedef struct {
+    UBYTE Kind;         //PAINT_OP_*
+    UBYTE Mirror;       //canvas state at the call
+    UWORD Rotate;
+    UWORD Row0, Row1;   //memory rows it may touch
+    UWORD A[5];         //coordinates and colours as passed
+    UBYTE B[2];         //dot size, line style, fill, or the character
+    const void *Data;   //font or bitmap
+} PAINT_OP;
+
+typedef struct {
+    PAINT_OP *Ops;
+    UWORD Size;
+    UWORD Count;
+    char *Text;         //copies of Paint_DrawString_CN() strings
+    UWORD TextSize;
+    UWORD TextUsed;
+    UBYTE Overflow;     //a call did not fit: the list cannot be rendered
+} PAINT_LIST;
+
+void Paint_ListBegin(PAINT_LIST *List, PAINT_OP *Ops, UWORD Size, char *Text, UWORD TextSize);
+void Paint_ListEnd(void);
+//Rasterize memory rows Y..Y+Count-1 of the canvas set up by Paint_NewImage()
+//and Paint_SetScale() into Rows (Paint.WidthByte per row). Ctx is the
+//PAINT_LIST; nonzero if it overflowed. Matches EPD_7IN3F_RowFn.
+int Paint_ListRows(UBYTE *Rows, UWORD Y, UWORD Count, void *Ctx);
+
 
 #endif
 
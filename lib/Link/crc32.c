@@ -0,0 +1,24 @@
+#include "crc32.h"
+
+// Byte-wide table, built on first use (1 KB of RAM; one lookup per byte).
+static uint32_t crc32_table[256];
+static int crc32_ready = 0;
+
+static void crc32_init(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+    crc32_table[i] = c;
+  }
+  crc32_ready = 1;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+  if (!crc32_ready)
+    crc32_init();
+  crc = ~crc;
+  while (len--)
+    crc = (crc >> 8) ^ crc32_table[(crc ^ *data++) & 0xFF];
+  return ~crc;
+}
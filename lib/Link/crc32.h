@@ -0,0 +1,11 @@
+#ifndef _CRC32_H_
+#define _CRC32_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, reflected 0xEDB88320), same values as zlib's crc32():
+// start with crc = 0 and feed the data in any number of pieces.
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len);
+
+#endif
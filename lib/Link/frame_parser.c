@@ -0,0 +1,136 @@
+#include "frame_parser.h"
+
+#include <string.h>
+
+#include "link_proto.h"
+
+static const uint8_t frame_sof[4] = {0xAA, 0x55, 0xAA, 0x55};
+
+void frame_parser_init(frame_parser_t* p) {
+  memset(p, 0, sizeof(*p));
+  p->state = FRAME_ST_ACK;
+}
+
+// One byte of the ACK step. Returns 1 when it completed an ACK line.
+static int ack_byte(frame_parser_t* p, uint8_t c) {
+  if (c != '\n') {
+    if (p->line_len < sizeof(p->line) - 1)
+      p->line[p->line_len++] = (char)c;
+    return 0;
+  }
+  while (p->line_len > 0 && p->line[p->line_len - 1] == '\r')
+    p->line_len--;
+  p->line[p->line_len] = '\0';
+  p->line_len = 0;
+  return strstr(p->line, "ACK") != NULL;
+}
+
+// Hunt for the SOF in in[0..n). Returns the bytes taken; the state moves on
+// once the last marker byte is among them.
+static size_t sof_scan(frame_parser_t* p, const uint8_t* in, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    if (p->sof_idx == 0) {
+      // Noise is skipped a memchr at a time.
+      const uint8_t* hit = memchr(in + i, frame_sof[0], n - i);
+      if (!hit) {
+        p->skipped += n - i;
+        return n;
+      }
+      p->skipped += (size_t)(hit - (in + i));
+      i = (size_t)(hit - in);
+    }
+    uint8_t c = in[i++];
+    if (c == frame_sof[p->sof_idx]) {
+      if (++p->sof_idx == sizeof(frame_sof)) {
+        p->state = FRAME_ST_HEADER;
+        p->hdr_len = 0;
+        return i;
+      }
+    } else {
+      // A mismatch may itself start the next marker.
+      p->skipped += p->sof_idx + (c != frame_sof[0]);
+      p->sof_idx = (c == frame_sof[0]) ? 1 : 0;
+    }
+  }
+  return i;
+}
+
+frame_event_t frame_parser_feed(frame_parser_t* p,
+                                const uint8_t* in,
+                                size_t n,
+                                size_t* used) {
+  size_t i = 0;
+  frame_event_t ev = FRAME_EV_NONE;
+  while (i < n && ev == FRAME_EV_NONE) {
+    switch (p->state) {
+      case FRAME_ST_ACK:
+        if (ack_byte(p, in[i++])) {
+          p->state = FRAME_ST_SOF;
+          p->sof_idx = 0;
+          ev = FRAME_EV_ACK;
+        }
+        break;
+      case FRAME_ST_SOF:
+        i += sof_scan(p, in + i, n - i);
+        break;
+      case FRAME_ST_HEADER:
+        p->hdr[p->hdr_len++] = in[i++];
+        if (p->hdr_len == sizeof(p->hdr)) {
+          uint32_t h = ((uint32_t)p->hdr[0] << 24) |
+                       ((uint32_t)p->hdr[1] << 16) |
+                       ((uint32_t)p->hdr[2] << 8) | p->hdr[3];
+          p->fmt = LINK_HDR_FMT(h);
+          p->len = LINK_HDR_LEN(h);
+          p->wire_len =
+              (p->fmt & LINK_FMT_CRC) ? LINK_CHUNKED_LEN(p->len) : p->len;
+          p->state = FRAME_ST_READY;
+          ev = FRAME_EV_HEADER;
+        }
+        break;
+      case FRAME_ST_PAYLOAD: {
+        size_t k = p->wire_len - p->received;
+        if (k > n - i)
+          k = n - i;
+        int rc = payload_feed(p->dec, in + i, k);
+        i += k;
+        p->received += k;
+        if (rc != 0) {
+          p->error = rc;
+          p->state = FRAME_ST_ERROR;
+          ev = FRAME_EV_ERROR;
+        } else if (p->received == p->wire_len) {
+          if (payload_complete(p->dec)) {
+            p->state = FRAME_ST_DONE;
+            ev = FRAME_EV_DONE;
+          } else {
+            p->error = FRAME_ERR_SHORT;
+            p->state = FRAME_ST_ERROR;
+            ev = FRAME_EV_ERROR;
+          }
+        }
+        break;
+      }
+      default:
+        *used = i;
+        return FRAME_EV_NONE;
+    }
+  }
+  *used = i;
+  return ev;
+}
+
+void frame_parser_begin_payload(frame_parser_t* p, payload_decoder_t* dec) {
+  p->dec = dec;
+  p->received = 0;
+  p->state = FRAME_ST_PAYLOAD;
+  // An empty payload has nothing left to arrive.
+  if (p->wire_len == 0) {
+    p->error = payload_complete(dec) ? 0 : FRAME_ERR_SHORT;
+    p->state = p->error ? FRAME_ST_ERROR : FRAME_ST_DONE;
+  }
+}
+
+size_t frame_parser_pending(const frame_parser_t* p) {
+  return (p->state == FRAME_ST_PAYLOAD) ? p->wire_len - p->received : 0;
+}
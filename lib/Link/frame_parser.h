@@ -0,0 +1,89 @@
+#ifndef _FRAME_PARSER_H_
+#define _FRAME_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "payload.h"
+
+// ---------------------------------------------------------------------------
+// Incremental parser for the peer's side of one SENDIMG exchange:
+//
+//   ACK line -> SOF (AA 55 AA 55) -> 4-byte size header -> payload
+//
+// frame_parser_feed() takes whatever bytes have arrived, never blocks and
+// never keeps a pointer to them. It stops right after an event so the
+// caller can act before the next byte is parsed: after FRAME_EV_ACK it may
+// switch the baud rate (and drop the rest of what it read), after
+// FRAME_EV_HEADER it validates the header and sets up a payload decoder for
+// frame_parser_begin_payload(). Timeouts are the caller's business; state
+// says which step a stalled frame is stuck in.
+//
+// Lines before the ACK are skipped, as is anything (the second ACK line,
+// line noise) before the SOF, which resyncs on a partial match. Portable:
+// the firmware and the host tests in tests/ share it.
+// ---------------------------------------------------------------------------
+
+#define FRAME_LINE_SIZE 64  // ACK line, longer lines are cut short
+
+typedef enum {
+  FRAME_ST_ACK,      // collecting lines until one contains "ACK"
+  FRAME_ST_SOF,      // hunting for the start-of-frame marker
+  FRAME_ST_HEADER,   // collecting the size header
+  FRAME_ST_READY,    // header out, waiting for frame_parser_begin_payload()
+  FRAME_ST_PAYLOAD,  // feeding payload bytes to the decoder
+  FRAME_ST_DONE,
+  FRAME_ST_ERROR,
+} frame_state_t;
+
+typedef enum {
+  FRAME_EV_NONE,    // all input used, nothing to report
+  FRAME_EV_ACK,     // line holds the ACK line, CR/LF stripped
+  FRAME_EV_HEADER,  // fmt and len hold the size header
+  FRAME_EV_DONE,    // payload complete
+  FRAME_EV_ERROR,   // error says why
+} frame_event_t;
+
+// frame_parser_t.error: payload_feed() codes, plus a payload that ended
+// before it decoded to a whole frame. FRAME_ERR_LOST is set by the reader
+// when received bytes were lost before the parser saw them.
+#define FRAME_ERR_CORRUPT -1
+#define FRAME_ERR_CRC -2
+#define FRAME_ERR_SHORT -3
+#define FRAME_ERR_LOST -4
+
+typedef struct {
+  frame_state_t state;
+  char line[FRAME_LINE_SIZE];
+  size_t line_len;
+  uint8_t sof_idx;  // SOF bytes matched so far
+  uint8_t hdr[4];
+  uint8_t hdr_len;
+  uint8_t fmt;      // LINK_FMT_* bits from the header
+  size_t len;       // payload length from the header (without CRCs)
+  size_t wire_len;  // payload bytes on the wire, CRCs included
+  size_t received;  // payload bytes taken so far, CRCs included
+  payload_decoder_t* dec;
+  int error;
+  size_t skipped;  // bytes dropped while hunting for the SOF
+} frame_parser_t;
+
+void frame_parser_init(frame_parser_t* p);
+
+// Parse up to n bytes of in, stopping after the first event. *used is set to
+// the bytes taken; the rest belong to the next call. Once the payload is
+// complete, bytes after it are left unused, as is all input in
+// FRAME_ST_READY, FRAME_ST_DONE and FRAME_ST_ERROR.
+frame_event_t frame_parser_feed(frame_parser_t* p,
+                                const uint8_t* in,
+                                size_t n,
+                                size_t* used);
+
+// After FRAME_EV_HEADER: decode the payload with dec, already set up with
+// payload_init() for p->fmt and p->len.
+void frame_parser_begin_payload(frame_parser_t* p, payload_decoder_t* dec);
+
+// Payload bytes still expected on the wire (0 outside FRAME_ST_PAYLOAD).
+size_t frame_parser_pending(const frame_parser_t* p);
+
+#endif
@@ -0,0 +1,112 @@
+#include "frame_store.h"
+
+#include "crc32.h"
+#include "ff.h"
+#include "hw_config.h"
+
+#define FRAME_STORE_FILE "lastframe.bin"
+#define FRAME_STORE_MAGIC 0x31465045u  // "EPF1"
+#define FRAME_SHOWN_FILE "shown.bin"
+#define FRAME_SHOWN_MAGIC 0x31535045u  // "EPS1"
+
+typedef struct {
+  uint32_t magic;
+  uint32_t len;
+  uint32_t crc;
+} frame_store_hdr_t;
+
+static int mounted = 0;
+
+// The driver muxes MISO and CS for SPI once, on its first mount, but the
+// caller hands both back to UART1 after each access (see frame_store.h):
+// take them again every time.
+static void claim_pins(const sd_card_t* sd) {
+  gpio_put(sd->ss_gpio, 1);  // deselected while it turns back into an output
+  gpio_set_function(sd->ss_gpio, GPIO_FUNC_SIO);
+  gpio_set_function(sd->spi->miso_gpio, GPIO_FUNC_SPI);
+}
+
+static int mount(void) {
+  sd_card_t* sd = sd_get_by_num(0);
+  if (!sd)
+    return -1;
+  claim_pins(sd);
+  if (mounted)
+    return 0;
+  if (f_mount(&sd->fatfs, sd->pcName, 1) != FR_OK)
+    return -1;
+  sd->mounted = true;
+  mounted = 1;
+  return 0;
+}
+
+int frame_store_load(uint8_t* buf, size_t len) {
+  if (mount() != 0)
+    return -1;
+  FIL fil;
+  if (f_open(&fil, FRAME_STORE_FILE, FA_READ) != FR_OK)
+    return -1;
+  frame_store_hdr_t hdr;
+  UINT got = 0;
+  int rc = -1;
+  if (f_read(&fil, &hdr, sizeof(hdr), &got) == FR_OK && got == sizeof(hdr) &&
+      hdr.magic == FRAME_STORE_MAGIC && hdr.len == len &&
+      f_read(&fil, buf, (UINT)len, &got) == FR_OK && got == len &&
+      crc32_update(0, buf, len) == hdr.crc)
+    rc = 0;
+  f_close(&fil);
+  return rc;
+}
+
+int frame_store_save(const uint8_t* buf, size_t len) {
+  if (mount() != 0)
+    return -1;
+  FIL fil;
+  if (f_open(&fil, FRAME_STORE_FILE, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return -1;
+  frame_store_hdr_t hdr = {FRAME_STORE_MAGIC, (uint32_t)len,
+                           crc32_update(0, buf, len)};
+  UINT put = 0;
+  int rc = -1;
+  if (f_write(&fil, &hdr, sizeof(hdr), &put) == FR_OK && put == sizeof(hdr) &&
+      f_write(&fil, buf, (UINT)len, &put) == FR_OK && put == len)
+    rc = 0;
+  if (f_close(&fil) != FR_OK)
+    rc = -1;
+  return rc;
+}
+
+int frame_store_load_shown(size_t len, uint32_t* crc) {
+  if (mount() != 0)
+    return -1;
+  FIL fil;
+  if (f_open(&fil, FRAME_SHOWN_FILE, FA_READ) != FR_OK)
+    return -1;
+  frame_store_hdr_t rec;
+  UINT got = 0;
+  int rc = -1;
+  if (f_read(&fil, &rec, sizeof(rec), &got) == FR_OK && got == sizeof(rec) &&
+      rec.magic == FRAME_SHOWN_MAGIC && len && rec.len == len) {
+    *crc = rec.crc;
+    rc = 0;
+  }
+  f_close(&fil);
+  return rc;
+}
+
+int frame_store_save_shown(size_t len, uint32_t crc) {
+  if (mount() != 0)
+    return -1;
+  FIL fil;
+  if (f_open(&fil, FRAME_SHOWN_FILE, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return -1;
+  frame_store_hdr_t rec = {FRAME_SHOWN_MAGIC, (uint32_t)len, crc};
+  UINT put = 0;
+  int rc = (f_write(&fil, &rec, sizeof(rec), &put) == FR_OK &&
+            put == sizeof(rec))
+               ? 0
+               : -1;
+  if (f_close(&fil) != FR_OK)
+    rc = -1;
+  return rc;
+}
@@ -0,0 +1,32 @@
+#ifndef _FRAME_STORE_H_
+#define _FRAME_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Last received frame on the SD card, kept as the base for delta requests.
+// The file carries the frame length and CRC32, so a missing card, a torn
+// write or a frame of another size simply reads back as "no frame".
+//
+// The card's MISO and CS are GPIO4/5, UART1's TX and RX. Every call below
+// muxes them for SPI and leaves them so: the caller lets UART TX drain
+// before it, and gives the pins back to the UART (and drops whatever RX
+// caught meanwhile) after it.
+
+// Load the stored frame into buf (len bytes). Returns 0, or -1 if there is
+// no usable frame (buf contents are then undefined).
+int frame_store_load(uint8_t* buf, size_t len);
+
+// Replace the stored frame. Returns 0, or -1 on any SD / FatFs error.
+int frame_store_save(const uint8_t* buf, size_t len);
+
+// CRC32 of the frame the panel showed after its last good refresh, kept
+// apart from the stored frame: that one is saved whether or not it made it
+// to the panel. Returns 0 and sets *crc if a len-byte frame is on record.
+int frame_store_load_shown(size_t len, uint32_t* crc);
+
+// Record what the panel shows now; len 0 when that is not known (a refresh
+// that failed part way). Returns 0, or -1 on any SD / FatFs error.
+int frame_store_save_shown(size_t len, uint32_t crc);
+
+#endif
@@ -0,0 +1,179 @@
+#include "link_proto.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Names used for the LINK_FMT_* bits in FMT=.
+static const struct {
+  uint8_t bit;
+  const char* name;
+} link_fmt_names[] = {
+    {LINK_FMT_LZ, "LZ"},
+    {LINK_FMT_P3, "P3"},
+    {LINK_FMT_CRC, "CRC"},
+    {LINK_FMT_DELTA, "DELTA"},
+};
+#define LINK_FMT_COUNT (sizeof(link_fmt_names) / sizeof(link_fmt_names[0]))
+
+// Value of "KEY=" inside line, or NULL. Keys only match at a word start so
+// "BAUD=" never matches inside another token.
+static const char* find_opt(const char* line, const char* key) {
+  size_t klen = strlen(key);
+  for (const char* p = strstr(line, key); p; p = strstr(p + 1, key)) {
+    if (p == line || p[-1] == ' ')
+      return p + klen;
+  }
+  return NULL;
+}
+
+void link_baud_init(link_baud_t* lb,
+                    const uint32_t* rates,
+                    int n_rates,
+                    int want_flow) {
+  if (n_rates > LINK_MAX_RATES)
+    n_rates = LINK_MAX_RATES;
+  for (int i = 0; i < n_rates; i++)
+    lb->rates[i] = rates[i];
+  lb->n_rates = n_rates;
+  lb->first_allowed = 0;
+  lb->want_flow = want_flow;
+  lb->current = LINK_BASE_BAUD;
+  lb->flow = 0;
+}
+
+// Append to the n bytes already in buf. Returns the new length, or -1 once
+// buf (len bytes) is too small, so a caller can chain calls and check once.
+static int link_append(char* buf, size_t len, int n, const char* fmt, ...) {
+  if (n < 0 || (size_t)n >= len)
+    return -1;
+  va_list ap;
+  va_start(ap, fmt);
+  int k = vsnprintf(buf + n, len - n, fmt, ap);
+  va_end(ap);
+  if (k < 0 || (size_t)k >= len - n)
+    return -1;
+  return n + k;
+}
+
+int link_format_request(const link_baud_t* lb,
+                        uint8_t formats,
+                        const link_resume_t* resume,
+                        int tiles,
+                        char* buf,
+                        size_t len) {
+  int n = link_append(buf, len, 0, "SENDIMG");
+  if (lb->first_allowed < lb->n_rates) {
+    const char* sep = " BAUD=";
+    for (int i = lb->first_allowed; i < lb->n_rates; i++) {
+      n = link_append(buf, len, n, "%s%lu", sep, (unsigned long)lb->rates[i]);
+      sep = ",";
+    }
+    if (lb->want_flow)
+      n = link_append(buf, len, n, " FLOW=RTS");
+  }
+  const char* sep = " FMT=";
+  for (size_t i = 0; i < LINK_FMT_COUNT; i++) {
+    if (formats & link_fmt_names[i].bit) {
+      n = link_append(buf, len, n, "%s%s", sep, link_fmt_names[i].name);
+      sep = ",";
+    }
+  }
+  if (resume && resume->from)
+    n = link_append(buf, len, n, " FROM=%lu ID=%08lX",
+                    (unsigned long)resume->from, (unsigned long)resume->id);
+  if (tiles > 0)
+    n = link_append(buf, len, n, " TILES=%d", tiles);
+  n = link_append(buf, len, n, "\n");
+  if (n < 0 && len > 0)
+    buf[0] = '\0';  // never leave a cut-off request behind
+  return n;
+}
+
+uint32_t link_parse_ack(link_baud_t* lb, const char* line) {
+  lb->current = LINK_BASE_BAUD;
+  lb->flow = 0;
+  const char* v = find_opt(line, "BAUD=");
+  if (v) {
+    uint32_t baud = (uint32_t)strtoul(v, NULL, 10);
+    // Only accept a rate we actually offered.
+    for (int i = lb->first_allowed; i < lb->n_rates; i++) {
+      if (lb->rates[i] == baud) {
+        lb->current = baud;
+        break;
+      }
+    }
+  }
+  v = find_opt(line, "FLOW=");
+  if (v && lb->want_flow && strncmp(v, "RTS", 3) == 0)
+    lb->flow = 1;
+  return lb->current;
+}
+
+void link_baud_frame_done(link_baud_t* lb, int ok) {
+  if (!ok && lb->current != LINK_BASE_BAUD) {
+    for (int i = lb->first_allowed; i < lb->n_rates; i++) {
+      if (lb->rates[i] == lb->current) {
+        lb->first_allowed = i + 1;
+        break;
+      }
+    }
+  }
+  lb->current = LINK_BASE_BAUD;
+  lb->flow = 0;
+}
+
+int link_parse_request(const char* line,
+                       uint32_t* rates,
+                       int max_rates,
+                       int* flow,
+                       uint8_t* formats) {
+  if (strncmp(line, "SENDIMG", 7) != 0)
+    return -1;
+  int n = 0;
+  const char* v = find_opt(line, "BAUD=");
+  while (v && n < max_rates) {
+    char* end;
+    unsigned long baud = strtoul(v, &end, 10);
+    if (end == v)
+      break;
+    rates[n++] = (uint32_t)baud;
+    v = (*end == ',') ? end + 1 : NULL;
+  }
+  v = find_opt(line, "FLOW=");
+  *flow = (v && strncmp(v, "RTS", 3) == 0) ? 1 : 0;
+  *formats = 0;
+  v = find_opt(line, "FMT=");
+  while (v) {
+    size_t tlen = strcspn(v, ", \r\n");
+    for (size_t i = 0; i < LINK_FMT_COUNT; i++) {
+      if (strlen(link_fmt_names[i].name) == tlen &&
+          strncmp(v, link_fmt_names[i].name, tlen) == 0)
+        *formats |= link_fmt_names[i].bit;
+    }
+    v = (v[tlen] == ',') ? v + tlen + 1 : NULL;
+  }
+  return n;
+}
+
+int link_parse_resume(const char* line, link_resume_t* r) {
+  const char* v = find_opt(line, "FROM=");
+  r->from = v ? (uint32_t)strtoul(v, NULL, 10) : 0;
+  v = find_opt(line, "ID=");
+  r->id = v ? (uint32_t)strtoul(v, NULL, 16) : 0;
+  return v != NULL;
+}
+
+int link_parse_tiles(const char* line) {
+  const char* v = find_opt(line, "TILES=");
+  return v ? atoi(v) : 0;
+}
+
+int link_fmt_accepted(uint8_t fmt, uint8_t formats, uint32_t from) {
+  if (fmt & ~formats)
+    return 0;
+  if (from && (fmt & LINK_FMT_DELTA))
+    return 0;
+  return !(fmt & LINK_FMT_P3) || from % LINK_P3_FROM_ALIGN == 0;
+}
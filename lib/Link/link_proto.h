@@ -0,0 +1,129 @@
+#ifndef _LINK_PROTO_H_
+#define _LINK_PROTO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// SENDIMG handshake options shared by the Pico and the host stand-in peer.
+// Portable: no Pico SDK headers.
+//
+// Baud negotiation:
+//   Pico -> peer : "SENDIMG BAUD=2000000,921600 FLOW=RTS\n"  (fastest first)
+//   peer -> Pico : "ACK BAUD=921600 FLOW=RTS\n"  (twice, at the base rate)
+// The peer picks the fastest rate it supports, sends both ACK lines at
+// LINK_BASE_BAUD, waits LINK_PEER_SWITCH_DELAY_MS and sends SOF at the new
+// rate. The Pico switches LINK_SWITCH_DELAY_MS after the first ACK. Both
+// sides drop back to LINK_BASE_BAUD once the frame ends (good or bad), so
+// PLOG / PICODONE always travel at the base rate. A peer that replies with a
+// bare "ACK" keeps the whole frame at the base rate.
+//
+// Payload formats:
+//   Pico -> peer : "... FMT=LZ,P3"  (formats the Pico can decode)
+// The size header's top byte carries the LINK_FMT_* bits of the payload and
+// the low 24 bits its length on the wire. Raw frames keep the top byte 0, so
+// a peer that ignores FMT= is unaffected. The bits compose: LZ|P3 is a P3
+// frame that was then LZ-compressed, and is decoded in that order.
+//
+// Checksummed chunks and resume (FMT=CRC):
+// With LINK_FMT_CRC the payload is cut into LINK_CHUNK_SIZE pieces (the last
+// one may be short), each followed by its CRC32, big-endian; the header
+// length does not count the CRCs. The ACK then carries ID=<crc32 of the 4bpp
+// frame>. After a failed frame the Pico asks for the rest only:
+//   Pico -> peer : "... FROM=<image byte offset> ID=<id>"
+//   peer -> Pico : "ACK ... FROM=<offset> ID=<id>" if it still has that frame
+// and then sends frame[offset..] freshly encoded. An ACK without a matching
+// FROM= means a full frame follows. A P3 (or LZ|P3) rest must start on a P3
+// group, so FROM= a multiple of LINK_P3_FROM_ALIGN: the Pico unpacks whole
+// aligned words from buffer + FROM, and rejects the frame otherwise. A peer
+// asked to resume elsewhere sends the rest without P3.
+//
+// Delta frames (FMT=DELTA):
+// When the Pico still holds the previous frame it adds TILES=<n> to the
+// request line and sends tile_hashes_pack() of that frame (n CRC32s plus a
+// block CRC, see tiles.h) right after the '\n'. A peer that answers with
+// LINK_FMT_DELTA in the header sends only the tiles whose hash differs; the
+// ACK's ID= still covers the whole new frame.
+// ---------------------------------------------------------------------------
+
+#define LINK_BASE_BAUD 115200
+#define LINK_MAX_RATES 4
+#define LINK_SWITCH_DELAY_MS 20
+#define LINK_PEER_SWITCH_DELAY_MS 50
+
+#define LINK_FMT_RAW 0x00
+#define LINK_FMT_LZ 0x01  // LZSS stream, see lz_decode.h
+#define LINK_FMT_P3 0x02  // 3 bits per pixel, see pack3.h
+#define LINK_FMT_CRC 0x04  // CRC32 after every LINK_CHUNK_SIZE payload bytes
+#define LINK_FMT_DELTA 0x08  // changed tiles only, see payload.h
+#define LINK_HDR_FMT(h) ((uint8_t)((h) >> 24))
+#define LINK_HDR_LEN(h) ((uint32_t)(h) & 0x00FFFFFFu)
+
+#define LINK_P3_FROM_ALIGN 4  // PACK3_GROUP_OUT: 4bpp bytes per P3 group
+
+#define LINK_CHUNK_SIZE 4096
+#define LINK_CRC_SIZE 4
+// Wire bytes of a LINK_FMT_CRC payload with len header bytes.
+#define LINK_CHUNKED_LEN(len) \
+  ((len) + ((len) + LINK_CHUNK_SIZE - 1) / LINK_CHUNK_SIZE * LINK_CRC_SIZE)
+
+typedef struct {
+  uint32_t from;  // image byte offset to resume at (0 = whole frame)
+  uint32_t id;    // frame ID from the ACK of the interrupted frame
+} link_resume_t;
+
+typedef struct {
+  uint32_t rates[LINK_MAX_RATES];  // candidate fast rates, fastest first
+  int n_rates;
+  int first_allowed;  // rates[0..first_allowed) failed earlier; skip them
+  int want_flow;      // advertise FLOW=RTS
+  uint32_t current;   // rate agreed for the frame in flight
+  int flow;           // peer confirmed RTS/CTS for the frame in flight
+} link_baud_t;
+
+void link_baud_init(link_baud_t* lb,
+                    const uint32_t* rates,
+                    int n_rates,
+                    int want_flow);
+
+// Format the request line (with trailing '\n'), offering the LINK_FMT_* bits
+// in formats, asking to resume when resume->from is set (resume may be NULL)
+// and announcing a tile hash block when tiles is non-zero. Returns its
+// length, or -1 (and an empty buf) if it does not fit in len bytes.
+int link_format_request(const link_baud_t* lb,
+                        uint8_t formats,
+                        const link_resume_t* resume,
+                        int tiles,
+                        char* buf,
+                        size_t len);
+
+// Apply the options on an ACK line; sets lb->current / lb->flow and returns
+// the rate to use for the rest of the frame.
+uint32_t link_parse_ack(link_baud_t* lb, const char* line);
+
+// Frame finished at lb->current. A failed fast frame removes that rate (and
+// every faster one) from future requests. Resets current to the base rate.
+void link_baud_frame_done(link_baud_t* lb, int ok);
+
+// Peer side: parse "SENDIMG ..." options. Fills rates (fastest first), *flow
+// and *formats. Returns the number of rates, or -1 if line is not a SENDIMG
+// request.
+int link_parse_request(const char* line,
+                       uint32_t* rates,
+                       int max_rates,
+                       int* flow,
+                       uint8_t* formats);
+
+// FROM= / ID= on a request or an ACK line. Returns 1 if ID= is present;
+// r->from is 0 without FROM=.
+int link_parse_resume(const char* line, link_resume_t* r);
+
+// Peer side: TILES= on a request line (0 without).
+int link_parse_tiles(const char* line);
+
+// Whether a size header with format fmt may answer a request that offered
+// formats and resumes at from: no bit that was not offered, no DELTA with a
+// resume, and P3 only at a multiple of LINK_P3_FROM_ALIGN.
+int link_fmt_accepted(uint8_t fmt, uint8_t formats, uint32_t from);
+
+#endif
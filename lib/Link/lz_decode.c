@@ -0,0 +1,132 @@
+#include "lz_decode.h"
+
+enum {
+  LZ_ST_ITEM,   // next item: read a flag bit (and a flag byte if needed)
+  LZ_ST_LIT,    // literal byte expected
+  LZ_ST_M0,     // first match byte expected
+  LZ_ST_M1,     // second match byte expected
+  LZ_ST_EXT,    // length extension byte expected
+  LZ_ST_COPY,   // copying a match out of the window
+};
+
+#define LZ_MASK (LZ_WINDOW_SIZE - 1)
+
+void lz_decoder_init(lz_decoder_t* d) {
+  d->produced = 0;
+  d->dist = 0;
+  d->len = 0;
+  d->state = LZ_ST_ITEM;
+  d->flags = 0;
+  d->nflags = 0;
+}
+
+int lz_decoder_idle(const lz_decoder_t* d) {
+  return d->state == LZ_ST_ITEM;
+}
+
+int32_t lz_decode(lz_decoder_t* d,
+                  const uint8_t* in,
+                  size_t in_len,
+                  uint8_t* out,
+                  size_t out_cap,
+                  size_t* out_len) {
+  const uint8_t* ip = in;
+  const uint8_t* iend = in + in_len;
+  uint8_t* op = out;
+  uint8_t* oend = out + out_cap;
+  uint8_t* win = d->window;
+  uint32_t pos = d->produced;
+  uint32_t dist = d->dist;
+  uint32_t len = d->len;
+  uint8_t state = d->state;
+  uint8_t flags = d->flags;
+  uint8_t nflags = d->nflags;
+  int32_t rc = 0;
+
+  for (;;) {
+    switch (state) {
+      case LZ_ST_ITEM:
+        if (nflags == 0) {
+          if (ip == iend)
+            goto done;
+          flags = *ip++;
+          nflags = 8;
+        }
+        // Take the flag bit only once the item has data, so a stream that
+        // ends mid flag byte leaves the decoder idle.
+        if (ip == iend)
+          goto done;
+        state = (flags & 1) ? LZ_ST_M0 : LZ_ST_LIT;
+        flags >>= 1;
+        nflags--;
+        break;
+
+      case LZ_ST_LIT:
+        if (ip == iend || op == oend)
+          goto done;
+        win[pos++ & LZ_MASK] = *op++ = *ip++;
+        state = LZ_ST_ITEM;
+        break;
+
+      case LZ_ST_M0:
+        if (ip == iend)
+          goto done;
+        len = *ip >> 4;
+        dist = (uint32_t)(*ip++ & 0x0F) << 8;
+        state = LZ_ST_M1;
+        break;
+
+      case LZ_ST_M1:
+        if (ip == iend)
+          goto done;
+        dist = (dist | *ip++) + 1;
+        if (dist > pos) {
+          rc = -1;
+          goto done;
+        }
+        if (len == 15) {
+          len += LZ_MIN_MATCH;
+          state = LZ_ST_EXT;
+        } else {
+          len += LZ_MIN_MATCH;
+          state = LZ_ST_COPY;
+        }
+        break;
+
+      case LZ_ST_EXT: {
+        if (ip == iend)
+          goto done;
+        uint8_t ext = *ip++;
+        len += ext;
+        if (ext != 255)
+          state = LZ_ST_COPY;
+        break;
+      }
+
+      case LZ_ST_COPY: {
+        size_t room = (size_t)(oend - op);
+        uint32_t n = (len < room) ? len : (uint32_t)room;
+        len -= n;
+        while (n--) {
+          uint8_t b = win[(pos - dist) & LZ_MASK];
+          win[pos++ & LZ_MASK] = b;
+          *op++ = b;
+        }
+        if (len)
+          goto done;  // output full
+        state = LZ_ST_ITEM;
+        break;
+      }
+    }
+  }
+
+done:
+  d->produced = pos;
+  d->dist = dist;
+  d->len = len;
+  d->state = state;
+  d->flags = flags;
+  d->nflags = nflags;
+  *out_len = (size_t)(op - out);
+  return rc ? rc : (int32_t)(ip - in);
+}
@@ -0,0 +1,57 @@
+#ifndef _LZ_DECODE_H_
+#define _LZ_DECODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Streaming decoder for the LINK_FMT_LZ payload (byte-aligned LZSS).
+//
+// Stream layout: a flag byte announces the next 8 items, LSB first.
+//   flag 0 -> one literal byte
+//   flag 1 -> match: 2 bytes  LLLL DDDD  DDDD DDDD
+//             distance = D + 1            (1 .. LZ_WINDOW_SIZE)
+//             length   = L + LZ_MIN_MATCH (L = 15: add extension bytes, each
+//                        0..255, until one is < 255)
+//
+// Input can be fed in arbitrary pieces (tokens may straddle reads). The only
+// history kept is an LZ_WINDOW_SIZE ring, so RAM use does not depend on the
+// output size. Portable: shared by the firmware and the host tools in tests/.
+// ---------------------------------------------------------------------------
+
+#define LZ_WINDOW_BITS 12
+#define LZ_WINDOW_SIZE (1u << LZ_WINDOW_BITS)
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_DIST LZ_WINDOW_SIZE
+
+// Worst-case encoded size (all literals) for raw_len input bytes.
+#define LZ_BOUND(raw_len) ((raw_len) + ((raw_len) + 7) / 8 + 16)
+
+typedef struct {
+  uint8_t window[LZ_WINDOW_SIZE];
+  uint32_t produced;  // total bytes output so far
+  uint32_t dist;      // distance of the match in progress
+  uint32_t len;       // bytes still to copy for the match in progress
+  uint8_t state;
+  uint8_t flags;      // pending flag bits, next one in bit 0
+  uint8_t nflags;     // number of valid bits in flags
+} lz_decoder_t;
+
+void lz_decoder_init(lz_decoder_t* d);
+
+// Decode in[0..in_len) into out[0..out_cap). Stops early when out is full
+// (call again with more room to resume). Returns the number of input bytes
+// consumed, or -1 if the stream is corrupt (match reaches before the start
+// of the output). *out_len receives the number of bytes written.
+int32_t lz_decode(lz_decoder_t* d,
+                  const uint8_t* in,
+                  size_t in_len,
+                  uint8_t* out,
+                  size_t out_cap,
+                  size_t* out_len);
+
+// True when the decoder is between items, i.e. the stream may legally end
+// here.
+int lz_decoder_idle(const lz_decoder_t* d);
+
+#endif
@@ -0,0 +1,91 @@
+#include "pack3.h"
+
+#include <string.h>
+
+// Spread the eight 3-bit fields of a 24-bit group into the low 3 bits of
+// eight nibbles (p7 in nibble 0), halving the field width at each step.
+static inline uint32_t spread(uint32_t v) {
+  v = (v & 0x000FFFu) | ((v & 0xFFF000u) << 4);
+  v = (v & 0x003F003Fu) | ((v & 0x0FC00FC0u) << 2);
+  v = (v & 0x07070707u) | ((v & 0x38383838u) << 1);
+  return v;
+}
+
+// Store the spread group so that p0 p1 land in the first byte. out is word
+// aligned, so this is a single store on the M0+.
+static inline void put_group(uint8_t* out, uint32_t v) {
+  uint32_t w = __builtin_bswap32(spread(v));
+  memcpy(__builtin_assume_aligned(out, 4), &w, sizeof(w));
+}
+
+static inline uint32_t load_be32(const uint8_t* in) {
+  uint32_t w;
+  memcpy(&w, __builtin_assume_aligned(in, 4), sizeof(w));
+  return __builtin_bswap32(w);
+}
+
+static inline uint32_t get_group(const uint8_t* in) {
+  return ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+}
+
+void pack3_unpack(uint8_t* out, const uint8_t* in, size_t groups) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // Four groups per three aligned word loads. Every block is read before
+  // it is written, which is what keeps the in-place case safe.
+  if (((uintptr_t)in & 3) == 0) {
+    for (; groups >= 4; groups -= 4, in += 12, out += 16) {
+      uint32_t a = load_be32(in);
+      uint32_t b = load_be32(in + 4);
+      uint32_t c = load_be32(in + 8);
+      put_group(out, a >> 8);
+      put_group(out + 4, ((a & 0xFFu) << 16) | (b >> 16));
+      put_group(out + 8, ((b & 0xFFFFu) << 8) | (c >> 24));
+      put_group(out + 12, c & 0xFFFFFFu);
+    }
+  }
+#endif
+  for (; groups; groups--, in += PACK3_GROUP_IN, out += PACK3_GROUP_OUT)
+    put_group(out, get_group(in));
+}
+
+void pack3_pack(uint8_t* out, const uint8_t* in, size_t groups) {
+  for (; groups; groups--, in += PACK3_GROUP_OUT, out += PACK3_GROUP_IN) {
+    uint32_t v = 0;
+    for (int i = 0; i < PACK3_GROUP_OUT; i++)
+      v = (v << 6) | ((uint32_t)(in[i] & 0x70) >> 1) | (in[i] & 0x07);
+    out[0] = (uint8_t)(v >> 16);
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)v;
+  }
+}
+
+void pack3_stream_init(pack3_stream_t* s) {
+  s->ncarry = 0;
+}
+
+size_t pack3_unpack_stream(pack3_stream_t* s,
+                           const uint8_t* in,
+                           size_t n,
+                           uint8_t* out) {
+  size_t written = 0;
+  if (s->ncarry) {
+    while (s->ncarry < PACK3_GROUP_IN && n) {
+      s->carry[s->ncarry++] = *in++;
+      n--;
+    }
+    if (s->ncarry < PACK3_GROUP_IN)
+      return 0;
+    put_group(out, get_group(s->carry));
+    written = PACK3_GROUP_OUT;
+    s->ncarry = 0;
+  }
+
+  size_t groups = n / PACK3_GROUP_IN;
+  pack3_unpack(out + written, in, groups);
+  written += groups * PACK3_GROUP_OUT;
+
+  size_t tail = n - groups * PACK3_GROUP_IN;
+  memcpy(s->carry, in + groups * PACK3_GROUP_IN, tail);
+  s->ncarry = (uint8_t)tail;
+  return written;
+}
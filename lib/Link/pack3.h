@@ -0,0 +1,49 @@
+#ifndef _PACK3_H_
+#define _PACK3_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// 3 bits per pixel wire format (LINK_FMT_P3).
+//
+// The panel only has 7 colors (EPD_7IN3F_BLACK..ORANGE, plus CLEAN = 7), so
+// the high bit of every 4bpp nibble is dead weight. P3 packs 8 pixels into
+// 3 bytes, MSB first:
+//
+//   byte 0..2 = p0 p1 p2 p3 p4 p5 p6 p7   (3 bits each, p0 in bits 23..21)
+//
+// and expands back to the panel's 4bpp layout (p0 in the high nibble of the
+// first byte) as one 32-bit word per group. An 800x480 frame is 144000 bytes
+// on the wire instead of 192000.
+// ---------------------------------------------------------------------------
+
+#define PACK3_GROUP_IN 3   // packed bytes per group
+#define PACK3_GROUP_OUT 4  // 4bpp bytes per group (8 pixels)
+#define PACK3_SIZE(len4bpp) ((len4bpp) / PACK3_GROUP_OUT * PACK3_GROUP_IN)
+
+// Expand groups 3-byte groups from in into out (4-byte aligned). in may
+// point into the same buffer at or after out + groups: unpacking a frame
+// received into the last PACK3_SIZE bytes of its own 4bpp buffer is safe.
+void pack3_unpack(uint8_t* out, const uint8_t* in, size_t groups);
+
+// Pack groups 8-pixel groups of 4bpp data (nibbles must be < 8).
+void pack3_pack(uint8_t* out, const uint8_t* in, size_t groups);
+
+// Streaming unpack for arbitrary input pieces: up to two bytes of an
+// incomplete group are carried over to the next call.
+typedef struct {
+  uint8_t carry[PACK3_GROUP_IN];
+  uint8_t ncarry;
+} pack3_stream_t;
+
+void pack3_stream_init(pack3_stream_t* s);
+
+// Unpack in[0..n) into out (4-byte aligned, room for (n + 2) / 3 * 4
+// bytes). Returns the number of bytes written, always a multiple of 4.
+size_t pack3_unpack_stream(pack3_stream_t* s,
+                           const uint8_t* in,
+                           size_t n,
+                           uint8_t* out);
+
+#endif
@@ -0,0 +1,263 @@
+#include "payload.h"
+
+#include <string.h>
+
+#include "crc32.h"
+
+void payload_init(payload_decoder_t* p,
+                  uint8_t fmt,
+                  size_t wire_len,
+                  uint8_t* out,
+                  size_t out_cap) {
+  p->fmt = fmt;
+  p->wire_len = wire_len;
+  p->consumed = 0;
+  p->out = out;
+  p->out_cap = out_cap;
+  p->produced = 0;
+  p->verified = 0;
+  p->chunk_len = 0;
+  if (fmt & LINK_FMT_LZ)
+    lz_decoder_init(&p->lz);
+  pack3_stream_init(&p->p3);
+  p->grid = NULL;
+  p->bitmap_fill = 0;
+  p->tile_idx = 0;
+  p->tiles = 0;
+  p->tile_fill = 0;
+  p->sink = NULL;
+  p->win_fill = 0;
+}
+
+void payload_set_tiles(payload_decoder_t* p, const tile_grid_t* grid) {
+  p->grid = grid;
+}
+
+void payload_set_sink(payload_decoder_t* p,
+                      payload_sink_t sink,
+                      void* ctx,
+                      uint8_t* win,
+                      size_t win_cap) {
+  p->sink = sink;
+  p->sink_ctx = ctx;
+  p->win = win;
+  p->win_alt = NULL;
+  p->win_cap = win_cap;
+  p->win_fill = 0;
+}
+
+void payload_set_sink_alt(payload_decoder_t* p, uint8_t* win_alt) {
+  p->win_alt = win_alt;
+}
+
+// Where the next output bytes go; *room is how many fit there.
+static uint8_t* out_ptr(const payload_decoder_t* p, size_t* room) {
+  size_t left = p->out_cap - p->produced;
+  if (!p->sink) {
+    *room = left;
+    return p->out + p->produced;
+  }
+  size_t r = p->win_cap - p->win_fill;
+  *room = (r < left) ? r : left;
+  return p->win + p->win_fill;
+}
+
+static void out_flush(payload_decoder_t* p) {
+  if (p->sink && p->win_fill) {
+    p->sink(p->sink_ctx, p->win, p->win_fill);
+    p->win_fill = 0;
+    if (p->win_alt) {
+      uint8_t* w = p->win;
+      p->win = p->win_alt;
+      p->win_alt = w;
+    }
+  }
+}
+
+static void out_advance(payload_decoder_t* p, size_t n) {
+  p->produced += n;
+  if (p->sink && (p->win_fill += n) == p->win_cap)
+    out_flush(p);
+}
+
+// Packed bytes -> 4bpp (or a plain copy) into dst, stopping when its room
+// is used up. Returns the input consumed; *wrote gets the bytes written.
+static size_t expand(payload_decoder_t* p, const uint8_t* in, size_t n,
+                     uint8_t* dst, size_t room, size_t* wrote) {
+  if (!(p->fmt & LINK_FMT_P3)) {
+    size_t k = (n < room) ? n : room;
+    memcpy(dst, in, k);
+    *wrote = k;
+    return k;
+  }
+  size_t fits = room / PACK3_GROUP_OUT * PACK3_GROUP_IN;
+  size_t k = (fits > p->p3.ncarry) ? fits - p->p3.ncarry : 0;
+  if (k > n)
+    k = n;
+  *wrote = pack3_unpack_stream(&p->p3, in, k, dst);
+  return k;
+}
+
+static int next_tile(const payload_decoder_t* p, int i) {
+  while (++i < p->grid->count)
+    if (p->bitmap[i >> 3] & (1u << (i & 7)))
+      return i;
+  return p->grid->count;
+}
+
+// Delta payload: bitmap first, then whole tiles patched into the frame.
+static int emit_delta(payload_decoder_t* p, const uint8_t* in, size_t n) {
+  if (!p->grid || p->sink)
+    return -1;
+  const size_t bm_len = TILE_BITMAP_BYTES((size_t)p->grid->count);
+  while (n) {
+    if (p->bitmap_fill < bm_len) {
+      size_t k = bm_len - p->bitmap_fill;
+      if (k > n)
+        k = n;
+      memcpy(p->bitmap + p->bitmap_fill, in, k);
+      p->bitmap_fill += k;
+      in += k;
+      n -= k;
+      if (p->bitmap_fill == bm_len) {
+        for (int i = 0; i < p->grid->count; i++)
+          p->tiles += (p->bitmap[i >> 3] >> (i & 7)) & 1;
+        p->tile_idx = next_tile(p, -1);
+      }
+      continue;
+    }
+    if (p->tile_idx >= p->grid->count)
+      return -1;  // more tile data than the bitmap announced
+    size_t wrote;
+    size_t used = expand(p, in, n, p->tile + p->tile_fill,
+                         TILE_BYTES - p->tile_fill, &wrote);
+    p->tile_fill += wrote;
+    in += used;
+    n -= used;
+    if (p->tile_fill == TILE_BYTES) {
+      tile_put(p->grid, p->out, p->tile_idx, p->tile);
+      p->produced += TILE_BYTES;
+      p->tile_fill = 0;
+      p->tile_idx = next_tile(p, p->tile_idx);
+    }
+  }
+  return 0;
+}
+
+// Last step: packed bytes -> 4bpp, or a plain copy for unpacked frames.
+static int emit(payload_decoder_t* p, const uint8_t* in, size_t n) {
+  if (p->fmt & LINK_FMT_DELTA)
+    return emit_delta(p, in, n);
+  while (n) {
+    size_t room, wrote;
+    uint8_t* dst = out_ptr(p, &room);
+    size_t used = expand(p, in, n, dst, room, &wrote);
+    out_advance(p, wrote);
+    if (!used && !wrote)
+      return -1;  // frame full
+    in += used;
+    n -= used;
+  }
+  return 0;
+}
+
+// Payload bytes (already checked, if checksummed) -> decode steps.
+static int decode(payload_decoder_t* p, const uint8_t* in, size_t n) {
+  p->consumed += n;
+  if (!(p->fmt & LINK_FMT_LZ))
+    return emit(p, in, n);
+
+  if (!(p->fmt & (LINK_FMT_P3 | LINK_FMT_DELTA))) {
+    // A full sink window may still leave a match pending with no input left.
+    size_t room, got;
+    do {
+      uint8_t* dst = out_ptr(p, &room);
+      int32_t used = lz_decode(&p->lz, in, n, dst, room, &got);
+      if (used < 0)
+        return -1;
+      out_advance(p, got);
+      in += used;
+      n -= (size_t)used;
+    } while (room && got == room && (n || p->sink));
+    return n ? -1 : 0;
+  }
+
+  // LZ|P3, LZ|DELTA: decode through the stage buffer. Keep going while the
+  // stage fills up, since a long match can still be pending with no input
+  // left.
+  size_t got;
+  do {
+    int32_t used =
+        lz_decode(&p->lz, in, n, p->stage, sizeof(p->stage), &got);
+    if (used < 0 || emit(p, p->stage, got) != 0)
+      return -1;
+    in += used;
+    n -= (size_t)used;
+  } while (n || got == sizeof(p->stage));
+  return 0;
+}
+
+// Wire bytes -> CRC check per chunk (with LINK_FMT_CRC) -> decode().
+static int feed(payload_decoder_t* p, const uint8_t* in, size_t n) {
+  if (!(p->fmt & LINK_FMT_CRC))
+    return decode(p, in, n);
+
+  while (n) {
+    size_t data = p->wire_len - p->consumed;
+    if (data > LINK_CHUNK_SIZE)
+      data = LINK_CHUNK_SIZE;
+    if (data == 0)
+      return -1;  // more bytes than the header announced
+    size_t take = data + LINK_CRC_SIZE - p->chunk_len;
+    if (take > n)
+      take = n;
+    memcpy(p->chunk + p->chunk_len, in, take);
+    p->chunk_len += take;
+    in += take;
+    n -= take;
+    if (p->chunk_len < data + LINK_CRC_SIZE)
+      break;
+
+    const uint8_t* c = p->chunk + data;
+    uint32_t want = ((uint32_t)c[0] << 24) | ((uint32_t)c[1] << 16) |
+                    ((uint32_t)c[2] << 8) | c[3];
+    if (crc32_update(0, p->chunk, data) != want)
+      return -2;
+    p->chunk_len = 0;
+    if (decode(p, p->chunk, data) != 0)
+      return -1;
+    p->verified = p->produced;
+  }
+  return 0;
+}
+
+int payload_feed(payload_decoder_t* p, const uint8_t* in, size_t n) {
+  int rc = feed(p, in, n);
+  out_flush(p);
+  return rc;
+}
+
+int payload_complete(const payload_decoder_t* p) {
+  if ((p->fmt & LINK_FMT_CRC) &&
+      (p->chunk_len != 0 || p->consumed != p->wire_len))
+    return 0;
+  if (!(p->fmt & (LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_DELTA)))
+    return 1;
+  if ((p->fmt & LINK_FMT_LZ) && !lz_decoder_idle(&p->lz))
+    return 0;
+  if (p->p3.ncarry != 0)
+    return 0;
+  if (p->fmt & LINK_FMT_DELTA)
+    return p->grid &&
+           p->bitmap_fill == TILE_BITMAP_BYTES((size_t)p->grid->count) &&
+           p->tile_idx == p->grid->count && p->tile_fill == 0;
+  return p->produced == p->out_cap;
+}
+
+// Header length only; LINK_FMT_CRC adds LINK_CHUNKED_LEN() on the wire.
+size_t payload_max_wire(uint8_t fmt, size_t out_cap) {
+  size_t n = (fmt & LINK_FMT_P3) ? PACK3_SIZE(out_cap) : out_cap;
+  if (fmt & LINK_FMT_DELTA)
+    n += TILE_BITMAP_BYTES(out_cap / TILE_BYTES);
+  return (fmt & LINK_FMT_LZ) ? LZ_BOUND(n) : n;
+}
@@ -0,0 +1,107 @@
+#ifndef _PAYLOAD_H_
+#define _PAYLOAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "link_proto.h"
+#include "lz_decode.h"
+#include "pack3.h"
+#include "tiles.h"
+
+// ---------------------------------------------------------------------------
+// Decode pipeline for one frame's payload, driven by the LINK_FMT_* bits of
+// the size header:
+//
+//   wire bytes -> [CRC check] -> [LZ decode] -> [P3 unpack] -> 4bpp buffer
+//                                                           [-> tile patch]
+//
+// Input is fed in whatever pieces the UART delivers. LZ|P3 and delta frames
+// go through a small stage buffer after the LZ step; the rest writes straight
+// into the output buffer.
+//
+// With payload_set_sink() there is no frame buffer at all: output collects in
+// a small window that is handed to the sink whenever it fills and at the end
+// of every payload_feed() call, so the frame leaves in order while it is
+// still arriving. Delta frames need the whole frame and cannot use a sink.
+//
+// A LINK_FMT_DELTA payload is a bitmap of changed tiles (TILE_BITMAP_BYTES,
+// tile i in bit i % 8 of byte i / 8, never packed) followed by those tiles in
+// index order, each TILE_SIZE rows of TILE_ROW_BYTES (P3-packed with
+// LINK_FMT_P3). Every tile is collected, then patched into the frame in out.
+//
+// With LINK_FMT_CRC each chunk is collected and checked before any of it is
+// decoded, so a corrupt chunk never reaches the buffer and `verified` marks
+// where a resumed frame can pick up. Portable: the firmware and the host
+// tests in tests/ share it.
+// ---------------------------------------------------------------------------
+
+#define PAYLOAD_STAGE_SIZE 768  // LZ output per P3 step (multiple of 3)
+
+// Receives decoded 4bpp bytes in frame order.
+typedef void (*payload_sink_t)(void* ctx, const uint8_t* data, size_t n);
+
+typedef struct {
+  uint8_t fmt;
+  size_t wire_len;  // payload length from the size header (without CRCs)
+  size_t consumed;  // payload bytes decoded so far
+  uint8_t* out;     // 4-byte aligned when fmt has LINK_FMT_P3
+  size_t out_cap;   // frame size (also with a sink)
+  size_t produced;  // 4bpp bytes written to out
+  size_t verified;  // produced as of the last CRC-checked chunk
+  lz_decoder_t lz;
+  pack3_stream_t p3;
+  uint8_t stage[PAYLOAD_STAGE_SIZE];
+  size_t chunk_len;  // bytes collected towards the current chunk + CRC
+  uint8_t chunk[LINK_CHUNK_SIZE + LINK_CRC_SIZE];
+  const tile_grid_t* grid;  // LINK_FMT_DELTA only
+  uint8_t bitmap[TILE_BITMAP_BYTES(TILE_MAX)];
+  size_t bitmap_fill;
+  int tile_idx;      // tile being collected (grid->count: none left)
+  int tiles;         // tiles marked in the bitmap
+  size_t tile_fill;  // bytes of tile[] collected
+  uint8_t tile[TILE_BYTES] __attribute__((aligned(4)));
+  payload_sink_t sink;  // NULL: output goes to out
+  void* sink_ctx;
+  uint8_t* win;  // sink window, same alignment rule as out
+  uint8_t* win_alt;  // NULL, or the window used after the next flush
+  size_t win_cap;
+  size_t win_fill;
+} payload_decoder_t;
+
+void payload_init(payload_decoder_t* p,
+                  uint8_t fmt,
+                  size_t wire_len,
+                  uint8_t* out,
+                  size_t out_cap);
+
+// Delta frames patch tiles of grid into out (out_cap = the whole frame).
+void payload_set_tiles(payload_decoder_t* p, const tile_grid_t* grid);
+
+// Stream the out_cap frame bytes to sink through win (win_cap a multiple of
+// 4) instead of writing them to out, which may then be NULL.
+void payload_set_sink(payload_decoder_t* p,
+                      payload_sink_t sink,
+                      void* ctx,
+                      uint8_t* win,
+                      size_t win_cap);
+
+// Fill win and win_alt (same size and alignment) in turn, so the sink can
+// keep reading the window it was just handed (DMA to the panel, say) while
+// the other one fills. It must be done with a window by the time it is
+// handed the other one.
+void payload_set_sink_alt(payload_decoder_t* p, uint8_t* win_alt);
+
+// Feed n wire bytes. Returns 0, -1 if the payload is corrupt or would expand
+// past out_cap, or -2 if a chunk failed its CRC.
+int payload_feed(payload_decoder_t* p, const uint8_t* in, size_t n);
+
+// True when the payload may end here. Raw frames may be short; encoded ones
+// must have expanded to exactly out_cap bytes, delta ones have delivered
+// every marked tile.
+int payload_complete(const payload_decoder_t* p);
+
+// Largest wire length a fmt payload for out_cap image bytes can have.
+size_t payload_max_wire(uint8_t fmt, size_t out_cap);
+
+#endif
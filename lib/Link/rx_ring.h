@@ -0,0 +1,102 @@
+#ifndef _RX_RING_H_
+#define _RX_RING_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Single-producer / single-consumer byte ring for the UART receive path.
+//
+// head and tail are free-running byte counters (they never wrap back to the
+// buffer size), so "pending = head - tail" stays correct across uint32_t
+// overflow and an overrun is simply "pending > size".  The producer is either
+// the UART IRQ (rx_ring_put) or the DMA channel, whose write count is copied
+// into head by the consumer before each read.
+//
+// A DMA producer does not stop for the consumer: once the backlog is within
+// margin bytes of the size, the oldest unread bytes may be overwritten while
+// they are being copied out. That backlog counts as an overrun, like a byte
+// the IRQ producer had to drop: the pending bytes are discarded and lost is
+// set until rx_ring_drop(), so the reader never sees old and new bytes mixed.
+//
+// Kept free of Pico SDK headers so the host fake UART in tests/ can drive the
+// exact same ring code.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+  uint8_t* buf;
+  uint32_t size;           // power of two
+  volatile uint32_t head;  // bytes produced (IRQ / DMA)
+  uint32_t tail;           // bytes consumed
+  uint32_t overruns;       // bytes lost because the consumer fell behind
+  uint32_t high_water;     // largest backlog seen by the consumer
+  uint32_t margin;         // DMA producer: backlog above size - margin is lost
+  volatile uint8_t lost;   // bytes were lost since the last rx_ring_drop()
+} rx_ring_t;
+
+static inline void rx_ring_init(rx_ring_t* r, uint8_t* buf, uint32_t size) {
+  r->buf = buf;
+  r->size = size;
+  r->head = 0;
+  r->tail = 0;
+  r->overruns = 0;
+  r->high_water = 0;
+  r->margin = 0;
+  r->lost = 0;
+}
+
+// Producer side (IRQ path). Drops the byte and counts an overrun when full so
+// the consumer never sees a torn buffer.
+static inline void rx_ring_put(rx_ring_t* r, uint8_t c) {
+  uint32_t head = r->head;
+  if (head - r->tail >= r->size) {
+    r->overruns++;
+    r->lost = 1;
+    return;
+  }
+  r->buf[head & (r->size - 1)] = c;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  r->head = head + 1;
+}
+
+// Bytes waiting to be read. If a DMA producer lapped the consumer, or came
+// within margin bytes of it, all of them are counted as overruns and
+// discarded, and lost is set.
+static inline uint32_t rx_ring_pending(rx_ring_t* r) {
+  uint32_t pending = r->head - r->tail;
+  if (pending > r->high_water)
+    r->high_water = pending < r->size ? pending : r->size;
+  if (pending > r->size - r->margin) {
+    r->overruns += pending;
+    r->tail += pending;
+    r->lost = 1;
+    pending = 0;
+  }
+  return pending;
+}
+
+// Copy up to n pending bytes into dst without blocking. Returns bytes copied.
+static inline uint32_t rx_ring_read(rx_ring_t* r, uint8_t* dst, uint32_t n) {
+  uint32_t pending = rx_ring_pending(r);
+  if (n > pending)
+    n = pending;
+  if (n == 0)
+    return 0;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  uint32_t off = r->tail & (r->size - 1);
+  uint32_t first = r->size - off;
+  if (first > n)
+    first = n;
+  memcpy(dst, r->buf + off, first);
+  memcpy(dst + first, r->buf, n - first);
+  r->tail += n;
+  return n;
+}
+
+// Discard everything currently pending and clear lost.
+static inline void rx_ring_drop(rx_ring_t* r) {
+  r->tail = r->head;
+  r->lost = 0;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "tiles.h"
+
+#include <string.h>
+
+#include "crc32.h"
+
+int tile_grid_init(tile_grid_t* g, int width, int height) {
+  if (width <= 0 || height <= 0 || width % TILE_SIZE || height % TILE_SIZE)
+    return -1;
+  int cols = width / TILE_SIZE, rows = height / TILE_SIZE;
+  if (cols * rows > TILE_MAX)
+    return -1;
+  g->cols = (uint16_t)cols;
+  g->rows = (uint16_t)rows;
+  g->count = (uint16_t)(cols * rows);
+  g->row_bytes = (uint16_t)(width / 2);
+  return 0;
+}
+
+static size_t tile_offset(const tile_grid_t* g, int i) {
+  return (size_t)(i / g->cols) * TILE_SIZE * g->row_bytes +
+         (size_t)(i % g->cols) * TILE_ROW_BYTES;
+}
+
+void tile_get(const tile_grid_t* g, const uint8_t* frame, int i,
+              uint8_t* tile) {
+  const uint8_t* src = frame + tile_offset(g, i);
+  for (int y = 0; y < TILE_SIZE; y++, src += g->row_bytes)
+    memcpy(tile + y * TILE_ROW_BYTES, src, TILE_ROW_BYTES);
+}
+
+void tile_put(const tile_grid_t* g, uint8_t* frame, int i,
+              const uint8_t* tile) {
+  uint8_t* dst = frame + tile_offset(g, i);
+  for (int y = 0; y < TILE_SIZE; y++, dst += g->row_bytes)
+    memcpy(dst, tile + y * TILE_ROW_BYTES, TILE_ROW_BYTES);
+}
+
+void tile_hashes(const tile_grid_t* g, const uint8_t* frame,
+                 uint32_t* hashes) {
+  for (int i = 0; i < g->count; i++) {
+    const uint8_t* src = frame + tile_offset(g, i);
+    uint32_t crc = 0;
+    for (int y = 0; y < TILE_SIZE; y++, src += g->row_bytes)
+      crc = crc32_update(crc, src, TILE_ROW_BYTES);
+    hashes[i] = crc;
+  }
+}
+
+static void put_be32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static uint32_t get_be32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | p[3];
+}
+
+size_t tile_hashes_pack(const uint32_t* hashes, int n, uint8_t* out) {
+  for (int i = 0; i < n; i++)
+    put_be32(out + i * 4, hashes[i]);
+  put_be32(out + n * 4, crc32_update(0, out, (size_t)n * 4));
+  return TILE_HASH_BLOCK((size_t)n);
+}
+
+int tile_hashes_unpack(const uint8_t* in, int n, uint32_t* hashes) {
+  if (crc32_update(0, in, (size_t)n * 4) != get_be32(in + n * 4))
+    return -1;
+  for (int i = 0; i < n; i++)
+    hashes[i] = get_be32(in + i * 4);
+  return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef _TILES_H_
+#define _TILES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Tile grid for delta transfers (LINK_FMT_DELTA).
+//
+// The 4bpp frame is cut into TILE_SIZE x TILE_SIZE pixel tiles, numbered row
+// by row from the top left. The Pico sends one CRC32 per tile of the frame it
+// already holds; the peer answers with a bitmap of the tiles that differ in
+// the new frame followed by those tiles, each as TILE_SIZE rows of
+// TILE_ROW_BYTES (see payload.h). Portable: shared with the host tests.
+// ---------------------------------------------------------------------------
+
+#define TILE_SIZE 32                    // pixels per tile side
+#define TILE_ROW_BYTES (TILE_SIZE / 2)  // 4bpp bytes per tile row
+#define TILE_BYTES (TILE_ROW_BYTES * TILE_SIZE)
+#define TILE_MAX 512                    // enough for 800x480 (375 tiles)
+#define TILE_BITMAP_BYTES(n) (((n) + 7) / 8)
+// Hash block on the wire: n big-endian CRC32s plus a CRC32 over them.
+#define TILE_HASH_BLOCK(n) ((n) * 4 + 4)
+
+typedef struct {
+  uint16_t cols;
+  uint16_t rows;
+  uint16_t count;      // cols * rows
+  uint16_t row_bytes;  // bytes per frame row
+} tile_grid_t;
+
+// Both dimensions must be multiples of TILE_SIZE. Returns 0, or -1 if the
+// frame does not tile or has more than TILE_MAX tiles.
+int tile_grid_init(tile_grid_t* g, int width, int height);
+
+// Copy tile i out of / into a frame.
+void tile_get(const tile_grid_t* g, const uint8_t* frame, int i,
+              uint8_t* tile);
+void tile_put(const tile_grid_t* g, uint8_t* frame, int i,
+              const uint8_t* tile);
+
+// CRC32 of every tile of frame into hashes[0..g->count).
+void tile_hashes(const tile_grid_t* g, const uint8_t* frame,
+                 uint32_t* hashes);
+
+// Hash block encode / decode. tile_hashes_unpack() returns 0, or -1 if the
+// block's own CRC does not match.
+size_t tile_hashes_pack(const uint32_t* hashes, int n, uint8_t* out);
+int tile_hashes_unpack(const uint8_t* in, int n, uint32_t* hashes);
+
+#endif
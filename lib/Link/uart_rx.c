@@ -0,0 +1,188 @@
+#include "uart_rx.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "pico/stdlib.h"
+#include "rx_ring.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+// Set to 0 to force the IRQ-driven fallback even when a DMA channel is free.
+#define UART_RX_USE_DMA 1
+
+// Ring size: 8 KB holds ~70 ms at 115200 baud and ~40 ms at 2 Mbaud. Must be
+// a power of two; the DMA ring wrap also requires the buffer to be aligned to
+// its size.
+#define UART_RX_RING_BITS 13
+#define UART_RX_RING_SIZE (1u << UART_RX_RING_BITS)
+
+// The DMA channel counts down from this; bytes written = start - remaining.
+// A session never gets close to 4 GB so the channel is never re-armed.
+#define UART_RX_DMA_COUNT 0xFFFFFFFFu
+
+// DMA ring: a backlog closer than this to UART_RX_RING_SIZE counts as an
+// overrun, since the channel may overwrite the oldest bytes while a read
+// copies them out. 512 bytes is 2.5 ms at 2 Mbaud, far longer than a copy.
+#define UART_RX_DMA_MARGIN 512
+
+// How long uart_rx_read() sleeps between ring checks while waiting.
+#define UART_RX_POLL_US 50
+
+// ---------------------------------------------------------------------------
+
+static uint8_t rx_buf[UART_RX_RING_SIZE]
+    __attribute__((aligned(UART_RX_RING_SIZE)));
+static rx_ring_t rx_ring;
+static uart_inst_t* rx_uart = NULL;
+static int rx_dma_chan = -1;
+static volatile uint32_t rx_hw_overruns = 0;
+static volatile uint32_t rx_hw_errors = 0;
+static uint32_t rx_gap_max_us = 0;
+static uint32_t rx_gaps = 0;
+static uint32_t rx_gap_threshold_us = UINT32_MAX;
+
+// IRQ fallback: drain the hardware FIFO into the ring.
+static void uart_rx_irq_handler(void) {
+  uart_hw_t* hw = uart_get_hw(rx_uart);
+  while (!(hw->fr & UART_UARTFR_RXFE_BITS)) {
+    uint32_t dr = hw->dr;
+    if (dr & UART_UARTDR_OE_BITS)
+      rx_hw_overruns++;
+    if (dr & (UART_UARTDR_BE_BITS | UART_UARTDR_PE_BITS | UART_UARTDR_FE_BITS))
+      rx_hw_errors++;
+    rx_ring_put(&rx_ring, (uint8_t)dr);
+  }
+}
+
+// Pull the DMA write position into the ring head and latch any UART error
+// flags. In IRQ mode the head is maintained by the handler instead.
+static void uart_rx_sync(void) {
+  if (rx_dma_chan >= 0) {
+    rx_ring.head =
+        UART_RX_DMA_COUNT - dma_channel_hw_addr(rx_dma_chan)->transfer_count;
+    uart_hw_t* hw = uart_get_hw(rx_uart);
+    uint32_t rsr = hw->rsr;
+    if (rsr) {
+      if (rsr & UART_UARTRSR_OE_BITS)
+        rx_hw_overruns++;
+      if (rsr & (UART_UARTRSR_BE_BITS | UART_UARTRSR_PE_BITS |
+                 UART_UARTRSR_FE_BITS))
+        rx_hw_errors++;
+      hw->rsr = 0;  // any write clears the error flags
+    }
+  }
+}
+
+void uart_rx_init(uart_inst_t* uart) {
+  rx_uart = uart;
+  rx_ring_init(&rx_ring, rx_buf, UART_RX_RING_SIZE);
+  rx_hw_overruns = 0;
+  rx_hw_errors = 0;
+
+  // Drop anything that arrived before the engine started.
+  while (uart_is_readable(uart))
+    (void)uart_get_hw(uart)->dr;
+
+  rx_dma_chan = UART_RX_USE_DMA ? dma_claim_unused_channel(false) : -1;
+  if (rx_dma_chan >= 0) {
+    dma_channel_config c = dma_channel_get_default_config(rx_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, UART_RX_RING_BITS);
+    channel_config_set_dreq(&c, uart_get_dreq(uart, false));
+    dma_channel_configure(rx_dma_chan, &c, rx_buf, &uart_get_hw(uart)->dr,
+                          UART_RX_DMA_COUNT, true);
+    rx_ring.margin = UART_RX_DMA_MARGIN;
+    return;
+  }
+
+  int irq = (uart == uart0) ? UART0_IRQ : UART1_IRQ;
+  irq_set_exclusive_handler(irq, uart_rx_irq_handler);
+  irq_set_enabled(irq, true);
+  uart_set_irq_enables(uart, true, false);
+}
+
+// A read waited on an empty ring from idle_since until now.
+static void uart_rx_note_gap(uint64_t idle_since) {
+  uint64_t us = time_us_64() - idle_since;
+  if (us > UINT32_MAX)
+    us = UINT32_MAX;
+  if (us > rx_gap_max_us)
+    rx_gap_max_us = (uint32_t)us;
+  if (us > rx_gap_threshold_us)
+    rx_gaps++;
+}
+
+size_t uart_rx_read(uint8_t* buf, size_t n, int32_t timeout_ms) {
+  size_t got = 0;
+  uint64_t idle_since = 0;  // 0: not waiting
+  absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+  for (;;) {
+    uart_rx_sync();
+    uint32_t k = rx_ring.lost ? 0 : rx_ring_read(&rx_ring, buf + got,
+                                                 (uint32_t)(n - got));
+    if (k && idle_since) {
+      uart_rx_note_gap(idle_since);
+      idle_since = 0;
+    }
+    got += k;
+    if (got >= n || rx_ring.lost || time_reached(deadline))
+      break;
+    if (!idle_since)
+      idle_since = time_us_64();
+    sleep_us(UART_RX_POLL_US);
+  }
+  if (idle_since)
+    uart_rx_note_gap(idle_since);
+  return got;
+}
+
+size_t uart_rx_read_some(uint8_t* buf, size_t n, int32_t timeout_ms) {
+  size_t got = 0;
+  uint64_t idle_since = 0;
+  absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+  for (;;) {
+    uart_rx_sync();
+    got = rx_ring.lost ? 0 : rx_ring_read(&rx_ring, buf, (uint32_t)n);
+    if (got || rx_ring.lost || time_reached(deadline))
+      break;
+    if (!idle_since)
+      idle_since = time_us_64();
+    sleep_us(UART_RX_POLL_US);
+  }
+  if (idle_since)
+    uart_rx_note_gap(idle_since);
+  return got;
+}
+
+void uart_rx_flush(void) {
+  uart_rx_sync();
+  rx_ring_drop(&rx_ring);
+}
+
+int uart_rx_lost(void) {
+  uart_rx_sync();
+  (void)rx_ring_pending(&rx_ring);
+  return rx_ring.lost;
+}
+
+void uart_rx_get_stats(uart_rx_stats_t* out) {
+  uart_rx_sync();
+  (void)rx_ring_pending(&rx_ring);  // folds any DMA lap into overruns
+  out->bytes = rx_ring.head;
+  out->overruns = rx_ring.overruns;
+  out->hw_overruns = rx_hw_overruns;
+  out->hw_errors = rx_hw_errors;
+  out->high_water = rx_ring.high_water;
+  out->dma = (rx_dma_chan >= 0);
+  out->max_gap_us = rx_gap_max_us;
+  out->gaps = rx_gaps;
+}
+
+void uart_rx_reset_gaps(uint32_t threshold_us) {
+  rx_gap_max_us = 0;
+  rx_gaps = 0;
+  rx_gap_threshold_us = threshold_us;
+}
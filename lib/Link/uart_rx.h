@@ -0,0 +1,51 @@
+#ifndef _UART_RX_H_
+#define _UART_RX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/uart.h"
+
+// Receive counters for the current session (since uart_rx_init).
+typedef struct {
+  uint32_t bytes;        // total bytes taken off the wire
+  uint32_t overruns;     // bytes lost because the ring was full
+  uint32_t hw_overruns;  // UART FIFO overrun flags seen (OE)
+  uint32_t hw_errors;    // framing / parity / break flags seen
+  uint32_t high_water;   // largest ring backlog observed by the reader
+  int dma;               // 1 = DMA ring, 0 = IRQ fallback
+  // Since the last uart_rx_reset_gaps(): the longest time a read waited with
+  // nothing new arriving, and how many such waits ran past the threshold.
+  // Seen at poll resolution, and only while a read is waiting.
+  uint32_t max_gap_us;
+  uint32_t gaps;
+} uart_rx_stats_t;
+
+// Start the receive engine on an already-initialised UART. Uses a DMA channel
+// writing into a ring buffer; falls back to the RX IRQ when no channel is free
+// (or UART_RX_USE_DMA is 0).
+void uart_rx_init(uart_inst_t* uart);
+
+// Read up to n bytes, waiting at most timeout_ms for them to arrive.
+// Returns the number of bytes copied (< n on timeout, or once bytes were
+// lost: see uart_rx_lost()).
+size_t uart_rx_read(uint8_t* buf, size_t n, int32_t timeout_ms);
+
+// Like uart_rx_read(), but returns as soon as any bytes are there (up to n).
+// A timeout of 0 only takes what has already arrived.
+size_t uart_rx_read_some(uint8_t* buf, size_t n, int32_t timeout_ms);
+
+// Nonzero once received bytes were lost (ring overrun) since uart_rx_init()
+// or the last uart_rx_flush(). The bytes read before the loss are intact;
+// nothing after it is handed out until the flush, so the stream the reader
+// sees has no silent hole.
+int uart_rx_lost(void);
+
+// Discard any bytes already received and clear uart_rx_lost().
+void uart_rx_flush(void);
+
+void uart_rx_get_stats(uart_rx_stats_t* out);
+
+// Clear max_gap_us / gaps; waits longer than threshold_us count as gaps.
+void uart_rx_reset_gaps(uint32_t threshold_us);
+
+#endif
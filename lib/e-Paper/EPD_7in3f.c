@@ -30,6 +30,20 @@
 ******************************************************************************/
 #include "EPD_7in3f.h"
 #include "pico/time.h"
+#include <string.h>
+
+// 1: frame data goes out in bursts (DC/CS set once, DEV_SPI_Write_nByte per
+// row or buffer). 0: the original one SendData() per byte, kept to compare
+// epd_phase_write_ms against.
+#ifndef EPD_7IN3F_BURST
+#define EPD_7IN3F_BURST 1
+#endif
+
+// Rows DisplayStream() asks its callback for at a time, per buffer (two
+// buffers: one is filled while the other goes out by DMA).
+#ifndef EPD_7IN3F_STREAM_ROWS
+#define EPD_7IN3F_STREAM_ROWS 4
+#endif
 
 // Phase timing exported so main.c can log them via PLOG.
 // Set by TurnOnDisplay after each refresh cycle.
@@ -38,6 +52,23 @@ volatile int32_t epd_phase_refresh_ms = -1;
 volatile int32_t epd_phase_power_off_ms = -1;
 volatile int epd_busy_pin_at_init = -1;
 
+// Time spent clocking frame data out since the last StreamBegin(), how much
+// of it the CPU sat waiting for, and how many bytes that was. Set by
+// StreamWrite() and the DMA completion of StreamWriteAsync().
+volatile int32_t epd_phase_write_ms = -1;
+volatile int32_t epd_write_wait_ms = -1;
+volatile uint32_t epd_write_bytes = 0;
+const int epd_write_burst = EPD_7IN3F_BURST;
+static volatile uint64_t epd_write_us = 0;
+static uint64_t epd_wait_us = 0;
+
+// A DMA burst is open: DC high, CS low until StreamSync().
+static int epd_burst_open = 0;
+static uint64_t epd_dma_t0;
+static void (*epd_dma_done)(void* Ctx) = NULL;
+static void* epd_dma_ctx = NULL;
+static UBYTE epd_rows[2][EPD_7IN3F_STREAM_ROWS * EPD_7IN3F_ROW_BYTES];
+
 // BUSY pin state sampled immediately after Reset() completes.
 // 0 = LOW (panel is resetting — good), 1 = HIGH (reset didn't take effect).
 volatile int epd_busy_after_reset = -1;
@@ -51,25 +82,102 @@ volatile int epd_busy_after_cmd04 = -1;
 volatile int epd_busy_before_cmd12 = -1;
 volatile int epd_busy_after_cmd12 = -1;
 
+// From the BUSY edge IRQ: us from DISPLAY_REFRESH to BUSY going LOW (-1: it
+// did not), and BUSY edges counted until the refresh wait ended.
+volatile int32_t epd_refresh_low_us = -1;
+volatile int32_t epd_refresh_edges = -1;
+
 // Global flag: incremented each time ReadBusyH force-releases due to timeout.
 // Checked from main.c to detect incomplete e-paper operations.
 volatile int epd_busy_force_released = 0;
 
+#if EPD_7IN3F_TRACE_LEN
+static EPD_7IN3F_TraceEntry epd_trace[EPD_7IN3F_TRACE_LEN];
+static UDOUBLE epd_trace_n = 0;  // entries ever started
+
 /******************************************************************************
-function :	Software reset
+function :	Start a trace entry; the previous one ends here
 parameter:
 ******************************************************************************/
-static void EPD_7IN3F_Reset(void) {
-  DEV_Digital_Write(EPD_RST_PIN, 1);
-  DEV_Delay_ms(20);
-  DEV_Digital_Write(EPD_RST_PIN, 0);
-  DEV_Delay_ms(50);  // 50ms reset pulse
-  DEV_Digital_Write(EPD_RST_PIN, 1);
-  DEV_Delay_ms(2);  // minimal delay before sampling BUSY
-  epd_busy_after_reset = DEV_Digital_Read(EPD_BUSY_PIN);
-  // If BUSY is LOW here, the panel responded to reset (good).
-  // If HIGH, the reset may not have taken effect.
-  DEV_Delay_ms(300);  // let panel oscillator start
+static void EPD_7IN3F_TraceBegin(UBYTE Kind, UBYTE Code) {
+  UBYTE busy = DEV_Digital_Read(EPD_BUSY_PIN);
+  if (epd_trace_n)
+    epd_trace[(epd_trace_n - 1) % EPD_7IN3F_TRACE_LEN].busy |= busy;
+  EPD_7IN3F_TraceEntry* e = &epd_trace[epd_trace_n++ % EPD_7IN3F_TRACE_LEN];
+  e->t_us = (uint32_t)time_us_64();
+  e->len = 0;
+  e->kind = Kind;
+  e->code = Code;
+  e->busy = (UBYTE)(busy << 1);
+  e->d0 = 0;
+}
+
+/******************************************************************************
+function :	Count Len data bytes against the current command
+parameter:
+******************************************************************************/
+static void EPD_7IN3F_TraceData(const UBYTE* Data, UDOUBLE Len) {
+  if (!epd_trace_n || !Len)
+    return;
+  EPD_7IN3F_TraceEntry* e = &epd_trace[(epd_trace_n - 1) % EPD_7IN3F_TRACE_LEN];
+  if (e->len == 0)
+    e->d0 = Data[0];
+  e->len += Len;
+}
+
+/******************************************************************************
+function :	Note how long the current BUSY wait took
+parameter:
+******************************************************************************/
+static void EPD_7IN3F_TraceWaited(uint64_t Us) {
+  epd_trace[(epd_trace_n - 1) % EPD_7IN3F_TRACE_LEN].len = (uint32_t)Us;
+}
+
+/******************************************************************************
+function :	Copy out the trace, oldest entry first
+parameter:
+******************************************************************************/
+UWORD EPD_7IN3F_TraceRead(EPD_7IN3F_TraceEntry* Out,
+                          UWORD Max,
+                          UDOUBLE* Lost) {
+  UDOUBLE n = epd_trace_n;
+  UDOUBLE first = (n > EPD_7IN3F_TRACE_LEN) ? n - EPD_7IN3F_TRACE_LEN : 0;
+  if (n - first > Max)
+    first = n - Max;
+  if (n)  // the last entry ends now
+    epd_trace[(n - 1) % EPD_7IN3F_TRACE_LEN].busy |=
+        DEV_Digital_Read(EPD_BUSY_PIN);
+  for (UDOUBLE i = first; i < n; i++)
+    Out[i - first] = epd_trace[i % EPD_7IN3F_TRACE_LEN];
+  *Lost = first;
+  return (UWORD)(n - first);
+}
+#else
+#define EPD_7IN3F_TraceBegin(Kind, Code) ((void)0)
+#define EPD_7IN3F_TraceData(Data, Len) ((void)0)
+#define EPD_7IN3F_TraceWaited(Us) ((void)(Us))
+
+UWORD EPD_7IN3F_TraceRead(EPD_7IN3F_TraceEntry* Out,
+                          UWORD Max,
+                          UDOUBLE* Lost) {
+  (void)Out;
+  (void)Max;
+  *Lost = 0;
+  return 0;
+}
+#endif
+
+/******************************************************************************
+function :	DEV_Wait_Pin() on BUSY, traced
+parameter:
+returns   : as DEV_Wait_Pin()
+******************************************************************************/
+static int EPD_7IN3F_WaitBusy(UBYTE Value, UDOUBLE timeout_ms) {
+  uint64_t t0 = time_us_64();
+  EPD_7IN3F_TraceBegin(EPD_7IN3F_TR_WAIT, Value);
+  int rc = DEV_Wait_Pin(EPD_BUSY_PIN, Value, timeout_ms);
+  EPD_7IN3F_TraceWaited(time_us_64() - t0);
+  return rc;
 }
 
 /******************************************************************************
@@ -78,6 +186,9 @@ parameter:
      Reg : Command register
 ******************************************************************************/
 static void EPD_7IN3F_SendCommand(UBYTE Reg) {
+  if (epd_burst_open)
+    EPD_7IN3F_StreamSync();
+  EPD_7IN3F_TraceBegin(EPD_7IN3F_TR_CMD, Reg);
   DEV_Digital_Write(EPD_DC_PIN, 0);
   DEV_Digital_Write(EPD_CS_PIN, 0);
   DEV_SPI_WriteByte(Reg);
@@ -90,6 +201,7 @@ parameter:
     Data : Write data
 ******************************************************************************/
 static void EPD_7IN3F_SendData(UBYTE Data) {
+  EPD_7IN3F_TraceData(&Data, 1);
   DEV_Digital_Write(EPD_DC_PIN, 1);
   DEV_Digital_Write(EPD_CS_PIN, 0);
   DEV_SPI_WriteByte(Data);
@@ -97,25 +209,96 @@ static void EPD_7IN3F_SendData(UBYTE Data) {
 }
 
 /******************************************************************************
-function :	Wait until the busy_pin goes LOW (with configurable timeout)
+function :	send a run of data bytes with DC and CS set once
+parameter:
+    Data : bytes to write
+    Len  : number of bytes
+******************************************************************************/
+static void EPD_7IN3F_SendDataBurst(const UBYTE* Data, UDOUBLE Len) {
+#if EPD_7IN3F_BURST
+  EPD_7IN3F_TraceData(Data, Len);
+  DEV_Digital_Write(EPD_DC_PIN, 1);
+  DEV_Digital_Write(EPD_CS_PIN, 0);
+  DEV_SPI_Write_nByte((UBYTE*)Data, Len);
+  DEV_Digital_Write(EPD_CS_PIN, 1);
+#else
+  for (UDOUBLE i = 0; i < Len; i++) {
+    EPD_7IN3F_SendData(Data[i]);
+  }
+#endif
+}
+
+// Register setup sent by Init() and ReloadConfig(), kept in flash: command,
+// payload length, payload, repeated. Another panel variant is another table.
+static const UBYTE EPD_7IN3F_InitSeq[] = {
+    0xAA, 6, 0x49, 0x55, 0x20, 0x08, 0x09, 0x18,  // CMDH
+    0x01, 6, 0x3F, 0x00, 0x32, 0x2A, 0x0E, 0x2A,
+    0x00, 2, 0x5F, 0x69,
+    0x03, 4, 0x00, 0x54, 0x00, 0x44,
+    0x05, 4, 0x40, 0x1F, 0x1F, 0x2C,
+    0x06, 4, 0x6F, 0x1F, 0x1F, 0x22,
+    0x08, 4, 0x6F, 0x1F, 0x1F, 0x22,
+    0x13, 2, 0x00, 0x04,  // IPC
+    0x30, 1, 0x3C,
+    0x41, 1, 0x00,  // TSE
+    0x50, 1, 0x3F,
+    0x60, 2, 0x02, 0x00,
+    0x61, 4, 0x03, 0x20, 0x01, 0xE0,
+    0x82, 1, 0x1E,
+    0x84, 1, 0x00,
+    0x86, 1, 0x00,  // AGID
+    0xE3, 1, 0x2F,
+    0xE0, 1, 0x00,  // CCSET
+    0xE6, 1, 0x00,  // TSSET
+};
+
+/******************************************************************************
+function :	send a command table (command, length, payload; repeated), each
+            payload as one burst
+parameter:
+     Seq : table
+     Len : table size in bytes
+******************************************************************************/
+static void EPD_7IN3F_SendSequence(const UBYTE* Seq, UDOUBLE Len) {
+  UDOUBLE i = 0;
+  while (i + 2 <= Len) {
+    UBYTE n = Seq[i + 1];
+    EPD_7IN3F_SendCommand(Seq[i]);
+    if (n) {
+      EPD_7IN3F_SendDataBurst(Seq + i + 2, n);
+    }
+    i += 2 + n;
+  }
+}
+
+/******************************************************************************
+function :	When BUSY last rose, if that was at or after t0 (us since boot);
+            otherwise now (it was already HIGH, or never rose)
+parameter:
+******************************************************************************/
+static uint64_t EPD_7IN3F_BusyRoseAt(uint64_t t0) {
+  uint64_t r = dev_busy_rise_us;
+  return (r >= t0) ? r : time_us_64();
+}
+
+/******************************************************************************
+function :	Wait until the busy_pin goes HIGH (with configurable timeout).
+            The core sleeps until the BUSY edge IRQ or the timeout.
 parameter:
   timeout_ms : maximum wait in milliseconds
 returns   : 0 on success, -1 on timeout
 ******************************************************************************/
 static int EPD_7IN3F_ReadBusyH_timeout(int timeout_ms) {
-  int cnt = 0;
-  int limit = timeout_ms / 10;
+  uint64_t t0 = time_us_64();
   printf("e-Paper busy H (timeout %dms)\r\n", timeout_ms);
-  while (!DEV_Digital_Read(EPD_BUSY_PIN)) {  // LOW: busy, HIGH: idle
-    DEV_Delay_ms(10);
-    cnt++;
-    if (cnt > limit) {
-      printf("e-Paper busy H TIMEOUT after %d0 ms\r\n", cnt);
-      epd_busy_force_released++;
-      return -1;
-    }
+  // LOW: busy, HIGH: idle
+  if (EPD_7IN3F_WaitBusy(1, (UDOUBLE)timeout_ms) != 0) {
+    printf("e-Paper busy H TIMEOUT after %d ms\r\n", timeout_ms);
+    epd_busy_force_released++;
+    return -1;
   }
-  printf("e-Paper busy H release after %d0 ms\r\n", cnt);
+  printf("e-Paper busy H release after %lu us\r\n",
+         (unsigned long)(EPD_7IN3F_BusyRoseAt(t0) - t0));
   return 0;
 }
 
@@ -136,29 +319,30 @@ returns   : 0 on success, -1 never went LOW, -2 never went HIGH
 ******************************************************************************/
 static int EPD_7IN3F_WaitBusyTransition(int low_timeout_ms,
                                         int high_timeout_ms) {
-  int cnt = 0;
-  int low_limit = low_timeout_ms / 10;
+  uint64_t t0 = time_us_64();
   // Phase 1: wait for BUSY to go LOW (panel acknowledges command)
-  while (DEV_Digital_Read(EPD_BUSY_PIN)) {  // HIGH = idle; wait for LOW
-    DEV_Delay_ms(10);
-    cnt++;
-    if (cnt > low_limit) {
-      printf("WaitBusyTransition: never went LOW after %d0 ms\r\n", cnt);
-      return -1;  // panel never started processing
-    }
+  if (EPD_7IN3F_WaitBusy(0, (UDOUBLE)low_timeout_ms) != 0) {
+    printf("WaitBusyTransition: never went LOW after %d ms\r\n",
+           low_timeout_ms);
+    return -1;  // panel never started processing
   }
-  printf("WaitBusyTransition: went LOW after %d0 ms\r\n", cnt);
+  uint64_t fell = dev_busy_fall_us;
+  printf("WaitBusyTransition: went LOW after %lu us\r\n",
+         (unsigned long)((fell >= t0 ? fell : time_us_64()) - t0));
   // Phase 2: now wait for BUSY to go HIGH (panel finished)
   return EPD_7IN3F_ReadBusyH_timeout(high_timeout_ms);
 }
 static void EPD_7IN3F_ReadBusyL(void) {
   printf("e-Paper busy L\r\n");
-  while (DEV_Digital_Read(EPD_BUSY_PIN)) {  // LOW: idle, HIGH: busy
-    DEV_Delay_ms(5);
-  }
+  EPD_7IN3F_WaitBusy(0, UINT32_MAX);  // LOW: idle, HIGH: busy
   printf("e-Paper busy L release\r\n");
 }
 
+// ms from t0 to BUSY's rising edge (now if it did not rise after t0).
+static int32_t EPD_7IN3F_MsToIdle(uint64_t t0) {
+  return (int32_t)((EPD_7IN3F_BusyRoseAt(t0) - t0) / 1000);
+}
+
 /******************************************************************************
 function :	Turn On Display (abort-safe: stops sending commands on timeout)
 parameter:
@@ -166,20 +350,19 @@ returns   : 0 on success, -1 POWER_ON timeout, -2 REFRESH timeout,
             -3 POWER_OFF timeout
 ******************************************************************************/
 static int EPD_7IN3F_TurnOnDisplay(void) {
-  absolute_time_t t0;
+  uint64_t t0;
 
   // POWER_ON must be sent right before REFRESH, matching the original
   // Waveshare driver sequence.  Even if PowerOn() was called earlier
   // (before data write), the panel needs it again here.
   // Use ReadBusyH (not WaitBusyTransition) — if already powered,
   // BUSY stays HIGH and ReadBusyH returns instantly (harmless).
-  t0 = get_absolute_time();
+  t0 = time_us_64();
   epd_busy_before_cmd04 = DEV_Digital_Read(EPD_BUSY_PIN);
   EPD_7IN3F_SendCommand(0x04);  // POWER_ON
   epd_busy_after_cmd04 = DEV_Digital_Read(EPD_BUSY_PIN);
   int rc = EPD_7IN3F_ReadBusyH_timeout(10000);
-  epd_phase_power_on_ms =
-      (int32_t)(absolute_time_diff_us(t0, get_absolute_time()) / 1000);
+  epd_phase_power_on_ms = EPD_7IN3F_MsToIdle(t0);
   if (rc != 0) {
     epd_phase_refresh_ms = -1;
     epd_phase_power_off_ms = -1;
@@ -187,32 +370,33 @@ static int EPD_7IN3F_TurnOnDisplay(void) {
   }
 
   // DISPLAY_REFRESH — takes ~31s for 7-color.
-  t0 = get_absolute_time();
+  t0 = time_us_64();
+  UDOUBLE edges0 = dev_busy_rises + dev_busy_falls;
   epd_busy_before_cmd12 = DEV_Digital_Read(EPD_BUSY_PIN);
   EPD_7IN3F_SendCommand(0x12);  // DISPLAY_REFRESH
   EPD_7IN3F_SendData(0x00);
   epd_busy_after_cmd12 = DEV_Digital_Read(EPD_BUSY_PIN);
   rc = EPD_7IN3F_WaitBusyTransition(2000, 60000);
-  epd_phase_refresh_ms =
-      (int32_t)(absolute_time_diff_us(t0, get_absolute_time()) / 1000);
+  epd_phase_refresh_ms = EPD_7IN3F_MsToIdle(t0);
+  epd_refresh_edges = (int32_t)(dev_busy_rises + dev_busy_falls - edges0);
+  epd_refresh_low_us =
+      (dev_busy_fall_us >= t0) ? (int32_t)(dev_busy_fall_us - t0) : -1;
   if (rc != 0) {
     // Refresh timed out — still send POWER_OFF to protect panel from HV damage
-    t0 = get_absolute_time();
+    t0 = time_us_64();
     EPD_7IN3F_SendCommand(0x02);  // POWER_OFF
     EPD_7IN3F_SendData(0x00);
     EPD_7IN3F_ReadBusyH_timeout(10000);  // best effort
-    epd_phase_power_off_ms =
-        (int32_t)(absolute_time_diff_us(t0, get_absolute_time()) / 1000);
+    epd_phase_power_off_ms = EPD_7IN3F_MsToIdle(t0);
     return -2;
   }
 
   // POWER_OFF — should complete in ~150ms.  10s timeout.
-  t0 = get_absolute_time();
+  t0 = time_us_64();
   EPD_7IN3F_SendCommand(0x02);  // POWER_OFF
   EPD_7IN3F_SendData(0X00);
   rc = EPD_7IN3F_ReadBusyH_timeout(10000);
-  epd_phase_power_off_ms =
-      (int32_t)(absolute_time_diff_us(t0, get_absolute_time()) / 1000);
+  epd_phase_power_off_ms = EPD_7IN3F_MsToIdle(t0);
   if (rc != 0) {
     return -3;  // POWER_OFF timeout — panel stays powered
   }
@@ -220,112 +404,186 @@ static int EPD_7IN3F_TurnOnDisplay(void) {
   return 0;
 }
 
+// Steps of Init() + PowerOn() for PreparePoll(): each one is short and
+// leaves the time the next may run at in epd_prep_at.
+enum {
+  EPD_PREP_IDLE,
+  EPD_PREP_RST_LOW,      // RST high 20 ms, then the 50 ms reset pulse
+  EPD_PREP_RST_HIGH,
+  EPD_PREP_RST_SAMPLE,   // 2 ms after the pulse
+  EPD_PREP_RST_SETTLE,   // 300 ms for the panel oscillator
+  EPD_PREP_WAIT_INIT,    // BUSY HIGH after reset (30 s)
+  EPD_PREP_REGS,         // 30 ms later: register table, then POWER_ON
+  EPD_PREP_WAIT_PON,     // BUSY HIGH after POWER_ON (10 s)
+};
+static int epd_prep = EPD_PREP_IDLE;
+static int epd_prep_pon;
+static uint64_t epd_prep_at;     // next step not before (time_us_64())
+static uint64_t epd_prep_t0;     // BUSY wait started
+static uint64_t epd_prep_limit;  // ... and gives up
+
 /******************************************************************************
-function :	Initialize the e-Paper register
+function :	Start a BUSY HIGH wait of PreparePoll()
 parameter:
-returns   : 0 on success, -1 if panel didn't respond after reset
 ******************************************************************************/
-int EPD_7IN3F_Init(void) {
-  epd_busy_pin_at_init = DEV_Digital_Read(EPD_BUSY_PIN);
-  EPD_7IN3F_Reset();
-  // Reset() already includes a 300ms post-reset delay.  During that time
-  // the panel goes BUSY LOW (resetting) then back HIGH (ready).  So by
-  // the time we get here BUSY is already HIGH — just confirm it is.
-  // Do NOT use WaitBusyTransition here: the LOW→HIGH transition already
-  // happened inside Reset()'s 300ms delay.  Waiting for another LOW
-  // would time out every time.
-  if (EPD_7IN3F_ReadBusyH_timeout(30000) != 0) {
-    printf("Init: ReadBusyH failed, busy_after_reset=%d\r\n",
-           epd_busy_after_reset);
-    return -1;  // panel didn't come up after reset
-  }
-  DEV_Delay_ms(30);
-
-  EPD_7IN3F_SendCommand(0xAA);  // CMDH
-  EPD_7IN3F_SendData(0x49);
-  EPD_7IN3F_SendData(0x55);
-  EPD_7IN3F_SendData(0x20);
-  EPD_7IN3F_SendData(0x08);
-  EPD_7IN3F_SendData(0x09);
-  EPD_7IN3F_SendData(0x18);
-
-  EPD_7IN3F_SendCommand(0x01);
-  EPD_7IN3F_SendData(0x3F);
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x32);
-  EPD_7IN3F_SendData(0x2A);
-  EPD_7IN3F_SendData(0x0E);
-  EPD_7IN3F_SendData(0x2A);
-
-  EPD_7IN3F_SendCommand(0x00);
-  EPD_7IN3F_SendData(0x5F);
-  EPD_7IN3F_SendData(0x69);
-
-  EPD_7IN3F_SendCommand(0x03);
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x54);
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x44);
-
-  EPD_7IN3F_SendCommand(0x05);
-  EPD_7IN3F_SendData(0x40);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x2C);
-
-  EPD_7IN3F_SendCommand(0x06);
-  EPD_7IN3F_SendData(0x6F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x22);
-
-  EPD_7IN3F_SendCommand(0x08);
-  EPD_7IN3F_SendData(0x6F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x22);
-
-  EPD_7IN3F_SendCommand(0x13);  // IPC
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x04);
-
-  EPD_7IN3F_SendCommand(0x30);
-  EPD_7IN3F_SendData(0x3C);
-
-  EPD_7IN3F_SendCommand(0x41);  // TSE
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0x50);
-  EPD_7IN3F_SendData(0x3F);
-
-  EPD_7IN3F_SendCommand(0x60);
-  EPD_7IN3F_SendData(0x02);
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0x61);
-  EPD_7IN3F_SendData(0x03);
-  EPD_7IN3F_SendData(0x20);
-  EPD_7IN3F_SendData(0x01);
-  EPD_7IN3F_SendData(0xE0);
-
-  EPD_7IN3F_SendCommand(0x82);
-  EPD_7IN3F_SendData(0x1E);
+static void EPD_7IN3F_PrepareWait(int State, int timeout_ms) {
+  printf("e-Paper busy H (timeout %dms)\r\n", timeout_ms);
+  EPD_7IN3F_TraceBegin(EPD_7IN3F_TR_WAIT, 1);
+  epd_prep_t0 = time_us_64();
+  epd_prep_limit = epd_prep_t0 + (uint64_t)timeout_ms * 1000;
+  epd_prep_at = 0;
+  epd_prep = State;
+}
 
-  EPD_7IN3F_SendCommand(0x84);
-  EPD_7IN3F_SendData(0x00);
+/******************************************************************************
+function :	Check on the BUSY HIGH wait of PreparePoll()
+parameter:
+returns   : 1 still waiting, 0 BUSY is HIGH, -1 timed out
+******************************************************************************/
+static int EPD_7IN3F_PrepareWaited(void) {
+  uint64_t now = time_us_64();
+  if (DEV_Digital_Read(EPD_BUSY_PIN)) {
+    EPD_7IN3F_TraceWaited(now - epd_prep_t0);
+    printf("e-Paper busy H release after %lu us\r\n",
+           (unsigned long)(EPD_7IN3F_BusyRoseAt(epd_prep_t0) - epd_prep_t0));
+    return 0;
+  }
+  if (now < epd_prep_limit)
+    return 1;
+  EPD_7IN3F_TraceWaited(now - epd_prep_t0);
+  printf("e-Paper busy H TIMEOUT after %lu ms\r\n",
+         (unsigned long)((epd_prep_limit - epd_prep_t0) / 1000));
+  epd_busy_force_released++;
+  epd_prep = EPD_PREP_IDLE;
+  return -1;
+}
 
-  EPD_7IN3F_SendCommand(0x86);  // AGID
-  EPD_7IN3F_SendData(0x00);
+/******************************************************************************
+function :	Start Init() (and PowerOn() if PowerOn) in the background
+parameter:
+  PowerOn : also switch the booster on once the registers are loaded
+******************************************************************************/
+void EPD_7IN3F_PrepareBegin(int PowerOn) {
+  epd_busy_pin_at_init = DEV_Digital_Read(EPD_BUSY_PIN);
+  epd_prep_pon = PowerOn;
+  EPD_7IN3F_TraceBegin(EPD_7IN3F_TR_RESET, 0);
+  DEV_Digital_Write(EPD_RST_PIN, 1);
+  epd_prep_at = DEV_Deadline_ms(20);
+  epd_prep = EPD_PREP_RST_LOW;
+}
 
-  EPD_7IN3F_SendCommand(0xE3);
-  EPD_7IN3F_SendData(0x2F);
+/******************************************************************************
+function :	Run the steps of PrepareBegin() that are due
+parameter:
+   WakeUs : while running, when the next step is due (time_us_64())
+returns   : 1 running, 0 ready, -1 no BUSY after reset, -2 POWER_ON
+            timeout (the panel is left as after a failed Init()/PowerOn())
+******************************************************************************/
+int EPD_7IN3F_PreparePoll(uint64_t* WakeUs) {
+  for (;;) {
+    uint64_t now = time_us_64();
+    if (epd_prep == EPD_PREP_IDLE)
+      return 0;
+    if (now < epd_prep_at) {
+      *WakeUs = epd_prep_at;
+      return 1;
+    }
+    int rc;
+    switch (epd_prep) {
+      case EPD_PREP_RST_LOW:
+        DEV_Digital_Write(EPD_RST_PIN, 0);
+        epd_prep_at = DEV_Deadline_ms(50);  // 50ms reset pulse
+        epd_prep = EPD_PREP_RST_HIGH;
+        break;
+      case EPD_PREP_RST_HIGH:
+        DEV_Digital_Write(EPD_RST_PIN, 1);
+        epd_prep_at = DEV_Deadline_ms(2);  // minimal delay before sampling
+        epd_prep = EPD_PREP_RST_SAMPLE;
+        break;
+      case EPD_PREP_RST_SAMPLE:
+        // If BUSY is LOW here, the panel responded to reset (good).
+        // If HIGH, the reset may not have taken effect.
+        epd_busy_after_reset = DEV_Digital_Read(EPD_BUSY_PIN);
+        epd_prep_at = DEV_Deadline_ms(300);  // let panel oscillator start
+        epd_prep = EPD_PREP_RST_SETTLE;
+        break;
+      case EPD_PREP_RST_SETTLE:
+        // During those 300ms the panel goes BUSY LOW (resetting) then back
+        // HIGH (ready), so just confirm it is HIGH. Do NOT wait for a
+        // LOW->HIGH transition here: it already happened and waiting for
+        // another LOW would time out every time.
+        EPD_7IN3F_PrepareWait(EPD_PREP_WAIT_INIT, 30000);
+        break;
+      case EPD_PREP_WAIT_INIT:
+        rc = EPD_7IN3F_PrepareWaited();
+        if (rc < 0) {
+          printf("Init: ReadBusyH failed, busy_after_reset=%d\r\n",
+                 epd_busy_after_reset);
+          return -1;  // panel didn't come up after reset
+        }
+        if (rc) {
+          *WakeUs = now + 1000;
+          return 1;
+        }
+        epd_prep_at = DEV_Deadline_ms(30);
+        epd_prep = EPD_PREP_REGS;
+        break;
+      case EPD_PREP_REGS:
+        EPD_7IN3F_SendSequence(EPD_7IN3F_InitSeq, sizeof(EPD_7IN3F_InitSeq));
+        if (!epd_prep_pon) {
+          epd_prep = EPD_PREP_IDLE;
+          return 0;
+        }
+        // As PowerOn(): only wait for HIGH, POWER_ON need not pulse BUSY.
+        epd_busy_before_cmd04 = DEV_Digital_Read(EPD_BUSY_PIN);
+        EPD_7IN3F_SendCommand(0x04);  // POWER_ON
+        epd_busy_after_cmd04 = DEV_Digital_Read(EPD_BUSY_PIN);
+        EPD_7IN3F_PrepareWait(EPD_PREP_WAIT_PON, 10000);
+        break;
+      case EPD_PREP_WAIT_PON:
+        rc = EPD_7IN3F_PrepareWaited();
+        if (rc < 0)
+          return -2;
+        if (rc) {
+          *WakeUs = now + 1000;
+          return 1;
+        }
+        epd_prep = EPD_PREP_IDLE;
+        return 0;
+    }
+  }
+}
 
-  EPD_7IN3F_SendCommand(0xE0);  // CCSET
-  EPD_7IN3F_SendData(0x00);
+/******************************************************************************
+function :	Block until PrepareBegin() is done, sleeping between steps
+parameter:
+returns   : as PreparePoll()
+******************************************************************************/
+int EPD_7IN3F_PrepareFinish(void) {
+  uint64_t wake;
+  int rc;
+  while ((rc = EPD_7IN3F_PreparePoll(&wake)) == 1) {
+    uint64_t now = time_us_64();
+    if (epd_prep == EPD_PREP_WAIT_INIT || epd_prep == EPD_PREP_WAIT_PON) {
+      // LOW: busy, HIGH: idle; sleeps until the edge
+      if (epd_prep_limit > now)
+        DEV_Wait_Pin(EPD_BUSY_PIN, 1,
+                     (UDOUBLE)((epd_prep_limit - now + 999) / 1000));
+    } else if (wake > now) {
+      sleep_us(wake - now);
+    }
+  }
+  return rc;
+}
 
-  EPD_7IN3F_SendCommand(0xE6);  // TSSET
-  EPD_7IN3F_SendData(0x00);
-  return 0;
+/******************************************************************************
+function :	Initialize the e-Paper register
+parameter:
+returns   : 0 on success, -1 if panel didn't respond after reset
+******************************************************************************/
+int EPD_7IN3F_Init(void) {
+  EPD_7IN3F_PrepareBegin(0);
+  return EPD_7IN3F_PrepareFinish();
 }
 
 /******************************************************************************
@@ -337,90 +595,7 @@ register sequence as Init() minus Reset() + ReadBusyH(), so the BUSY pin is not
 disturbed. parameter:
 ******************************************************************************/
 void EPD_7IN3F_ReloadConfig(void) {
-  EPD_7IN3F_SendCommand(0xAA);  // CMDH
-  EPD_7IN3F_SendData(0x49);
-  EPD_7IN3F_SendData(0x55);
-  EPD_7IN3F_SendData(0x20);
-  EPD_7IN3F_SendData(0x08);
-  EPD_7IN3F_SendData(0x09);
-  EPD_7IN3F_SendData(0x18);
-
-  EPD_7IN3F_SendCommand(0x01);
-  EPD_7IN3F_SendData(0x3F);
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x32);
-  EPD_7IN3F_SendData(0x2A);
-  EPD_7IN3F_SendData(0x0E);
-  EPD_7IN3F_SendData(0x2A);
-
-  EPD_7IN3F_SendCommand(0x00);
-  EPD_7IN3F_SendData(0x5F);
-  EPD_7IN3F_SendData(0x69);
-
-  EPD_7IN3F_SendCommand(0x03);
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x54);
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x44);
-
-  EPD_7IN3F_SendCommand(0x05);
-  EPD_7IN3F_SendData(0x40);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x2C);
-
-  EPD_7IN3F_SendCommand(0x06);
-  EPD_7IN3F_SendData(0x6F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x22);
-
-  EPD_7IN3F_SendCommand(0x08);
-  EPD_7IN3F_SendData(0x6F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x1F);
-  EPD_7IN3F_SendData(0x22);
-
-  EPD_7IN3F_SendCommand(0x13);  // IPC
-  EPD_7IN3F_SendData(0x00);
-  EPD_7IN3F_SendData(0x04);
-
-  EPD_7IN3F_SendCommand(0x30);
-  EPD_7IN3F_SendData(0x3C);
-
-  EPD_7IN3F_SendCommand(0x41);  // TSE
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0x50);
-  EPD_7IN3F_SendData(0x3F);
-
-  EPD_7IN3F_SendCommand(0x60);
-  EPD_7IN3F_SendData(0x02);
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0x61);
-  EPD_7IN3F_SendData(0x03);
-  EPD_7IN3F_SendData(0x20);
-  EPD_7IN3F_SendData(0x01);
-  EPD_7IN3F_SendData(0xE0);
-
-  EPD_7IN3F_SendCommand(0x82);
-  EPD_7IN3F_SendData(0x1E);
-
-  EPD_7IN3F_SendCommand(0x84);
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0x86);  // AGID
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0xE3);
-  EPD_7IN3F_SendData(0x2F);
-
-  EPD_7IN3F_SendCommand(0xE0);  // CCSET
-  EPD_7IN3F_SendData(0x00);
-
-  EPD_7IN3F_SendCommand(0xE6);  // TSSET
-  EPD_7IN3F_SendData(0x00);
+  EPD_7IN3F_SendSequence(EPD_7IN3F_InitSeq, sizeof(EPD_7IN3F_InitSeq));
 }
 
 /******************************************************************************
@@ -440,52 +615,52 @@ int EPD_7IN3F_PowerOn(void) {
   return EPD_7IN3F_ReadBusyH_timeout(10000);
 }
 
+/******************************************************************************
+function :	DisplayStream() callback of Clear(): every row in one color
+parameter:
+******************************************************************************/
+static int EPD_7IN3F_ClearRows(UBYTE* Rows, UWORD Y, UWORD Count, void* Ctx) {
+  (void)Y;
+  UBYTE color = *(const UBYTE*)Ctx;
+  memset(Rows, (color << 4) | color, (size_t)Count * EPD_7IN3F_ROW_BYTES);
+  return 0;
+}
+
 /******************************************************************************
 function :	Clear screen
 parameter:
 ******************************************************************************/
 void EPD_7IN3F_Clear(UBYTE color) {
-  UWORD Width, Height;
-  Width = (EPD_7IN3F_WIDTH % 2 == 0) ? (EPD_7IN3F_WIDTH / 2)
-                                     : (EPD_7IN3F_WIDTH / 2 + 1);
-  Height = EPD_7IN3F_HEIGHT;
-
-  EPD_7IN3F_SendCommand(0x10);
-  for (UWORD j = 0; j < Height; j++) {
-    for (UWORD i = 0; i < Width; i++) {
-      EPD_7IN3F_SendData((color << 4) | color);
-    }
-  }
-
-  EPD_7IN3F_TurnOnDisplay();
+  EPD_7IN3F_DisplayStream(EPD_7IN3F_ClearRows, &color);
 }
 
 /******************************************************************************
-function :	show 7 kind of color block
+function :	DisplayStream() callback of Show7Block(): blocks 0-3 across the
+            top half, blocks 4-7 across the bottom half, 100 bytes each
 parameter:
 ******************************************************************************/
-void EPD_7IN3F_Show7Block(void) {
-  unsigned long i, j, k;
+static int EPD_7IN3F_BlockRows(UBYTE* Rows, UWORD Y, UWORD Count, void* Ctx) {
   unsigned char const Color_seven[8] = {
       EPD_7IN3F_BLACK, EPD_7IN3F_BLUE,   EPD_7IN3F_GREEN, EPD_7IN3F_ORANGE,
       EPD_7IN3F_RED,   EPD_7IN3F_YELLOW, EPD_7IN3F_WHITE, EPD_7IN3F_WHITE};
-
-  EPD_7IN3F_SendCommand(0x10);
-  for (i = 0; i < 240; i++) {
-    for (k = 0; k < 4; k++) {
-      for (j = 0; j < 100; j++) {
-        EPD_7IN3F_SendData((Color_seven[k] << 4) | Color_seven[k]);
-      }
-    }
-  }
-  for (i = 0; i < 240; i++) {
-    for (k = 4; k < 8; k++) {
-      for (j = 0; j < 100; j++) {
-        EPD_7IN3F_SendData((Color_seven[k] << 4) | Color_seven[k]);
-      }
+  (void)Ctx;
+  for (UWORD j = 0; j < Count; j++) {
+    UBYTE* Row = Rows + (UDOUBLE)j * EPD_7IN3F_ROW_BYTES;
+    unsigned long i = (Y + j < EPD_7IN3F_HEIGHT / 2) ? 0 : 1;
+    for (unsigned long k = 0; k < 4; k++) {
+      UBYTE c = Color_seven[i * 4 + k];
+      memset(Row + k * 100, (c << 4) | c, 100);
     }
   }
-  EPD_7IN3F_TurnOnDisplay();
+  return 0;
+}
+
+/******************************************************************************
+function :	show 7 kind of color block
+parameter:
+******************************************************************************/
+void EPD_7IN3F_Show7Block(void) {
+  EPD_7IN3F_DisplayStream(EPD_7IN3F_BlockRows, NULL);
 }
 
 /******************************************************************************
@@ -493,32 +668,163 @@ function :	Sends the image buffer in RAM to e-Paper and displays
 parameter:
 ******************************************************************************/
 int EPD_7IN3F_Display(UBYTE* Image) {
-  UWORD Width, Height;
-  Width = (EPD_7IN3F_WIDTH % 2 == 0) ? (EPD_7IN3F_WIDTH / 2)
-                                     : (EPD_7IN3F_WIDTH / 2 + 1);
-  Height = EPD_7IN3F_HEIGHT;
+  EPD_7IN3F_StreamBegin();
+  EPD_7IN3F_StreamWrite(Image,
+                        (UDOUBLE)EPD_7IN3F_ROW_BYTES * EPD_7IN3F_HEIGHT);
+  return EPD_7IN3F_StreamEnd();
+}
 
-  EPD_7IN3F_SendCommand(0x10);
-  for (UWORD j = 0; j < Height; j++) {
-    for (UWORD i = 0; i < Width; i++) {
-      EPD_7IN3F_SendData(Image[i + j * Width]);
+/******************************************************************************
+function :	Write a frame pulled from Fill a few rows at a time, then
+            refresh. Fill(Rows, Y, Count, Ctx) packs rows Y..Y+Count-1 into
+            Rows (EPD_7IN3F_ROW_BYTES each); while it does, the rows before
+            go out by DMA. A nonzero return from Fill stops the write
+            without a refresh.
+parameter:
+returns   : as TurnOnDisplay(), or -4 when Fill stopped the write
+******************************************************************************/
+int EPD_7IN3F_DisplayStream(EPD_7IN3F_RowFn Fill, void* Ctx) {
+  int n = 0;
+
+  EPD_7IN3F_StreamBegin();
+  for (UWORD y = 0; y < EPD_7IN3F_HEIGHT; y += EPD_7IN3F_STREAM_ROWS) {
+    UWORD count = EPD_7IN3F_HEIGHT - y;
+    if (count > EPD_7IN3F_STREAM_ROWS)
+      count = EPD_7IN3F_STREAM_ROWS;
+    // Free: its last DMA was waited for by the StreamWriteAsync() after it.
+    UBYTE* Rows = epd_rows[n++ & 1];
+    if (Fill(Rows, y, count, Ctx) != 0) {
+      EPD_7IN3F_StreamSync();
+      return -4;
     }
+    EPD_7IN3F_StreamWriteAsync(Rows, (UDOUBLE)count * EPD_7IN3F_ROW_BYTES,
+                               NULL, NULL);
   }
+  return EPD_7IN3F_StreamEnd();
+}
+
+/******************************************************************************
+function :	Open the frame write (DATA_START_TRANSMISSION 0x10). The panel
+            RAM fills in order from the top left with the bytes passed to
+            StreamWrite(); nothing is shown until StreamEnd(). Calling it
+            again restarts the write at the top left, so an aborted stream
+            can simply be started over.
+parameter:
+******************************************************************************/
+void EPD_7IN3F_StreamBegin(void) {
+  EPD_7IN3F_SendCommand(0x10);
+  epd_write_us = 0;
+  epd_wait_us = 0;
+  epd_write_bytes = 0;
+  epd_phase_write_ms = 0;
+  epd_write_wait_ms = 0;
+}
+
+/******************************************************************************
+function :	Append Len bytes (two pixels each) to the frame being written,
+            as one burst
+parameter:
+******************************************************************************/
+void EPD_7IN3F_StreamWrite(const UBYTE* Data, UDOUBLE Len) {
+  EPD_7IN3F_StreamSync();
+  uint64_t t0 = time_us_64();
+  EPD_7IN3F_SendDataBurst(Data, Len);
+  uint64_t us = time_us_64() - t0;
+  epd_write_us += us;
+  epd_wait_us += us;
+  epd_write_bytes += Len;
+  epd_phase_write_ms = (int32_t)(epd_write_us / 1000);
+  epd_write_wait_ms = (int32_t)(epd_wait_us / 1000);
+}
+
+/******************************************************************************
+function :	DMA completion (IRQ context): account the burst, hand the buffer
+            back
+parameter:
+******************************************************************************/
+static void EPD_7IN3F_DMADone(void* Ctx) {
+  (void)Ctx;
+  epd_write_us += time_us_64() - epd_dma_t0;
+  epd_phase_write_ms = (int32_t)(epd_write_us / 1000);
+  if (epd_dma_done)
+    epd_dma_done(epd_dma_ctx);
+}
+
+/******************************************************************************
+function :	Append Len bytes to the frame by DMA and return at once. Data
+            must stay untouched until Done(Ctx) runs (from the DMA IRQ; Done
+            may be NULL) or the next StreamWriteAsync()/StreamSync() returns,
+            so two buffers used in turn can be refilled while the other one
+            goes out. Waits for the previous piece first; CS stays low
+            across pieces until StreamSync(), StreamWrite() or a command.
+parameter:
+******************************************************************************/
+void EPD_7IN3F_StreamWriteAsync(const UBYTE* Data,
+                                UDOUBLE Len,
+                                void (*Done)(void* Ctx),
+                                void* Ctx) {
+#if EPD_7IN3F_BURST
+  uint64_t t0 = time_us_64();
+  if (!epd_burst_open) {
+    DEV_Digital_Write(EPD_DC_PIN, 1);
+    DEV_Digital_Write(EPD_CS_PIN, 0);
+    epd_burst_open = 1;
+  }
+  DEV_SPI_DMA_Wait();  // the previous piece is out
+  epd_wait_us += time_us_64() - t0;
+  epd_write_wait_ms = (int32_t)(epd_wait_us / 1000);
+  epd_write_bytes += Len;
+  EPD_7IN3F_TraceData(Data, Len);
+  epd_dma_done = Done;
+  epd_dma_ctx = Ctx;
+  epd_dma_t0 = time_us_64();
+  DEV_SPI_Write_nByte_DMA(Data, Len, EPD_7IN3F_DMADone, NULL);
+#else
+  EPD_7IN3F_StreamWrite(Data, Len);
+  if (Done)
+    Done(Ctx);
+#endif
+}
+
+/******************************************************************************
+function :	Wait for the last StreamWriteAsync() piece and close the burst
+parameter:
+******************************************************************************/
+void EPD_7IN3F_StreamSync(void) {
+  if (!epd_burst_open)
+    return;
+  uint64_t t0 = time_us_64();
+  DEV_SPI_DMA_Wait();
+  DEV_Digital_Write(EPD_CS_PIN, 1);
+  epd_burst_open = 0;
+  epd_wait_us += time_us_64() - t0;
+  epd_write_wait_ms = (int32_t)(epd_wait_us / 1000);
+}
+
+/******************************************************************************
+function :	Refresh the panel with the frame written since StreamBegin()
+parameter:
+returns   : as TurnOnDisplay()
+******************************************************************************/
+int EPD_7IN3F_StreamEnd(void) {
+  EPD_7IN3F_StreamSync();
   return EPD_7IN3F_TurnOnDisplay();
 }
 
 /******************************************************************************
-function :	Enter sleep mode
-            Sends POWER_OFF (0x02) + waits for BUSY + DEEP_SLEEP (0x07 0xA5)
-            + 2000ms settle.  This is the canonical Waveshare park sequence.
+function :	Enter sleep mode without waiting out the settle
+            Sends POWER_OFF (0x02) + waits for BUSY + DEEP_SLEEP (0x07 0xA5);
+            with the 2000ms settle after it this is the canonical Waveshare
+            park sequence. The panel must keep power until the settle ends.
             POWER_OFF is sent unconditionally — if the panel is already
             powered off from TurnOnDisplay, the command is harmless.
             Only a hardware RST can wake the controller after this call.
 parameter:
+SettledUs : when the settle ends (time_us_64())
 returns   : 0 on success, -1 if POWER_OFF BUSY wait timed out (sleep still
             sent as best effort)
 ******************************************************************************/
-int EPD_7IN3F_Sleep(void) {
+int EPD_7IN3F_SleepBegin(uint64_t* SettledUs) {
   // POWER_OFF — collapse HV rails
   EPD_7IN3F_SendCommand(0x02);
   EPD_7IN3F_SendData(0x00);
@@ -529,6 +835,21 @@ int EPD_7IN3F_Sleep(void) {
   // Only a hardware RST can return it to standby.
   EPD_7IN3F_SendCommand(0x07);
   EPD_7IN3F_SendData(0xA5);
-  DEV_Delay_ms(2000);  // Waveshare Python driver uses 2000ms post-sleep settle
+  // Waveshare Python driver uses 2000ms post-sleep settle
+  *SettledUs = DEV_Deadline_ms(2000);
   return (rc == 0) ? 0 : -1;
 }
+
+/******************************************************************************
+function :	Enter sleep mode and wait out the settle
+parameter:
+returns   : 0, or -1 if POWER_OFF timed out
+******************************************************************************/
+int EPD_7IN3F_Sleep(void) {
+  uint64_t settled;
+  int rc = EPD_7IN3F_SleepBegin(&settled);
+  uint64_t now = time_us_64();
+  if (settled > now)
+    sleep_us(settled - now);
+  return rc;
+}
@@ -36,6 +36,8 @@
 // Display resolution
 #define EPD_7IN3F_WIDTH 800
 #define EPD_7IN3F_HEIGHT 480
+// Bytes per packed row: two pixels per byte, high nibble first.
+#define EPD_7IN3F_ROW_BYTES ((EPD_7IN3F_WIDTH + 1) / 2)
 
 /**********************************
 Color Index
@@ -50,17 +52,76 @@ Color Index
 #define EPD_7IN3F_CLEAN 0x7   ///	111   unavailable  Afterimage
 
 int EPD_7IN3F_Init(void);
+// Init() (and PowerOn() if PowerOn) without blocking, so the ~0.4 s of reset
+// delays overlap other work: PrepareBegin(), then PreparePoll() as often as
+// convenient, at the latest by *WakeUs (time_us_64()), until it returns 0
+// (ready) or fails like Init() (-1) or PowerOn() (-2). PrepareFinish() blocks
+// for the rest. No other panel calls in between.
+void EPD_7IN3F_PrepareBegin(int PowerOn);
+int EPD_7IN3F_PreparePoll(uint64_t* WakeUs);
+int EPD_7IN3F_PrepareFinish(void);
 void EPD_7IN3F_ReloadConfig(void);
 int EPD_7IN3F_PowerOn(void);
 void EPD_7IN3F_Clear(UBYTE color);
 void EPD_7IN3F_Show7Block(void);
 int EPD_7IN3F_Display(UBYTE* Image);
+// Frame from a row provider: packs Count rows from row Y into Rows; nonzero
+// aborts. Only EPD_7IN3F_STREAM_ROWS rows (two buffers of them) in RAM.
+typedef int (*EPD_7IN3F_RowFn)(UBYTE* Rows, UWORD Y, UWORD Count, void* Ctx);
+int EPD_7IN3F_DisplayStream(EPD_7IN3F_RowFn Fill, void* Ctx);
+// Frame write without a frame buffer: Begin, Write in pieces, End.
+void EPD_7IN3F_StreamBegin(void);
+void EPD_7IN3F_StreamWrite(const UBYTE* Data, UDOUBLE Len);
+// DMA variant: returns at once; Data is free again when Done(Ctx) runs or
+// the next StreamWriteAsync()/StreamSync() returns. StreamSync() waits for
+// the last piece (StreamEnd() and every command do so too).
+void EPD_7IN3F_StreamWriteAsync(const UBYTE* Data,
+                                UDOUBLE Len,
+                                void (*Done)(void* Ctx),
+                                void* Ctx);
+void EPD_7IN3F_StreamSync(void);
+int EPD_7IN3F_StreamEnd(void);
 int EPD_7IN3F_Sleep(void);
+// Sleep() up to its 2 s settle, which ends at *SettledUs: the panel must keep
+// power until then, but the CPU is free.
+int EPD_7IN3F_SleepBegin(uint64_t* SettledUs);
 
-// Phase timing (ms) from last TurnOnDisplay; -1 if not yet run.
+// Bus trace: one entry per command, reset pulse and BUSY wait since boot,
+// the last EPD_7IN3F_TRACE_LEN kept (0 compiles it out). Data bytes are
+// only counted.
+#ifndef EPD_7IN3F_TRACE_LEN
+#define EPD_7IN3F_TRACE_LEN 64
+#endif
+#define EPD_7IN3F_TR_CMD 0
+#define EPD_7IN3F_TR_RESET 1
+#define EPD_7IN3F_TR_WAIT 2
+typedef struct {
+  uint32_t t_us;  // low 32 bits of time_us_64() at the start
+  uint32_t len;   // data bytes after a command; us spent in a wait
+  UBYTE kind;     // EPD_7IN3F_TR_*
+  UBYTE code;     // command byte; level waited for
+  UBYTE busy;     // BUSY at the start (bit 1) and at the end (bit 0)
+  UBYTE d0;       // first data byte after a command
+} EPD_7IN3F_TraceEntry;
+// Copy up to Max entries, oldest first; *Lost gets how many older ones were
+// overwritten. Returns the number copied.
+UWORD EPD_7IN3F_TraceRead(EPD_7IN3F_TraceEntry* Out,
+                          UWORD Max,
+                          UDOUBLE* Lost);
+
+// Phase timing (ms) from last TurnOnDisplay, command to BUSY rising edge;
+// -1 if not yet run.
 extern volatile int32_t epd_phase_power_on_ms;
 extern volatile int32_t epd_phase_refresh_ms;
 extern volatile int32_t epd_phase_power_off_ms;
+// Time (ms) and bytes of frame data clocked out since the last StreamBegin()
+// (also Display, Clear, Show7Block), and how much of that time the CPU was
+// blocked (all of it without DMA); epd_write_burst is 1 when the data went
+// out in bursts, 0 for the byte-at-a-time build (EPD_7IN3F_BURST 0).
+extern volatile int32_t epd_phase_write_ms;
+extern volatile int32_t epd_write_wait_ms;
+extern volatile uint32_t epd_write_bytes;
+extern const int epd_write_burst;
 // BUSY pin state sampled at start of Init (before Reset).
 extern volatile int epd_busy_pin_at_init;
 // BUSY pin state sampled 2ms after Reset completes.
@@ -73,5 +134,9 @@ extern volatile int epd_busy_after_cmd04;
 // BUSY pin state sampled immediately before/after DISPLAY_REFRESH (0x12).
 extern volatile int epd_busy_before_cmd12;
 extern volatile int epd_busy_after_cmd12;
+// From BUSY edge timestamps: us from DISPLAY_REFRESH to BUSY LOW (-1: never)
+// and the number of BUSY edges until the refresh wait ended (2 when healthy).
+extern volatile int32_t epd_refresh_low_us;
+extern volatile int32_t epd_refresh_edges;
 
 #endif
@@ -3,6 +3,13 @@
 #include <stdlib.h>
 #include <string.h>  // For strstr
 #include "hardware/uart.h"
+#include "lib/Link/crc32.h"
+#include "lib/Link/frame_parser.h"
+#include "lib/Link/frame_store.h"
+#include "lib/Link/link_proto.h"
+#include "lib/Link/payload.h"
+#include "lib/Link/tiles.h"
+#include "lib/Link/uart_rx.h"
 #include "lib/led/led.h"
 #include "pico/stdio.h"
 #include "pico/stdlib.h"
@@ -15,13 +22,56 @@
 
 // UART configuration
 #define UART_ID uart1
-#define UART_BAUD 115200
+#define UART_BAUD 115200  // base rate; must match LINK_BASE_BAUD
 #define UART_TX_PIN 4
 #define UART_RX_PIN 5
 
+// Baud negotiation: SENDIMG offers UART_FAST_BAUDS (fastest first), the peer
+// confirms one in its ACK and both sides return to UART_BAUD after the frame.
+// A failed fast frame drops that rate for the remaining attempts.
+#define UART_BAUD_NEGOTIATION 1
+#define UART_FAST_BAUDS 2000000, 921600
+
+// RTS hardware flow control, used only when the peer confirms FLOW=RTS.
+// UART1 CTS would be GPIO6, which is RTC_INT on this board, so only RTS
+// (Pico RX backpressure) is wired.
+#define UART_HW_FLOW 1
+#define UART_RTS_PIN 7
+
 // Image buffer size: 800x480 7-color (example); adjust if using different
 // display.
 #define IMAGE_SIZE 192000
+#define IMAGE_WIDTH 800
+#define IMAGE_HEIGHT 480
+
+// Payload formats offered in SENDIMG (LINK_FMT_* bits). The peer may still
+// send raw frames; the size header says which one arrived. P3 (3 bits per
+// pixel) cuts a frame to 144000 bytes before compression. CRC checks every
+// LINK_CHUNK_SIZE bytes and lets a retry resume after the last good chunk.
+#define IMAGE_FORMATS (LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC)
+
+// Delta updates: keep the last frame on the SD card and send its tile hashes
+// with SENDIMG (FMT=DELTA), so the peer only sends tiles that changed.
+#define IMAGE_DELTA 1
+
+// Streaming receive: initialise the panel before SENDIMG and write each
+// decoded piece straight to it, so there is no 192 KB image_buffer. Such
+// frames cannot be resumed or sent as deltas (set IMAGE_DELTA to 0): a frame
+// that fails part way is sent again from the start, and if every attempt
+// fails the panel is not refreshed and keeps its previous picture.
+#define IMAGE_STREAM 0
+#define STREAM_WINDOW_SIZE 4096  // decoded bytes per panel write (x2, DMA)
+
+// Skip the ~34 s panel cycle when the frame's CRC32 matches the one the
+// panel last showed (kept on the SD card next to the delta base).
+#define REFRESH_SKIP_SAME 1
+
+// Reset and init the panel in the background from boot, while the firmware
+// waits for USB, the ESP32 and the payload, instead of after the frame is in
+// (IMAGE_STREAM: before SENDIMG). 0: blocking, as before. The booster stays
+// off until the refresh itself powers it on (TurnOnDisplay), so a cycle that
+// receives nothing new never charges it.
+#define PANEL_PREP_EARLY 1
 
 // How many times to retry image request before giving up this cycle
 #define MAX_IMAGE_RETRIES 3
@@ -31,10 +81,13 @@
 #define SOF_TIMEOUT_MS 60000    // wait up to 60s for start-of-frame
 #define DATA_TIMEOUT_MS 180000  // wait up to 180s for full image data
 #define RETRY_WAIT_MS 30000     // wait 30s after a timeout before retry
+#define RESUME_WAIT_MS 2000     // wait after a chunk CRC failure before resume
 #define POST_SEND_DELAY_MS 20   // small delay after sending request
+#define HEADER_TIMEOUT_MS 10000  // size header after SOF
 
 // Buffer sizes
-#define ACK_BUFFER_SIZE 64
+#define RX_CHUNK_SIZE 4096  // bytes per UART read fed to the frame parser
+#define RX_GAP_US 2000      // payload stalls longer than this count in RX_PERF
 
 // Remote logging to ESP32 via UART (set to 0 to disable)
 #define PICO_UART_LOGGING 1
@@ -57,6 +110,10 @@ extern volatile int epd_busy_after_cmd04;
 extern volatile int epd_busy_before_cmd12;
 extern volatile int epd_busy_after_cmd12;
 
+#if IMAGE_STREAM && IMAGE_DELTA
+#error "IMAGE_DELTA patches image_buffer, which IMAGE_STREAM leaves out"
+#endif
+
 // ---------------------------------------------------------------------------
 // End configuration
 // ---------------------------------------------------------------------------
@@ -101,6 +158,7 @@ void uart_log(const char* msg) {
 // diagnostic data before cutting our power.
 // ---------------------------------------------------------------------------
 #if PICO_UART_LOGGING
+static void wait_ms(uint32_t ms);
 #define PLOG_BUFFER_SIZE 4096
 static char plog_buffer[PLOG_BUFFER_SIZE];
 static size_t plog_buffer_len = 0;
@@ -127,7 +185,7 @@ static void plog_fmt(const char* fmt, ...) {
 static void plog_flush(void) {
   if (plog_buffer_len > 0) {
     uart_puts(UART_ID, plog_buffer);
-    sleep_ms(100);  // let ESP32 process lines before SENDIMG
+    wait_ms(100);  // let ESP32 process lines before SENDIMG
     plog_buffer_len = 0;
     plog_buffer[0] = '\0';
   }
@@ -138,18 +196,174 @@ static void plog_flush(void) {
 #define plog_flush() ((void)0)
 #endif
 
+// ---------------------------------------------------------------------------
+// Cycle phases. Panel prepare (reset and register load: ~0.5 s of
+// delays and BUSY waits) runs in the background from boot; wait_ms() and
+// pump_frame() step it whenever they would otherwise sleep. The wrap-up
+// (delta-base save, trace, final PLOG flush) runs inside the panel's 2 s
+// deep-sleep settle. CYCLE_PHASES logs when each phase ran.
+// ---------------------------------------------------------------------------
+enum {
+  CYC_BOOT,    // power-on to the first SENDIMG
+  CYC_PREP,    // panel reset and init
+  CYC_RECV,    // SENDIMG attempts
+  CYC_SHOW,    // frame write and refresh
+  CYC_SETTLE,  // deep-sleep settle
+  CYC_WRAP,    // after DEEP_SLEEP up to the CYCLE_PHASES line
+  CYC_COUNT
+};
+static const char* const cyc_names[CYC_COUNT] = {"boot", "prep",   "recv",
+                                                 "show", "settle", "wrap"};
+static uint64_t cyc_t0;                // boot
+static uint32_t cyc_ms[CYC_COUNT][2];  // start, end: ms since cyc_t0
+static unsigned cyc_ran;               // bit per phase started
+
+static int prep_running = 0;  // background prepare in flight
+static int prep_rc = -1;      // its result (PreparePoll())
+static int panel_up = -1;     // panel_ready() result, -1 not asked yet
+static int panel_woken = 0;   // reset this cycle: must be parked
+static int panel_powered = 0; // POWER_ON sent this cycle: park must settle
+
+static void cycle_mark(int ph, int end) {
+  cyc_ms[ph][end] = (uint32_t)((time_us_64() - cyc_t0) / 1000);
+  if (!end)
+    cyc_ran |= 1u << ph;
+}
+
+// Start the background panel prepare (PANEL_PREP_EARLY).
+static void panel_prep_start(void) {
+#if PANEL_PREP_EARLY
+  cycle_mark(CYC_PREP, 0);
+  EPD_7IN3F_PrepareBegin(0);
+  prep_running = 1;
+  panel_woken = 1;
+#endif
+}
+
+static void panel_prep_done(void) {
+  prep_running = 0;
+  cycle_mark(CYC_PREP, 1);
+  plog_fmt("PANEL_PREP rc=%d busy_before=%d busy_after_rst=%d", prep_rc,
+           epd_busy_pin_at_init, epd_busy_after_reset);
+}
+
+// Run the background steps that are due. Returns when the next one is
+// (time_us_64()), 0 once nothing is left.
+static uint64_t background_poll(void) {
+  if (!prep_running)
+    return 0;
+  uint64_t wake;
+  prep_rc = EPD_7IN3F_PreparePoll(&wake);
+  if (prep_rc == 1)
+    return wake;
+  panel_prep_done();
+  return 0;
+}
+
+// How long a UART read may block (ms, at most left) before background work
+// is due again; runs what is due now.
+static int32_t background_slice(int32_t left) {
+  uint64_t wake = background_poll();
+  if (!wake)
+    return left;
+  uint64_t now = time_us_64();
+  int32_t ms = (wake > now) ? (int32_t)((wake - now + 999) / 1000) : 1;
+  return (ms < left) ? ms : left;
+}
+
+// sleep_ms() that keeps the background work going.
+static void wait_ms(uint32_t ms) {
+  uint64_t until = time_us_64() + (uint64_t)ms * 1000;
+  for (;;) {
+    uint64_t wake = background_poll();
+    uint64_t now = time_us_64();
+    if (now >= until)
+      return;
+    uint64_t t = (wake && wake < until) ? wake : until;
+    if (t > now)
+      sleep_us(t - now);
+  }
+}
+
 size_t last_receive_count = 0;
+static uint32_t last_frame_crc = 0;  // of the last frame received whole
+
+// Baud negotiation state; persists across retries within this boot.
+static link_baud_t link_baud;
+
+// Where the next SENDIMG should resume (from = 0: whole frame), and the
+// FROM= / ID= the peer put on the ACK of the frame in flight.
+static link_resume_t resume;
+static link_resume_t ack_resume;
+static int ack_has_id;
+
+// Delta base: image_buffer holds a frame whose tile hashes we can offer.
+static tile_grid_t tile_grid;
+static int delta_base = 0;
+static uint8_t req_formats;  // LINK_FMT_* offered in the last SENDIMG
+
+// Parser and decoder for the frame in flight (see pump_frame).
+static frame_parser_t frame;
+static payload_decoder_t payload_dec;
+
+// Bytes read from the UART that the frame parser has not taken yet.
+static uint8_t rx_chunk[RX_CHUNK_SIZE];
+static size_t rx_pos, rx_have;
+
+// Receive-path counters for the frame in flight, logged once as RX_PERF:
+// when each parser state was first entered, when pump_frame() last gave up
+// waiting, and the UART counters at SENDIMG.
+static uint64_t phase_at[FRAME_ST_ERROR + 1];
+static uint64_t phase_end;
+static uart_rx_stats_t rx_at_request;
+
+#if IMAGE_STREAM
+// Decoded pixels pass through these windows on their way to the panel:
+// one goes out by DMA while the decoder fills the other. The running CRC
+// stands in for hashing image_buffer against the ACK's ID.
+static uint8_t stream_window[2][STREAM_WINDOW_SIZE] __attribute__((aligned(4)));
+static uint32_t stream_crc;
+
+static void stream_to_panel(void* ctx, const uint8_t* data, size_t n) {
+  (void)ctx;
+  stream_crc = crc32_update(stream_crc, data, n);
+  EPD_7IN3F_StreamWriteAsync(data, n, NULL, NULL);
+}
+
+// A short raw frame leaves the rest of the panel RAM like a cleared buffer.
+static void stream_pad(size_t n) {
+  EPD_7IN3F_StreamSync();  // both windows are free again
+  memset(stream_window[0], 0xFF, STREAM_WINDOW_SIZE);
+  while (n) {
+    size_t k = (n < STREAM_WINDOW_SIZE) ? n : STREAM_WINDOW_SIZE;
+    stream_to_panel(NULL, stream_window[0], k);
+    n -= k;
+  }
+}
+#endif
+
+// CRC32 of the frame just received (buffer NULL: the streamed one).
+static uint32_t frame_crc(const uint8_t* buffer, size_t size) {
+#if IMAGE_STREAM
+  if (!buffer)
+    return stream_crc;
+#endif
+  return crc32_update(0, buffer, size);
+}
 
 // Forward declarations for helper functions
 static void flush_rx(void);
-static void send_image_request(void);
-static int contains_ack(const char* s);
-static int read_ack_with_timeout(int32_t timeout_ms);
-static int wait_for_sof(int32_t timeout_ms);
-static int read_image_size(size_t* out_size);
+static void send_image_request(const uint8_t* buffer);
+static void uart_apply_baud(uint32_t baud, int flow);
+static void sd_begin(void);
+static void sd_end(void);
+static void end_frame(int ok);
+static frame_event_t pump_frame(void);
+static void phase_enter(frame_state_t st);
+static void log_rx_perf(void);
 static int receive_image_data(uint8_t* buffer,
                               size_t buf_size,
-                              size_t img_size);
+                              size_t* verified);
 
 /**
  * request_and_receive_image
@@ -161,200 +375,385 @@ static int receive_image_data(uint8_t* buffer,
  *  - read image data
  * Returns 0 on success, -1 on fatal error, -2 if timed out and caller should
  * retry (we already waited RETRY_WAIT_MS inside this function in that case).
+ * When the ACK negotiated a faster baud rate, the frame runs at that rate and
+ * header errors count as retryable so the next attempt can fall back.
+ * Checksummed frames that fail part way set `resume`, so the retry only
+ * fetches the image from the last verified chunk on.
+ * With buffer NULL (IMAGE_STREAM) the frame is written to the panel as it
+ * arrives instead; the panel must already be initialised.
  */
 int request_and_receive_image(uint8_t* buffer, size_t size) {
   LOG("Requesting image from ESP32");
 
   // Clear any stale bytes before starting
   flush_rx();
+  frame_parser_init(&frame);
+  memset(phase_at, 0, sizeof(phase_at));
+  phase_end = 0;
+  uart_rx_get_stats(&rx_at_request);
 
   // Send request and give peer a short time to prepare
-  send_image_request();
-  sleep_ms(POST_SEND_DELAY_MS);
+  send_image_request(buffer);
+  phase_enter(FRAME_ST_ACK);
+  wait_ms(POST_SEND_DELAY_MS);
 
   // Wait for ACK
   LOG("Waiting for ACK from ESP32");
-  if (read_ack_with_timeout(ACK_TIMEOUT_MS) != 0) {
+  if (pump_frame() != FRAME_EV_ACK) {
     LOG("No ACK received within timeout - waiting before retry");
     last_receive_count = 0;
-    sleep_ms(RETRY_WAIT_MS);
+    wait_ms(RETRY_WAIT_MS);
     return -2;
   }
+  link_parse_ack(&link_baud, frame.line);
+  ack_has_id = link_parse_resume(frame.line, &ack_resume);
 
-  // Wait for frame start marker (SOF)
-  LOG("ACK received, waiting for SOF marker");
-  if (wait_for_sof(SOF_TIMEOUT_MS) != 0) {
-    LOG("SOF not found within timeout - waiting before retry");
-    last_receive_count = 0;
-    sleep_ms(RETRY_WAIT_MS);
-    return -2;
+  // Switch to the negotiated rate before the peer starts SOF. Waiting first
+  // lets the second ACK line drain at the old rate; whatever was read past
+  // the ACK goes with it.
+  const int fast = (link_baud.current != UART_BAUD);
+  if (fast) {
+    wait_ms(LINK_SWITCH_DELAY_MS);
+    uart_apply_baud(link_baud.current, link_baud.flow);
+    rx_pos = rx_have;
+    plog_fmt("BAUD_SWITCH baud=%u flow=%d", (unsigned)link_baud.current,
+             link_baud.flow);
   }
 
-  LOG("SOF marker received, reading image size header");
-  size_t img_size = 0;
-  if (read_image_size(&img_size) != 0) {
-    LOG("Failed to read image size header");
+  // Wait for frame start marker (SOF) and the size header after it
+  LOG("ACK received, waiting for SOF marker");
+  if (pump_frame() != FRAME_EV_HEADER) {
     last_receive_count = 0;
-    return -1;
+    end_frame(0);
+    if (frame.state == FRAME_ST_SOF) {
+      LOG("SOF not found within timeout - waiting before retry");
+      wait_ms(RETRY_WAIT_MS);
+      return -2;
+    }
+    LOG("Timeout reading image size header");
+    return fast ? -2 : -1;
   }
+
+  // Resume only if the peer echoed our offset for the same frame.
+  size_t from = 0;
+  if (ack_has_id && resume.from && ack_resume.from == resume.from &&
+      ack_resume.id == resume.id && resume.from < size)
+    from = resume.from;
+
+  const size_t img_size = frame.len;
+  const uint8_t img_fmt = frame.fmt;
   char size_msg[64];
-  snprintf(size_msg, sizeof(size_msg), "Image size header: %u bytes",
-           (unsigned)img_size);
+  snprintf(size_msg, sizeof(size_msg), "Image size header: %u bytes fmt=%u",
+           (unsigned)img_size, (unsigned)img_fmt);
   LOG(size_msg);
+  plog_fmt("FRAME fmt=%u wire=%u from=%u", (unsigned)img_fmt,
+           (unsigned)img_size, (unsigned)from);
 
-  if (img_size > size) {
+  if (!link_fmt_accepted(img_fmt, req_formats, from)) {
+    LOG("Peer sent a payload format we cannot take at this offset, aborting");
+    last_receive_count = 0;
+    end_frame(0);
+    return fast ? -2 : -1;
+  }
+
+  // A compressed payload can exceed the buffer by the encoder's worst case.
+  if (img_size > payload_max_wire(img_fmt, size - from)) {
     LOG("Image size in header exceeds buffer size, aborting");
     last_receive_count = 0;
-    return -1;
+    end_frame(0);
+    return fast ? -2 : -1;
   }
 
   LOG("Receiving image data");
-  int rc = receive_image_data(buffer, size, img_size);
+#if IMAGE_STREAM
+  // Restarts the panel RAM write at the top left, also after a failed try.
+  if (!buffer) {
+    EPD_7IN3F_StreamBegin();
+    stream_crc = 0;
+  }
+#endif
+  size_t verified = 0;
+  int rc = receive_image_data(buffer ? buffer + from : NULL, size - from,
+                              &verified);
+  last_receive_count += from;
   if (rc != 0) {
-    // receive_image_data already logs and waits when appropriate
-    last_receive_count = (rc > 0) ? (size_t)rc : 0;
+    // receive_image_data already logged and set last_receive_count. A
+    // failed delta frame needs no resume point: the tiles that did arrive
+    // already match, so the next hash list leaves them out. A streamed
+    // frame cannot skip ahead in the panel RAM, so it starts over.
+    const int chunked = (img_fmt & LINK_FMT_CRC) && ack_has_id &&
+                        !(img_fmt & LINK_FMT_DELTA) && buffer;
+    resume.from = chunked ? (uint32_t)(from + verified) : 0;
+    resume.id = ack_resume.id;
+    plog_fmt("RESUME_POINT from=%u rc=%d", (unsigned)resume.from, rc);
+    end_frame(0);
+    // A bad chunk or an overrun is not a busy peer: ask again soon.
+    wait_ms(((rc == -4 || rc == -5) && (resume.from || !buffer))
+                ? RESUME_WAIT_MS
+                : RETRY_WAIT_MS);
     return -2;
   }
+  resume.from = 0;
+#if IMAGE_STREAM
+  if (!buffer)
+    stream_pad(size - payload_dec.produced);
+#endif
+
+  // The ID is the CRC32 of the whole frame: catches a bad stitch on resume.
+  // After a delta it also proves the untouched tiles matched the new frame.
+  // The same pass gives the panel-skip check its hash. A buffered frame is
+  // hashed here and not as it arrives, because a delta or a resume writes
+  // image_buffer out of order.
+  last_frame_crc = (ack_has_id || REFRESH_SKIP_SAME) ? frame_crc(buffer, size)
+                                                     : 0;
+  if (ack_has_id && last_frame_crc != ack_resume.id) {
+    LOG("Frame CRC does not match the ID from the ACK");
+    plog_fmt("FRAME_CRC_FAIL id=%08X", (unsigned)ack_resume.id);
+    delta_base = 0;  // ask for a full frame next time
+    end_frame(0);
+    return -2;
+  }
+  if (img_fmt & LINK_FMT_DELTA) {
+    plog_fmt("DELTA tiles=%d/%d wire=%u saved=%u", payload_dec.tiles,
+             tile_grid.count, (unsigned)img_size,
+             (unsigned)(img_size < size ? size - img_size : 0));
+  }
 
   LOG("Image received");
-  last_receive_count = img_size;
+  end_frame(1);
   return 0;
 }
 
 // -------------------- Helper implementations --------------------
 
-// Discard any available bytes on RX
+// Discard any available bytes on RX, read or not
 static void flush_rx(void) {
-  while (uart_is_readable(UART_ID)) {
-    (void)uart_getc(UART_ID);
+  uart_rx_flush();
+  rx_pos = rx_have = 0;
+}
+
+// Send image request string, advertising any fast rates still allowed. With
+// a delta base the tile hashes of buffer follow the line; they are taken
+// fresh each attempt so tiles patched by a failed delta are not sent again.
+static void send_image_request(const uint8_t* buffer) {
+  static uint32_t hashes[TILE_MAX];
+  static uint8_t block[TILE_HASH_BLOCK(TILE_MAX)];
+  char req[128];
+  const int tiles = delta_base ? tile_grid.count : 0;
+  req_formats = IMAGE_FORMATS | (tiles ? LINK_FMT_DELTA : 0);
+  if (link_format_request(&link_baud, req_formats, &resume, tiles, req,
+                          sizeof(req)) < 0) {
+    LOG("Image request does not fit its buffer");
+    return;  // the attempt times out and is retried
+  }
+  uart_puts(UART_ID, req);
+  if (tiles) {
+    tile_hashes(&tile_grid, buffer, hashes);
+    size_t n = tile_hashes_pack(hashes, tiles, block);
+    uart_write_blocking(UART_ID, block, n);
   }
 }
 
-// Send image request string
-static void send_image_request(void) {
-  uart_puts(UART_ID, "SENDIMG\n");
+// Switch UART1 to baud once pending TX has drained, and drop whatever arrived
+// at the old rate.
+static void uart_apply_baud(uint32_t baud, int flow) {
+  uart_tx_wait_blocking(UART_ID);
+  uart_set_baudrate(UART_ID, baud);
+  uart_set_hw_flow(UART_ID, false, UART_HW_FLOW && flow);
+  uart_rx_flush();
 }
 
-// Simple substring test for ACK (case-sensitive, matches anywhere)
-static int contains_ack(const char* s) {
-  if (!s)
-    return 0;
-  return strstr(s, "ACK") != NULL;
-}
-
-// Read until newline or timeout. Returns 0 if an ACK was seen, -1 otherwise.
-static int read_ack_with_timeout(int32_t timeout_ms) {
-  char ack_buf[ACK_BUFFER_SIZE];
-  size_t idx = 0;
-  absolute_time_t start = get_absolute_time();
-  const int64_t timeout_us = (int64_t)timeout_ms * 1000;
-  while (absolute_time_diff_us(start, get_absolute_time()) < timeout_us) {
-    if (uart_is_readable(UART_ID)) {
-      int c = uart_getc(UART_ID);
-      if (c < 0)
-        continue;
-      if (idx < sizeof(ack_buf) - 1)
-        ack_buf[idx++] = (char)c;
-      ack_buf[idx] = '\0';
-      if (c == '\n') {
-        // strip trailing CR/LF
-        while (idx > 0 &&
-               (ack_buf[idx - 1] == '\n' || ack_buf[idx - 1] == '\r')) {
-          ack_buf[--idx] = '\0';
-        }
-        if (contains_ack(ack_buf))
-          return 0;
-        idx = 0;
-        ack_buf[0] = '\0';
-      }
-    }
+// The SD card's MISO and CS are UART1's TX and RX pins (GPIO4/5), which
+// every frame_store_* call muxes for SPI. Let pending TX out before one...
+static void sd_begin(void) {
+  uart_tx_wait_blocking(UART_ID);
+}
+
+// ...and give the pins back to the UART after it, dropping what RX caught
+// while the card drove them.
+static void sd_end(void) {
+  gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
+  gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+  flush_rx();
+}
+
+// Frame over (good or bad): both sides go back to the base rate. A failed fast
+// frame removes that rate from the next request.
+static void end_frame(int ok) {
+  int fast = (link_baud.current != UART_BAUD);
+  link_baud_frame_done(&link_baud, ok);
+  if (fast)
+    uart_apply_baud(UART_BAUD, 0);
+}
+
+// Milliseconds left until deadline (0 once it has passed).
+static int32_t ms_until(absolute_time_t deadline) {
+  int64_t us = absolute_time_diff_us(get_absolute_time(), deadline);
+  return (us > 0) ? (int32_t)((us + 999) / 1000) : 0;
+}
+
+// How long the frame parser may sit in state st.
+static int32_t frame_timeout_ms(frame_state_t st) {
+  switch (st) {
+    case FRAME_ST_ACK:
+      return ACK_TIMEOUT_MS;
+    case FRAME_ST_SOF:
+      return SOF_TIMEOUT_MS;
+    case FRAME_ST_HEADER:
+      return HEADER_TIMEOUT_MS;
+    default:
+      return DATA_TIMEOUT_MS;
   }
-  return -1;
-}
-
-// Wait for SOF marker 0xAA 0x55 0xAA 0x55. Returns 0 on success, -1 on timeout.
-static int wait_for_sof(int32_t timeout_ms) {
-  uint8_t sof[4] = {0};
-  size_t sof_idx = 0;
-  absolute_time_t start = get_absolute_time();
-  const int64_t timeout_us = (int64_t)timeout_ms * 1000;
-  while (sof_idx < 4 &&
-         absolute_time_diff_us(start, get_absolute_time()) < timeout_us) {
-    if (uart_is_readable(UART_ID)) {
-      uint8_t c = uart_getc(UART_ID);
-      sof[sof_idx] = c;
-      if ((sof_idx == 0 && c == 0xAA) || (sof_idx == 1 && c == 0x55) ||
-          (sof_idx == 2 && c == 0xAA) || (sof_idx == 3 && c == 0x55)) {
-        sof_idx++;
+}
+
+// Feed UART bytes to the frame parser until it reports an event. Every state
+// gets its own timeout from when it is entered; FRAME_EV_NONE means one ran
+// out and frame.state says which. Handshake reads return as soon as anything
+// arrives, so the ACK is seen in time for the baud switch; payload reads
+// fill RX_CHUNK_SIZE pieces. Nothing is logged from here: stalls and rates
+// end up in the RX_PERF line. Reads give way to background work when due.
+// Once the receive ring has lost bytes, the ones read before are fed and
+// the frame fails with FRAME_ERR_LOST.
+static frame_event_t pump_frame(void) {
+  frame_state_t st = frame.state;
+  phase_enter(st);
+  absolute_time_t deadline = make_timeout_time_ms(frame_timeout_ms(st));
+  for (;;) {
+    if (rx_pos == rx_have) {
+      if (uart_rx_lost()) {
+        phase_end = time_us_64();
+        frame.state = FRAME_ST_ERROR;
+        frame.error = FRAME_ERR_LOST;
+        return FRAME_EV_ERROR;
+      }
+      int32_t left = ms_until(deadline);
+      if (left <= 0) {
+        phase_end = time_us_64();
+        return FRAME_EV_NONE;
+      }
+      left = background_slice(left);
+      rx_pos = 0;
+      if (st == FRAME_ST_PAYLOAD) {
+        size_t want = frame_parser_pending(&frame);
+        if (want > RX_CHUNK_SIZE)
+          want = RX_CHUNK_SIZE;
+        rx_have = uart_rx_read(rx_chunk, want, left);
       } else {
-        sof_idx = (c == 0xAA) ? 1 : 0;
+        rx_have = uart_rx_read_some(rx_chunk, sizeof(rx_chunk), left);
       }
     }
+    size_t used;
+    frame_event_t ev = frame_parser_feed(&frame, rx_chunk + rx_pos,
+                                         rx_have - rx_pos, &used);
+    rx_pos += used;
+    if (frame.state != st) {
+      st = frame.state;
+      phase_enter(st);
+      deadline = make_timeout_time_ms(frame_timeout_ms(st));
+    }
+    if (ev != FRAME_EV_NONE)
+      return ev;
   }
-  return (sof_idx == 4) ? 0 : -1;
 }
 
-// Read 4-byte big-endian image size into out_size; returns 0 on success,
-// -1 on timeout (10 s).
-static int read_image_size(size_t* out_size) {
-  if (!out_size)
-    return -1;
-  uint8_t header[4];
-  size_t idx = 0;
-  absolute_time_t start = get_absolute_time();
-  const int64_t timeout_us = 10000000;  // 10 seconds
-  while (idx < 4) {
-    if (absolute_time_diff_us(start, get_absolute_time()) > timeout_us) {
-      LOG("Timeout reading image size header");
-      return -1;
-    }
-    if (uart_is_readable(UART_ID)) {
-      header[idx++] = uart_getc(UART_ID);
-    }
-  }
-  *out_size =
-      (header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
-  return 0;
+// Note the first time the frame in flight reaches st.
+static void phase_enter(frame_state_t st) {
+  if (!phase_at[st])
+    phase_at[st] = time_us_64();
+}
+
+// Microseconds from entering phase a to entering b, or to the timeout if b
+// was never reached; 0 if a was never reached.
+static uint64_t phase_us(frame_state_t a, frame_state_t b) {
+  if (!phase_at[a])
+    return 0;
+  uint64_t end = phase_at[b] ? phase_at[b] : phase_end;
+  return (end > phase_at[a]) ? end - phase_at[a] : 0;
+}
+
+// One summary of the attempt just made: payload rate, stalls, UART errors
+// during it, and ms from SENDIMG to the ACK, from there to the end of the
+// header (baud switch and SOF hunt) and for the payload. The header usually
+// arrives in the same read as the SOF, so it has no phase of its own.
+static void log_rx_perf(void) {
+  uart_rx_stats_t rx;
+  uart_rx_get_stats(&rx);
+  frame_state_t end = phase_at[FRAME_ST_DONE] ? FRAME_ST_DONE : FRAME_ST_ERROR;
+  uint64_t data_us = phase_us(FRAME_ST_PAYLOAD, end);
+  unsigned got = phase_at[FRAME_ST_PAYLOAD] ? (unsigned)frame.received : 0;
+  if (!phase_at[FRAME_ST_PAYLOAD])
+    rx.max_gap_us = rx.gaps = 0;
+  plog_fmt("RX_PERF bytes=%u B/ms=%u gap_max_us=%u gaps=%u ovr=%u hw_ovr=%u "
+           "err=%u phase_ms=%u/%u/%u",
+           got, data_us ? (unsigned)((uint64_t)got * 1000 / data_us) : 0,
+           (unsigned)rx.max_gap_us, (unsigned)rx.gaps,
+           (unsigned)(rx.overruns - rx_at_request.overruns),
+           (unsigned)(rx.hw_overruns - rx_at_request.hw_overruns),
+           (unsigned)(rx.hw_errors - rx_at_request.hw_errors),
+           (unsigned)(phase_us(FRAME_ST_ACK, FRAME_ST_SOF) / 1000),
+           (unsigned)(phase_us(FRAME_ST_SOF, FRAME_ST_READY) / 1000),
+           (unsigned)(data_us / 1000));
 }
 
-// Receive image data with a DATA_TIMEOUT_MS overall timeout.
-// Returns 0 on success, -1 on timeout. On partial receive, returns -1 but
-// last_receive_count is populated.
+// Receive the payload announced by frame's header with a DATA_TIMEOUT_MS
+// overall timeout. Encoded payloads (LZ, P3) are decoded into buffer as
+// chunks arrive and must expand to exactly buf_size bytes. With IMAGE_STREAM
+// and buffer NULL the decoded bytes go to the panel through the two
+// stream_window halves instead. Returns 0 on success, -1 on timeout, -3 on a corrupt or wrongly
+// sized encoded payload, -4 on a chunk CRC mismatch, -5 on bytes lost to a
+// receive ring overrun.
+// last_receive_count is set to the number of image bytes written to buffer,
+// also on partial receive; *verified to how many of them passed a chunk CRC.
 static int receive_image_data(uint8_t* buffer,
                               size_t buf_size,
-                              size_t img_size) {
+                              size_t* verified) {
+  *verified = 0;
+  if (frame.len > payload_max_wire(frame.fmt, buf_size))
+    return -1;
+  payload_init(&payload_dec, frame.fmt, frame.len, buffer, buf_size);
+#if IMAGE_STREAM
+  if (!buffer) {
+    payload_set_sink(&payload_dec, stream_to_panel, NULL, stream_window[0],
+                     STREAM_WINDOW_SIZE);
+    payload_set_sink_alt(&payload_dec, stream_window[1]);
+  }
+#else
   if (!buffer)
     return -1;
-  size_t received = 0;
-  absolute_time_t start = get_absolute_time();
-  absolute_time_t last_log = start;
-  const int64_t timeout_us = (int64_t)DATA_TIMEOUT_MS * 1000;
-  while (received < img_size) {
-    absolute_time_t now = get_absolute_time();
-    if (absolute_time_diff_us(start, now) > timeout_us) {
-      LOG("Timeout waiting for image data");
-      last_receive_count = received;
-      sleep_ms(RETRY_WAIT_MS);
-      return -1;
-    }
-    if (absolute_time_diff_us(last_log, now) > 2000000) {
-      char msg[64];
-      snprintf(msg, sizeof(msg), "Still waiting for image data... %u/%u bytes",
-               (unsigned)received, (unsigned)img_size);
-      LOG(msg);
-      last_log = now;
-    }
-    if (uart_is_readable(UART_ID)) {
-      buffer[received++] = uart_getc(UART_ID);
-      if (received % 4096 == 0) {
-        char msg[64];
-        snprintf(msg, sizeof(msg), "Received %u/%u bytes", (unsigned)received,
-                 (unsigned)img_size);
-        LOG(msg);
-      }
-    }
+#endif
+  if (frame.fmt & LINK_FMT_DELTA)
+    payload_set_tiles(&payload_dec, &tile_grid);
+  frame_parser_begin_payload(&frame, &payload_dec);
+  uart_rx_reset_gaps(RX_GAP_US);
+  frame_event_t ev = FRAME_EV_DONE;
+  if (frame.state == FRAME_ST_PAYLOAD)
+    ev = pump_frame();
+  else if (frame.state == FRAME_ST_ERROR)
+    ev = FRAME_EV_ERROR;
+  last_receive_count = payload_dec.produced;
+  *verified = payload_dec.verified;
+  if (ev == FRAME_EV_DONE)
+    return 0;
+  if (ev == FRAME_EV_NONE) {
+    LOG("Timeout waiting for image data");
+    return -1;
   }
-  return 0;
+  if (frame.error == FRAME_ERR_CRC) {
+    LOG("Chunk CRC mismatch, stopping early");
+    plog_fmt("CHUNK_CRC_FAIL at=%u",
+             (unsigned)(payload_dec.consumed / LINK_CHUNK_SIZE));
+    return -4;
+  }
+  if (frame.error == FRAME_ERR_LOST) {
+    LOG("UART receive ring overrun, stopping early");
+    plog_fmt("RX_LOST at=%u", (unsigned)payload_dec.consumed);
+    return -5;
+  }
+  if (frame.error == FRAME_ERR_SHORT)
+    LOG("Encoded payload did not expand to a full frame");
+  else
+    LOG("Corrupt or oversized encoded payload");
+  return -3;
 }
 
 // Fallback image logic removed per request; timeouts now wait 30s and return -2
@@ -362,36 +761,285 @@ static int receive_image_data(uint8_t* buffer,
 
 // usb_log removed (unused). Use uart_log(...) where needed.
 
+// Full hardware re-init before display, the blocking stand-in for the
+// background prepare. Like it, no POWER_ON here: the booster stays off while
+// the frame is written and TurnOnDisplay() switches it on for the refresh.
+// Retry up to 3 times if Init times out. Returns 1 once the panel is ready
+// for a frame.
+#define MAX_REINIT_RETRIES 3
+static int panel_prepare(void) {
+  for (int attempt = 1; attempt <= MAX_REINIT_RETRIES; attempt++) {
+    if (attempt > 1) {
+      plog_fmt("REINIT_RETRY attempt=%d", attempt);
+      DEV_Delay_ms(1000);
+    }
+    plog("FULL_REINIT");
+    int init_rc = EPD_7IN3F_Init();
+    plog_fmt("REINIT_DONE busy_before=%d busy_after_rst=%d rc=%d attempt=%d",
+             epd_busy_pin_at_init, epd_busy_after_reset, init_rc, attempt);
+    if (init_rc != 0) {
+      plog_fmt("INIT_TIMEOUT attempt=%d", attempt);
+      continue;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+// The panel ready for a frame: the background prepare (waiting for what is
+// left of it) or, if that failed or never ran, the blocking re-init with
+// retries. Returns 1 if ready; asked again, the same answer.
+static int panel_ready(void) {
+  if (panel_up >= 0)
+    return panel_up;
+  if (prep_running) {
+    prep_rc = EPD_7IN3F_PrepareFinish();
+    panel_prep_done();
+  }
+  if (prep_rc == 0) {
+    panel_up = 1;
+  } else {
+    if (!(cyc_ran & (1u << CYC_PREP)))
+      cycle_mark(CYC_PREP, 0);
+    panel_woken = 1;
+    panel_up = panel_prepare();
+    cycle_mark(CYC_PREP, 1);
+  }
+  return panel_up;
+}
+
+// Deep sleep for a panel woken this cycle, once any background prepare is
+// through. Returns when its settle ends (time_us_64()), which the panel's
+// power must outlast; 0 when there is none to wait for: not woken, or never
+// powered on, so no HV rails to let down.
+static uint64_t panel_park(void) {
+  if (prep_running) {
+    prep_rc = EPD_7IN3F_PrepareFinish();
+    panel_prep_done();
+  }
+  if (!panel_woken)
+    return 0;
+  uint64_t settled;
+  if (panel_powered)
+    cycle_mark(CYC_SETTLE, 0);
+  int sleep_rc = EPD_7IN3F_SleepBegin(&settled);
+  plog_fmt("EPD_SLEEP rc=%d settle=%d", sleep_rc, panel_powered);
+  if (!panel_powered)
+    return 0;
+  cyc_ms[CYC_SETTLE][1] = (uint32_t)((settled - cyc_t0) / 1000);
+  return settled;
+}
+
+// CYCLE_PHASES <name>=<start>-<end> (ms since boot) for each phase run,
+// and overlap_ms: how much shorter the cycle was than running them back to
+// back. The final flush is not in it; it ends inside the settle.
+static void log_cycle_phases(void) {
+  char line[128];
+  size_t len = (size_t)snprintf(line, sizeof(line), "CYCLE_PHASES");
+  uint32_t first = UINT32_MAX, last = 0, sum = 0;
+  for (int i = 0; i < CYC_COUNT; i++) {
+    if (!(cyc_ran & (1u << i)))
+      continue;
+    uint32_t a = cyc_ms[i][0], b = cyc_ms[i][1];
+    len += (size_t)snprintf(line + len, sizeof(line) - len, " %s=%u-%u",
+                            cyc_names[i], (unsigned)a, (unsigned)b);
+    first = (a < first) ? a : first;
+    last = (b > last) ? b : last;
+    sum += b - a;
+  }
+  if (first > last)
+    return;
+  snprintf(line + len, sizeof(line) - len, " overlap_ms=%u",
+           (unsigned)(sum > last - first ? sum - (last - first) : 0));
+  plog(line);
+}
+
+// Refresh the panel with image, or with the frame already streamed to it when
+// image is NULL, and log how the refresh went. Returns the Display() rc.
+static int panel_show(uint8_t* image) {
+  epd_busy_force_released = 0;
+  panel_powered = 1;  // TurnOnDisplay sends POWER_ON
+  cycle_mark(CYC_SHOW, 0);
+  absolute_time_t disp_t0 = get_absolute_time();
+  int disp_rc = image ? EPD_7IN3F_Display(image) : EPD_7IN3F_StreamEnd();
+  int64_t disp_us = absolute_time_diff_us(disp_t0, get_absolute_time());
+  cycle_mark(CYC_SHOW, 1);
+  int forced_during_display = epd_busy_force_released;
+  uart_log("EPD_7IN3F_Display() done");
+  plog_fmt("DISPLAY_DONE ms=%lld forced=%d rc=%d", disp_us / 1000,
+           forced_during_display, disp_rc);
+  plog_fmt("EPD_WRITE ms=%ld wait=%ld bytes=%u burst=%d",
+           (long)epd_phase_write_ms, (long)epd_write_wait_ms,
+           (unsigned)epd_write_bytes, epd_write_burst);
+  plog_fmt("EPD_PHASES pwr_on=%ld refresh=%ld pwr_off=%ld",
+           (long)epd_phase_power_on_ms, (long)epd_phase_refresh_ms,
+           (long)epd_phase_power_off_ms);
+  plog_fmt("EPD_BUSY04 %d->%d", epd_busy_before_cmd04, epd_busy_after_cmd04);
+  plog_fmt("EPD_BUSY12 %d->%d low_us=%ld edges=%ld", epd_busy_before_cmd12,
+           epd_busy_after_cmd12, (long)epd_refresh_low_us,
+           (long)epd_refresh_edges);
+  int real_refresh = (disp_rc == 0 && epd_phase_refresh_ms > 5000 &&
+                      forced_during_display == 0)
+                         ? 1
+                         : 0;
+  plog_fmt("REFRESH_VERDICT real=%d refresh_ms=%ld disp_rc=%d",
+           real_refresh, (long)epd_phase_refresh_ms, disp_rc);
+  uart_log("Image displayed");
+  return disp_rc;
+}
+
+// Keep the frame just received as the base for the next delta request.
+static void store_delta_base(const uint8_t* image) {
+#if IMAGE_DELTA
+  absolute_time_t t0 = get_absolute_time();
+  sd_begin();
+  int store_rc = frame_store_save(image, IMAGE_SIZE);
+  sd_end();
+  plog_fmt("FRAME_STORE rc=%d ms=%lld", store_rc,
+           absolute_time_diff_us(t0, get_absolute_time()) / 1000);
+#else
+  (void)image;
+#endif
+}
+
+// The panel bus trace as PLOG lines, decoded by tools/epd_trace.c:
+// EPD_TRACE with the count and the first entry's time, then EPD_TR lines of
+// tokens <code><busy at start><busy at end>+<us since previous>, hex, with
+// /<data bytes>=<first byte> after a command or /<us waited> after a wait.
+// Codes: the command byte, RS a reset pulse, WH / WL a wait for BUSY.
+#define EPD_TR_LINE 100  // token chars per PLOG line
+static void log_epd_trace(void) {
+  static EPD_7IN3F_TraceEntry tr[EPD_7IN3F_TRACE_LEN + 1];
+  UDOUBLE lost;
+  UWORD n = EPD_7IN3F_TraceRead(tr, EPD_7IN3F_TRACE_LEN, &lost);
+  if (!n)
+    return;
+  plog_fmt("EPD_TRACE n=%u lost=%lu t0_us=%lu", n, (unsigned long)lost,
+           (unsigned long)tr[0].t_us);
+  char line[EPD_TR_LINE + 32];
+  size_t len = 0;
+  for (UWORD i = 0; i < n; i++) {
+    const EPD_7IN3F_TraceEntry* e = &tr[i];
+    char code[3];
+    if (e->kind == EPD_7IN3F_TR_CMD)
+      snprintf(code, sizeof(code), "%02X", e->code);
+    else
+      snprintf(code, sizeof(code), "%s",
+               e->kind == EPD_7IN3F_TR_RESET ? "RS" : e->code ? "WH" : "WL");
+    if (len == 0)
+      len = (size_t)snprintf(line, sizeof(line), "EPD_TR");
+    len += (size_t)snprintf(line + len, sizeof(line) - len, " %s%d%d+%lx", code,
+                            (e->busy >> 1) & 1, e->busy & 1,
+                            (unsigned long)(i ? e->t_us - tr[i - 1].t_us : 0));
+    if (e->kind == EPD_7IN3F_TR_CMD && e->len)
+      len += (size_t)snprintf(line + len, sizeof(line) - len, "/%lx=%02x",
+                              (unsigned long)e->len, e->d0);
+    else if (e->kind == EPD_7IN3F_TR_WAIT)
+      len += (size_t)snprintf(line + len, sizeof(line) - len, "/%lx",
+                              (unsigned long)e->len);
+    if (len >= EPD_TR_LINE || i + 1 == n) {
+      plog(line);
+      len = 0;
+    }
+  }
+}
+
+// Whether the panel already shows the frame just received.
+static int panel_shows_frame(void) {
+#if REFRESH_SKIP_SAME
+  uint32_t shown;
+  sd_begin();
+  int rc = frame_store_load_shown(IMAGE_SIZE, &shown);
+  sd_end();
+  return rc == 0 && shown == last_frame_crc;
+#else
+  return 0;
+#endif
+}
+
 int main(void) {
+  cyc_t0 = time_us_64();
+  cycle_mark(CYC_BOOT, 0);
   stdio_init_all();  // Initialize USB serial
   if (DEV_Module_Init() != 0) {
     return -1;
   }
+  panel_prep_start();
   // Initialize UART1 for image transfer
   uart_init(UART_ID, UART_BAUD);
   gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
   gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
-  sleep_ms(1000);  // Wait for USB-CDC
+#if UART_HW_FLOW
+  gpio_set_function(UART_RTS_PIN, GPIO_FUNC_UART);
+#endif
+  uart_rx_init(UART_ID);
+  {
+    static const uint32_t fast_bauds[] = {UART_FAST_BAUDS};
+    link_baud_init(&link_baud, fast_bauds,
+                   UART_BAUD_NEGOTIATION ? (int)(sizeof(fast_bauds) /
+                                                 sizeof(fast_bauds[0]))
+                                         : 0,
+                   UART_HW_FLOW);
+  }
+  wait_ms(1000);  // Wait for USB-CDC
 
   uart_log("System started — one-shot mode");
-  static uint8_t image_buffer[IMAGE_SIZE];
+#if IMAGE_STREAM
+  uint8_t* const image_buffer = NULL;  // frames go straight to the panel
+#else
+  // Word aligned for the P3 unpacker's 32-bit stores.
+  static uint8_t image_buffer[IMAGE_SIZE] __attribute__((aligned(4)));
+#endif
   int vbus = gpio_get(24);  // VBUS: 1=USB host, 0=wall/battery
   plog_fmt("BOOT vbus=%d fw=POWER_CYCLE_v1", vbus);
 
-  // Clear image buffer
+  // Clear image buffer, or start from the last frame for a delta request.
+#if !IMAGE_STREAM
   memset(image_buffer, 0xFF, IMAGE_SIZE);
+#endif
+#if IMAGE_DELTA
+  if (tile_grid_init(&tile_grid, IMAGE_WIDTH, IMAGE_HEIGHT) == 0) {
+    absolute_time_t t0 = get_absolute_time();
+    sd_begin();
+    delta_base = (frame_store_load(image_buffer, IMAGE_SIZE) == 0);
+    sd_end();
+    plog_fmt("DELTA_BASE ok=%d ms=%lld", delta_base,
+             absolute_time_diff_us(t0, get_absolute_time()) / 1000);
+  }
+#endif
 
   // Flush any buffered PLOG lines to ESP32 before sending SENDIMG.
   plog_flush();
 
+  // A streamed frame needs the panel ready before its first byte arrives.
+  int reinit_ok = 1;
+#if IMAGE_STREAM
+  reinit_ok = panel_ready();
+  if (!reinit_ok)
+    plog("REINIT_FAILED — skipping image request");
+#endif
+
   // Try to request and receive image (retry up to MAX_IMAGE_RETRIES times)
   int recv_result = -1;
   int attempts;
-  for (attempts = 1; attempts <= MAX_IMAGE_RETRIES; attempts++) {
+  cycle_mark(CYC_BOOT, 1);
+  if (reinit_ok)
+    cycle_mark(CYC_RECV, 0);
+  for (attempts = 1; reinit_ok && attempts <= MAX_IMAGE_RETRIES;
+       attempts++) {
     plog_fmt("SENDIMG_START attempt=%d", attempts);
     recv_result = request_and_receive_image(image_buffer, IMAGE_SIZE);
     plog_fmt("SENDIMG_RESULT rc=%d recv=%u attempt=%d", recv_result,
              (unsigned)last_receive_count, attempts);
+    log_rx_perf();
+    {
+      uart_rx_stats_t rx;
+      uart_rx_get_stats(&rx);
+      plog_fmt("RX_STATS dma=%d bytes=%u ovr=%u hw_ovr=%u err=%u hiwat=%u",
+               rx.dma, (unsigned)rx.bytes, (unsigned)rx.overruns,
+               (unsigned)rx.hw_overruns, (unsigned)rx.hw_errors,
+               (unsigned)rx.high_water);
+    }
     if (recv_result == 0)
       break;  // success
     if (recv_result == -1)
@@ -399,11 +1047,19 @@ int main(void) {
     // recv_result == -2: timeout, retry
     plog_fmt("RECV_TIMEOUT attempt=%d", attempts);
   }
+  cycle_mark(CYC_RECV, 1);
 
-  if (recv_result == 0) {
+  if (recv_result == 0 && panel_shows_frame()) {
+    plog_fmt("REFRESH_SKIPPED crc=%08X", (unsigned)last_frame_crc);
+    uart_log("Frame unchanged — panel left as it is");
+  } else if (recv_result == 0) {
     led_status_transferring();
     uart_log("Displaying image");
 
+#if IMAGE_STREAM
+    // Already on the panel; only the refresh is left.
+    plog_fmt("DISPLAY chk=0 bytes=%u stream=1", (unsigned)last_receive_count);
+#else
     // Debug: print first 32 bytes
     char hexbuf[3 * 32 + 1] = {0};
     for (int i = 0; i < 32; ++i) {
@@ -416,75 +1072,53 @@ int main(void) {
              (unsigned)last_receive_count, image_buffer[0], image_buffer[1],
              image_buffer[2], image_buffer[3]);
 
-    // Full hardware re-init + PowerOn before display.
-    // Retry up to 3 times if Init or PowerOn times out.
-#define MAX_REINIT_RETRIES 3
-    int reinit_ok = 0;
-    for (int attempt = 1; attempt <= MAX_REINIT_RETRIES; attempt++) {
-      if (attempt > 1) {
-        plog_fmt("REINIT_RETRY attempt=%d", attempt);
-        DEV_Delay_ms(1000);
-      }
-      plog("FULL_REINIT");
-      int init_rc = EPD_7IN3F_Init();
-      plog_fmt("REINIT_DONE busy_before=%d busy_after_rst=%d rc=%d attempt=%d",
-               epd_busy_pin_at_init, epd_busy_after_reset, init_rc, attempt);
-      if (init_rc != 0) {
-        plog_fmt("INIT_TIMEOUT attempt=%d", attempt);
-        continue;
-      }
-      int pon_rc = EPD_7IN3F_PowerOn();
-      plog_fmt("POWER_ON_PRE rc=%d busy=%d->%d attempt=%d", pon_rc,
-               epd_busy_before_cmd04, epd_busy_after_cmd04, attempt);
-      if (pon_rc != 0) {
-        plog_fmt("POWER_ON_TIMEOUT attempt=%d", attempt);
-        continue;
-      }
-      reinit_ok = 1;
-      break;
-    }
+    reinit_ok = panel_ready();
+#endif
 
     if (!reinit_ok) {
       plog("REINIT_FAILED — skipping display");
       uart_log("Init+PowerOn failed after retries — skipping display");
     } else {
-      epd_busy_force_released = 0;
-      absolute_time_t disp_t0 = get_absolute_time();
-      int disp_rc = EPD_7IN3F_Display(image_buffer);
-      int64_t disp_us = absolute_time_diff_us(disp_t0, get_absolute_time());
-      int forced_during_display = epd_busy_force_released;
-      uart_log("EPD_7IN3F_Display() done");
-      plog_fmt("DISPLAY_DONE ms=%lld forced=%d rc=%d", disp_us / 1000,
-               forced_during_display, disp_rc);
-      plog_fmt("EPD_PHASES pwr_on=%ld refresh=%ld pwr_off=%ld",
-               (long)epd_phase_power_on_ms, (long)epd_phase_refresh_ms,
-               (long)epd_phase_power_off_ms);
-      plog_fmt("EPD_BUSY04 %d->%d", epd_busy_before_cmd04,
-               epd_busy_after_cmd04);
-      plog_fmt("EPD_BUSY12 %d->%d", epd_busy_before_cmd12,
-               epd_busy_after_cmd12);
-      int real_refresh = (disp_rc == 0 && epd_phase_refresh_ms > 5000 &&
-                          forced_during_display == 0)
-                             ? 1
-                             : 0;
-      plog_fmt("REFRESH_VERDICT real=%d refresh_ms=%ld disp_rc=%d",
-               real_refresh, (long)epd_phase_refresh_ms, disp_rc);
-      uart_log("Image displayed");
-    }
-
-    // Park the panel into deep sleep
-    {
-      int sleep_rc = EPD_7IN3F_Sleep();
-      plog_fmt("EPD_SLEEP rc=%d", sleep_rc);
+      int disp_rc = panel_show(image_buffer);
+#if REFRESH_SKIP_SAME
+      // After a failed refresh the panel may show anything.
+      sd_begin();
+      int shown_rc = frame_store_save_shown(disp_rc == 0 ? IMAGE_SIZE : 0,
+                                            last_frame_crc);
+      sd_end();
+      plog_fmt("FRAME_SHOWN rc=%d crc=%08X", shown_rc,
+               (unsigned)last_frame_crc);
+#endif
     }
     led_status_off();
   } else {
     plog_fmt("RECV_FAIL rc=%d attempts=%d", recv_result, attempts);
     uart_log("Image reception failed after all retries");
+#if IMAGE_STREAM
+    // The panel RAM may hold part of a frame, but nothing is shown without
+    // DISPLAY_REFRESH: the previous picture stays up.
+    if (reinit_ok)
+      plog("STREAM_ABORT keep=previous");
+#endif
   }
 
+  // Park the panel into deep sleep: woken from boot, it needs it also when
+  // nothing was shown. After a refresh the rest of the cycle runs in its
+  // settle; a panel that was never powered on has none.
+  uint64_t settled = panel_park();
+  cycle_mark(CYC_WRAP, 0);
+  if (recv_result == 0)
+    store_delta_base(image_buffer);
+
+  log_epd_trace();
+  cycle_mark(CYC_WRAP, 1);
+  log_cycle_phases();
+
   // Flush final PLOG lines (display results) to ESP32 before signalling done
   plog_flush();
+  uint64_t now = time_us_64();
+  if (settled > now)
+    sleep_us(settled - now);
 
   // Signal ESP32 that we're done — it will cut our power
   uart_puts(UART_ID, "PICODONE\n");
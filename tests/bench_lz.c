@@ -0,0 +1,109 @@
+// Host benchmark for the LINK_FMT_LZ payload: compression ratio and streaming
+// decode throughput on sample frames.
+//
+// Decoding is fed in RX_CHUNK_SIZE pieces, as receive_image_data() does, and
+// verified byte-for-byte against the source frame. Extra raw 192000-byte
+// frames can be passed on the command line.
+//
+//   gcc -O2 tests/bench_lz.c tests/sample_frames.c tools/lz_encode.c
+//       lib/Link/lz_decode.c examples/ImageData.c -o bench_lz
+//   ./bench_lz [frame.bin ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../examples/ImageData.h"
+#include "../lib/Link/lz_decode.h"
+#include "../tools/lz_encode.h"
+#include "sample_frames.h"
+
+#define RX_CHUNK_SIZE 4096
+#define DECODE_REPS 20
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Decode enc in RX_CHUNK_SIZE pieces into out. Returns 0 if it round-trips.
+static int decode_chunked(const uint8_t* enc, size_t enc_len, uint8_t* out,
+                          size_t out_cap, size_t* produced) {
+  static lz_decoder_t dec;
+  lz_decoder_init(&dec);
+  *produced = 0;
+  for (size_t off = 0; off < enc_len;) {
+    size_t n = enc_len - off;
+    if (n > RX_CHUNK_SIZE)
+      n = RX_CHUNK_SIZE;
+    size_t got;
+    int32_t used = lz_decode(&dec, enc + off, n, out + *produced,
+                             out_cap - *produced, &got);
+    if (used < 0 || (size_t)used != n)
+      return -1;
+    *produced += got;
+    off += n;
+  }
+  return lz_decoder_idle(&dec) ? 0 : -1;
+}
+
+static int bench(const char* name, const uint8_t* frame, size_t len) {
+  uint8_t* enc = malloc(LZ_BOUND(len));
+  uint8_t* out = malloc(len);
+  double t0 = now_s();
+  size_t enc_len = lz_encode(frame, len, enc);
+  double enc_s = now_s() - t0;
+
+  size_t produced = 0;
+  int rc = decode_chunked(enc, enc_len, out, len, &produced);
+  if (rc != 0 || produced != len || memcmp(out, frame, len) != 0) {
+    printf("%-20s ROUND TRIP FAILED (rc=%d produced=%zu)\n", name, rc,
+           produced);
+    free(enc);
+    free(out);
+    return 1;
+  }
+
+  t0 = now_s();
+  for (int i = 0; i < DECODE_REPS; i++)
+    decode_chunked(enc, enc_len, out, len, &produced);
+  double dec_s = (now_s() - t0) / DECODE_REPS;
+
+  printf("%-20s raw=%-7zu lz=%-7zu ratio=%6.1f:1 enc_ms=%6.1f "
+         "decode=%7.1f MB/s  wire@2M=%5.0f ms (raw %4.0f ms)\n",
+         name, len, enc_len, (double)len / (double)enc_len, enc_s * 1e3,
+         (double)len / dec_s / 1e6, (double)enc_len * 10 / 2000.0,
+         (double)len * 10 / 2000.0);
+  free(enc);
+  free(out);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  int fails = 0;
+
+  memset(frame, 0x11, sizeof(frame));
+  fails += bench("blank_white", frame, sizeof(frame));
+  sample_frame_dashboard(frame, 0);
+  fails += bench("dashboard_07:00", frame, sizeof(frame));
+  sample_frame_dashboard(frame, 754);
+  fails += bench("dashboard_19:34", frame, sizeof(frame));
+  fails += bench("Image7color_photo", Image7color, sizeof(frame));
+  sample_frame_noise(frame, 1);
+  fails += bench("noise", frame, sizeof(frame));
+
+  for (int i = 1; i < argc; i++) {
+    FILE* f = fopen(argv[i], "rb");
+    if (!f) {
+      perror(argv[i]);
+      return 1;
+    }
+    size_t n = fread(frame, 1, sizeof(frame), f);
+    fclose(f);
+    fails += bench(argv[i], frame, n);
+  }
+  return fails ? 1 : 0;
+}
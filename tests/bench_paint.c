@@ -0,0 +1,300 @@
+// Host benchmark for the GUI_Paint pixel path: pixels/s per rotation on the
+// 800x480 7-colour canvas.
+//
+// "before" is the original per-pixel Paint_SetPixel() (bounds checks, a
+// switch on the rotation, one on the mirror and one on the scale), copied
+// here; "after" is Paint_SetPixel() with the writer resolved once per canvas
+// state, and "span fill" is Paint_ClearWindows(), which clips once and fills
+// whole bytes along the memory rows. Both sweeps must leave the same bytes.
+//
+// Glyphs/s: the original Paint_DrawChar() loop (one pixel call per font bit)
+// against Paint_DrawChar() through the glyph tables, with an opaque and a
+// transparent background, again leaving the same bytes.
+//
+// GB2312 glyphs/s: the original Paint_DrawString_CN() (a scan of the font
+// table per character, then one pixel call per bit) against the code index
+// and the glyph tables, on lines of the last entries of each table.
+//
+//   gcc -O2 -Itests/host -Ilib/Config tests/bench_paint.c lib/GUI/GUI_Paint.c
+//       lib/Fonts/font*.c -o bench_paint
+//   ./bench_paint
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lib/GUI/GUI_Paint.h"
+
+#define WIDTH 800
+#define HEIGHT 480
+#define CANVAS_BYTES (WIDTH / 2 * HEIGHT)
+#define REPS 20
+
+static UBYTE before[CANVAS_BYTES];
+static UBYTE after[CANVAS_BYTES];
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Paint_SetPixel() as it was, without the band.
+static void legacy_set_pixel(UWORD Xpoint, UWORD Ypoint, UWORD Color) {
+  if (Xpoint > Paint.Width || Ypoint > Paint.Height)
+    return;
+  UWORD X, Y;
+  switch (Paint.Rotate) {
+    case 0:
+      X = Xpoint;
+      Y = Ypoint;
+      break;
+    case 90:
+      X = Paint.WidthMemory - Ypoint - 1;
+      Y = Xpoint;
+      break;
+    case 180:
+      X = Paint.WidthMemory - Xpoint - 1;
+      Y = Paint.HeightMemory - Ypoint - 1;
+      break;
+    case 270:
+      X = Ypoint;
+      Y = Paint.HeightMemory - Xpoint - 1;
+      break;
+    default:
+      return;
+  }
+  switch (Paint.Mirror) {
+    case MIRROR_NONE:
+      break;
+    case MIRROR_HORIZONTAL:
+      X = Paint.WidthMemory - X - 1;
+      break;
+    case MIRROR_VERTICAL:
+      Y = Paint.HeightMemory - Y - 1;
+      break;
+    case MIRROR_ORIGIN:
+      X = Paint.WidthMemory - X - 1;
+      Y = Paint.HeightMemory - Y - 1;
+      break;
+    default:
+      return;
+  }
+  if (X > Paint.WidthMemory || Y > Paint.HeightMemory)
+    return;
+  if (Paint.Scale == 2) {
+    UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
+    UBYTE Rdata = Paint.Image[Addr];
+    if (Color == BLACK)
+      Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
+    else
+      Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
+  } else if (Paint.Scale == 4) {
+    UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
+    Color = Color % 4;
+    UBYTE Rdata = Paint.Image[Addr];
+    Rdata = Rdata & (~(0xC0 >> ((X % 4) * 2)));
+    Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4) * 2));
+  } else if (Paint.Scale == 7) {
+    UDOUBLE Addr = X / 2 + Y * Paint.WidthByte;
+    UBYTE Rdata = Paint.Image[Addr];
+    Rdata = Rdata & (~(0xF0 >> ((X % 2) * 4)));
+    Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2) * 4));
+  }
+}
+
+// Sweeps over the whole canvas; returns pixels/s, best of REPS.
+static double sweep(void (*set)(UWORD, UWORD, UWORD)) {
+  double best = 0;
+  for (int r = 0; r < REPS; r++) {
+    double t0 = now_s();
+    for (UWORD y = 0; y < Paint.Height; y++)
+      for (UWORD x = 0; x < Paint.Width; x++)
+        set(x, y, (UWORD)((x + y + r) % 7));
+    double rate = (double)Paint.Width * Paint.Height / (now_s() - t0);
+    best = rate > best ? rate : best;
+  }
+  return best;
+}
+
+// Paint_DrawChar() as it was, on legacy_set_pixel().
+static void legacy_draw_char(UWORD Xpoint, UWORD Ypoint, char Acsii_Char,
+                             sFONT* Font, UWORD Color_Foreground,
+                             UWORD Color_Background) {
+  UWORD stride = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+  const unsigned char* ptr =
+      &Font->table[(Acsii_Char - ' ') * Font->Height * stride];
+  for (UWORD Page = 0; Page < Font->Height; Page++) {
+    for (UWORD Column = 0; Column < Font->Width; Column++) {
+      if (FONT_BACKGROUND == Color_Background) {
+        if (*ptr & (0x80 >> (Column % 8)))
+          legacy_set_pixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+      } else {
+        if (*ptr & (0x80 >> (Column % 8)))
+          legacy_set_pixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+        else
+          legacy_set_pixel(Xpoint + Column, Ypoint + Page, Color_Background);
+      }
+      if (Column % 8 == 7)
+        ptr++;
+    }
+    if (Font->Width % 8 != 0)
+      ptr++;
+  }
+}
+
+// A screen of text, glyph after glyph; returns glyphs/s, best of REPS.
+static double text(void (*draw)(UWORD, UWORD, char, sFONT*, UWORD, UWORD),
+                   sFONT* font, UWORD bg) {
+  double best = 0;
+  for (int r = 0; r < REPS; r++) {
+    UDOUBLE glyphs = 0;
+    double t0 = now_s();
+    for (UWORD y = 0; y + font->Height <= Paint.Height; y += font->Height)
+      for (UWORD x = 1; x + font->Width <= Paint.Width; x += font->Width)
+        draw(x, y, (char)(' ' + 1 + glyphs++ % 94), font, 0, bg);
+    double rate = glyphs / (now_s() - t0);
+    best = rate > best ? rate : best;
+  }
+  return best;
+}
+
+// Paint_DrawString_CN() as it was, on legacy_set_pixel().
+static void legacy_draw_cn(UWORD Xstart, UWORD Ystart, const char* pString,
+                           cFONT* font, UWORD Color_Foreground,
+                           UWORD Color_Background) {
+  const UBYTE* p = (const UBYTE*)pString;
+  int x = Xstart;
+  while (*p) {
+    int len = *p <= 0x7F ? 1 : 2;
+    for (UWORD Num = 0; Num < font->size; Num++) {
+      const UBYTE* index = (const UBYTE*)font->table[Num].index;
+      if (index[0] != p[0] || (len == 2 && index[1] != p[1]))
+        continue;
+      const UBYTE* ptr = (const UBYTE*)font->table[Num].matrix;
+      for (UWORD j = 0; j < font->Height; j++) {
+        for (UWORD i = 0; i < font->Width; i++) {
+          if (*ptr & (0x80 >> (i % 8)))
+            legacy_set_pixel(x + i, Ystart + j, Color_Foreground);
+          else if (FONT_BACKGROUND != Color_Background)
+            legacy_set_pixel(x + i, Ystart + j, Color_Background);
+          if (i % 8 == 7)
+            ptr++;
+        }
+        if (font->Width % 8 != 0)
+          ptr++;
+      }
+      break;
+    }
+    x += len == 1 ? font->ASCII_Width : font->Width;
+    p += len;
+  }
+}
+
+// Lines of GB2312 text; returns glyphs/s, best of REPS.
+static double text_cn(void (*draw)(UWORD, UWORD, const char*, cFONT*, UWORD,
+                                   UWORD),
+                      cFONT* font) {
+  // The last four GB2312 entries: the ones a table scan takes longest to
+  // reach
+  const char* last[4];
+  int found = 0;
+  for (int e = font->size - 1; e >= 0 && found < 4; e--)
+    if ((UBYTE)font->table[e].index[0] > 0x7F)
+      last[found++] = font->table[e].index;
+  char line[2 * WIDTH / 8 + 1];
+  UWORD n = 0, glyphs = 0;
+  for (UWORD x = 0; found && x + font->Width <= Paint.Width; x += font->Width) {
+    line[n++] = last[glyphs % found][0];
+    line[n++] = last[glyphs % found][1];
+    glyphs++;
+  }
+  line[n] = 0;
+  double best = 0;
+  for (int r = 0; r < REPS; r++) {
+    UDOUBLE drawn = 0;
+    double t0 = now_s();
+    for (UWORD y = 0; y + font->Height <= Paint.Height; y += font->Height) {
+      draw(0, y, line, font, (UWORD)(r % 7), 1);
+      drawn += glyphs;
+    }
+    double rate = drawn / (now_s() - t0);
+    best = rate > best ? rate : best;
+  }
+  return best;
+}
+
+static double clear_windows(void) {
+  double best = 0;
+  for (int r = 0; r < REPS; r++) {
+    double t0 = now_s();
+    Paint_ClearWindows(0, 0, Paint.Width, Paint.Height, (UWORD)(r % 7));
+    double rate = (double)Paint.Width * Paint.Height / (now_s() - t0);
+    best = rate > best ? rate : best;
+  }
+  return best;
+}
+
+static void new_canvas(UBYTE* image, UWORD rotate, UBYTE mirror) {
+  Paint_NewImage(image, WIDTH, HEIGHT, rotate, WHITE);
+  Paint_SetScale(7);
+  Paint_SetMirroring(mirror);
+}
+
+int main(void) {
+  static const UWORD rotations[] = {ROTATE_0, ROTATE_90, ROTATE_180,
+                                    ROTATE_270};
+  int failures = 0;
+  printf("rotate mirror   before Mpx/s   after Mpx/s  span fill Mpx/s\n");
+  for (int i = 0; i < 8; i++) {
+    UWORD rotate = rotations[i % 4];
+    UBYTE mirror = i < 4 ? MIRROR_NONE : MIRROR_ORIGIN;
+    new_canvas(before, rotate, mirror);
+    double legacy = sweep(legacy_set_pixel);
+    new_canvas(after, rotate, mirror);
+    double checked = sweep(Paint_SetPixel);
+    int same = memcmp(before, after, CANVAS_BYTES) == 0;
+    double fill = clear_windows();
+    printf("%6u %6u %14.1f %13.1f %16.1f%s\n", rotate, mirror, legacy / 1e6,
+           checked / 1e6, fill / 1e6, same ? "" : "  MISMATCH");
+    failures += !same;
+  }
+
+  static sFONT* const fonts[] = {&Font16, &Font24};
+  printf("\nrotate font background   before kglyph/s   after kglyph/s\n");
+  for (int i = 0; i < 16; i++) {
+    UWORD rotate = rotations[i / 4];
+    sFONT* font = fonts[i / 2 % 2];
+    UWORD bg = i % 2 ? FONT_BACKGROUND : 5;
+    memset(before, 0x11, CANVAS_BYTES);
+    memset(after, 0x11, CANVAS_BYTES);
+    new_canvas(before, rotate, MIRROR_NONE);
+    double legacy = text(legacy_draw_char, font, bg);
+    new_canvas(after, rotate, MIRROR_NONE);
+    double tables = text(Paint_DrawChar, font, bg);
+    int same = memcmp(before, after, CANVAS_BYTES) == 0;
+    printf("%6u %4u %10s %17.1f %16.1f%s\n", rotate, font->Height,
+           bg == FONT_BACKGROUND ? "none" : "opaque", legacy / 1e3,
+           tables / 1e3, same ? "" : "  MISMATCH");
+    failures += !same;
+  }
+
+  static cFONT* const fonts_cn[] = {&Font12CN, &Font24CN};
+  printf("\nrotate font   before kglyph/s   after kglyph/s (GB2312)\n");
+  for (int i = 0; i < 8; i++) {
+    UWORD rotate = rotations[i / 2];
+    cFONT* font = fonts_cn[i % 2];
+    memset(before, 0x11, CANVAS_BYTES);
+    memset(after, 0x11, CANVAS_BYTES);
+    new_canvas(before, rotate, MIRROR_NONE);
+    double legacy = text_cn(legacy_draw_cn, font);
+    new_canvas(after, rotate, MIRROR_NONE);
+    double indexed = text_cn(Paint_DrawString_CN, font);
+    int same = memcmp(before, after, CANVAS_BYTES) == 0;
+    printf("%6u %4u %17.1f %16.1f%s\n", rotate, font->Height, legacy / 1e3,
+           indexed / 1e3, same ? "" : "  MISMATCH");
+    failures += !same;
+  }
+  return failures ? 1 : 0;
+}
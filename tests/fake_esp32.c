@@ -0,0 +1,549 @@
+// Stand-in ESP32 for end-to-end runs of the host firmware build (main.c over
+// tests/host/): it plays the ESP32 side of the protocol on a pseudo-terminal
+// and power-cycles the firmware once per cycle, like the real one does with
+// the MOSFET on GPIO 25.
+//
+// Each cycle starts the firmware with PICO_UART naming a fresh pty, answers
+// every SENDIMG through fake_peer_respond() (ACK lines at 115200, SOF and the
+// rest at the negotiated rate), collects PLOG lines and cuts power on
+// PICODONE. Bytes are paced at the line rate (10 bits per byte); the options
+// add reply latency, random stalls, bit flips, dropped bytes and unanswered
+// requests. The firmware keeps its delta base (lastframe.bin) in a scratch
+// directory for the whole run.
+//
+// Per attempt it reports time-to-first-byte (request received to SOF sent),
+// payload time (SOF to last byte sent) and wire bytes; per cycle the
+// firmware's SENDIMG_RESULT codes, the time from power-on to PICODONE and
+// whether the virtual panel in tests/host/host_dev.c ended up showing the
+// frame that was sent (refreshed, or already up from an earlier cycle). A
+// cycle is ok only if it did and the firmware's SD card writes went through.
+//
+//   gcc -O2 -pthread -Itests/host -Ilib/Config -Ilib/e-Paper -I. main.c
+//       lib/e-Paper/EPD_7in3f.c lib/Link/frame_parser.c
+//       lib/Link/frame_store.c lib/Link/link_proto.c lib/Link/payload.c
+//       lib/Link/pack3.c lib/Link/tiles.c lib/Link/lz_decode.c
+//       lib/Link/crc32.c tests/host/host_pico.c tests/host/host_dev.c
+//       -o pico_host
+//   gcc -O2 tests/fake_esp32.c tests/fake_peer.c tests/sample_frames.c
+//       lib/Link/link_proto.c lib/Link/pack3.c lib/Link/tiles.c
+//       lib/Link/crc32.c tools/lz_encode.c -o fake_esp32
+//   ./fake_esp32 -n 5 ./pico_host
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../lib/Link/link_proto.h"
+#include "../lib/Link/tiles.h"
+#include "fake_peer.h"
+#include "sample_frames.h"
+
+#define WIRE_CAP (2 * SAMPLE_FRAME_SIZE)
+#define LINE_MAX_LEN 512
+#define PACE_SLICE 256         // bytes per paced write
+#define STALL_EVERY 4096       // -j stalls happen this often
+#define WRITE_STALL_MS 5000    // give up on a frame nobody reads
+#define SILENCE_MS 120000      // firmware quiet this long: cycle failed
+#define MAX_ATTEMPTS_SEEN 16
+
+typedef struct {
+  int cycles;
+  uint32_t rates[LINK_MAX_RATES];
+  int n_rates;
+  int has_cts;
+  int legacy;
+  uint8_t formats;
+  uint32_t reliable_max;
+  int latency_ms;
+  int jitter_ms;
+  uint32_t flip_ppm;
+  uint32_t drop_ppm;
+  int mute;  // requests left unanswered
+  const char* frame_file;
+  const char* panel_scale;
+  char panel_fail;      // Bug #15 failure mode, 0: healthy panel
+  int panel_fail_from;  // ... from this cycle on
+  int verbose;
+} options_t;
+
+typedef struct {
+  double ttfb_ms;
+  double payload_ms;
+  size_t wire;
+  int answered;
+} attempt_t;
+
+typedef struct {
+  int attempts;
+  int rcs[MAX_ATTEMPTS_SEEN];  // SENDIMG_RESULT rc= from PLOG
+  int n_rcs;
+  int done;  // PICODONE seen
+  int panel;  // 1 showing the frame sent, 0 another one, -1 never refreshed
+  int skipped;  // REFRESH_SKIPPED: the frame was already up
+  int sd_fail;  // FRAME_STORE / FRAME_SHOWN rc=-1: the card did not answer
+  double total_ms;
+} cycle_t;
+
+static options_t opt;
+static uint8_t wire[WIRE_CAP];
+static uint8_t frame[SAMPLE_FRAME_SIZE];
+static uint32_t seed = 1;
+static char panel_path[64];  // PICO_PANEL_RAW of the firmware
+
+static int64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_until_us(int64_t t) {
+  int64_t d = t - now_us();
+  if (d > 0) {
+    struct timespec ts = {(time_t)(d / 1000000), (long)(d % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+  }
+}
+
+static uint32_t next_rand(void) {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static void fmt_name(uint8_t fmt, char* out, size_t cap) {
+  snprintf(out, cap, "%s%s%s%s%s", fmt ? "" : "RAW",
+           (fmt & LINK_FMT_LZ) ? "LZ" : "", (fmt & LINK_FMT_P3) ? "+P3" : "",
+           (fmt & LINK_FMT_CRC) ? "+CRC" : "",
+           (fmt & LINK_FMT_DELTA) ? "+DELTA" : "");
+  if (out[0] == '+')
+    memmove(out, out + 1, strlen(out));
+}
+
+// Write all of buf, giving up when the firmware stops reading.
+static int write_all(int fd, const uint8_t* buf, size_t n) {
+  while (n) {
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    if (poll(&pfd, 1, WRITE_STALL_MS) <= 0)
+      return -1;
+    ssize_t k = write(fd, buf, n);
+    if (k < 0 && (errno == EAGAIN || errno == EINTR))
+      continue;
+    if (k <= 0)
+      return -1;
+    buf += k;
+    n -= (size_t)k;
+  }
+  return 0;
+}
+
+// Send n bytes at baud (8N1), with a random stall of up to jitter_ms before
+// every STALL_EVERY bytes.
+static int paced_write(int fd,
+                       const uint8_t* buf,
+                       size_t n,
+                       uint32_t baud,
+                       int jitter_ms) {
+  int64_t t0 = now_us();
+  for (size_t off = 0; off < n;) {
+    if (jitter_ms && off % STALL_EVERY == 0 && off)
+      t0 += (int64_t)(next_rand() % (uint32_t)(jitter_ms + 1)) * 1000;
+    sleep_until_us(t0 + (int64_t)off * 10000000 / baud);
+    size_t k = n - off;
+    if (k > PACE_SLICE)
+      k = PACE_SLICE;
+    if (write_all(fd, buf + off, k) != 0)
+      return -1;
+    off += k;
+  }
+  sleep_until_us(t0 + (int64_t)n * 10000000 / baud);  // last byte on the wire
+  return 0;
+}
+
+// Flip bits and drop bytes in wire[start..n); returns the new length.
+static size_t inject(size_t start, size_t n) {
+  size_t w = start;
+  for (size_t r = start; r < n; r++) {
+    if (opt.drop_ppm && next_rand() % 1000000 < opt.drop_ppm)
+      continue;
+    uint8_t b = wire[r];
+    if (opt.flip_ppm && next_rand() % 1000000 < opt.flip_ppm)
+      b ^= (uint8_t)(1u << (next_rand() & 7));
+    wire[w++] = b;
+  }
+  return w;
+}
+
+// Answer one request (line plus any hash block).
+static void serve(int fd,
+                  fake_peer_t* peer,
+                  const char* req,
+                  int64_t t_req,
+                  attempt_t* at) {
+  memset(at, 0, sizeof(*at));
+  if (opt.mute > 0) {
+    opt.mute--;
+    printf("  request left unanswered\n");
+    return;
+  }
+  size_t n = fake_peer_respond(peer, req, frame, SAMPLE_FRAME_SIZE, wire,
+                               sizeof(wire));
+  if (n == 0)
+    return;
+  size_t sof = 0;
+  while (sof + 4 <= n && !(wire[sof] == 0xAA && wire[sof + 1] == 0x55 &&
+                           wire[sof + 2] == 0xAA && wire[sof + 3] == 0x55))
+    sof++;
+  int delay = opt.latency_ms +
+              (opt.jitter_ms ? (int)(next_rand() % (opt.jitter_ms + 1)) : 0);
+  sleep_until_us(t_req + (int64_t)delay * 1000);
+  if (paced_write(fd, wire, sof, LINK_BASE_BAUD, 0) != 0)
+    return;
+  if (peer->frame_baud != LINK_BASE_BAUD)
+    sleep_until_us(now_us() + LINK_PEER_SWITCH_DELAY_MS * 1000);
+  n = inject(sof, n);
+  int64_t t_sof = now_us();
+  at->answered = 1;
+  at->ttfb_ms = (double)(t_sof - t_req) / 1000.0;
+  at->wire = n - sof;
+  int rc = paced_write(fd, wire + sof, n - sof, peer->frame_baud,
+                       opt.jitter_ms);
+  at->payload_ms = (double)(now_us() - t_sof) / 1000.0;
+  char name[32];
+  fmt_name(peer->frame_fmt, name, sizeof(name));
+  printf("  %-14s %7lu baud%-4s  wire %7zu B  ttfb %7.1f ms  payload %8.1f ms"
+         "%s\n",
+         name, (unsigned long)peer->frame_baud, peer->frame_flow ? "+RTS" : "",
+         at->wire, at->ttfb_ms, at->payload_ms,
+         rc ? "  (firmware stopped reading)" : "");
+}
+
+// Buffered reads from the pty master.
+typedef struct {
+  int fd;
+  uint8_t buf[4096];
+  size_t pos, len;
+} reader_t;
+
+// Next byte, -1 after timeout_ms of silence, -2 if the pty is gone.
+static int read_byte(reader_t* r, int timeout_ms) {
+  if (r->pos == r->len) {
+    struct pollfd pfd = {r->fd, POLLIN, 0};
+    int p = poll(&pfd, 1, timeout_ms);
+    if (p == 0)
+      return -1;
+    ssize_t k = read(r->fd, r->buf, sizeof(r->buf));
+    if (k < 0 && (errno == EAGAIN || errno == EINTR))
+      return -1;
+    if (k <= 0)
+      return -2;
+    r->pos = 0;
+    r->len = (size_t)k;
+  }
+  return r->buf[r->pos++];
+}
+
+static int cycle_ok(const cycle_t* cy) {
+  return cy->done && cy->n_rcs && cy->rcs[cy->n_rcs - 1] == 0 &&
+         cy->panel > 0 && !cy->sd_fail;
+}
+
+static void run_cycle(int c, char* const* argv, fake_peer_t* peer,
+                      cycle_t* cy, attempt_t* sum, int* answered) {
+  memset(cy, 0, sizeof(*cy));
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) || unlockpt(master)) {
+    perror("posix_openpt");
+    exit(1);
+  }
+  const char* slave_name = ptsname(master);
+  // Held open so the master never reads EIO between firmware runs; raw
+  // from the start so nothing is echoed before the firmware opens it.
+  int slave = open(slave_name, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  tcgetattr(slave, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  fcntl(master, F_SETFL, O_NONBLOCK);
+
+  int64_t t_on = now_us();
+  pid_t pid = fork();
+  if (pid == 0) {
+    setenv("PICO_UART", slave_name, 1);
+    setenv("PICO_PANEL_SCALE", opt.panel_scale, 1);
+    setenv("PICO_PANEL_RAW", panel_path, 1);
+    if (opt.panel_fail && c >= opt.panel_fail_from) {
+      char mode[2] = {opt.panel_fail, 0};
+      setenv("PICO_PANEL_FAIL", mode, 1);
+    }
+    if (!opt.verbose) {
+      int devnull = open("/dev/null", O_WRONLY);
+      dup2(devnull, STDOUT_FILENO);
+    }
+    close(master);
+    close(slave);
+    execv(argv[0], argv);
+    perror(argv[0]);
+    _exit(127);
+  }
+
+  reader_t rd = {master, {0}, 0, 0};
+  char line[LINE_MAX_LEN];
+  size_t len = 0;
+  for (;;) {
+    int b = read_byte(&rd, SILENCE_MS);
+    if (b < 0) {
+      printf("  firmware %s\n", b == -1 ? "went silent" : "is gone");
+      break;
+    }
+    if (b != '\n') {
+      if (len < sizeof(line) - 1)
+        line[len++] = (char)b;
+      continue;
+    }
+    line[len] = '\0';
+    len = 0;
+    if (strncmp(line, "PLOG:", 5) == 0) {
+      int rc;
+      if (sscanf(line + 5, "SENDIMG_RESULT rc=%d", &rc) == 1 &&
+          cy->n_rcs < MAX_ATTEMPTS_SEEN)
+        cy->rcs[cy->n_rcs++] = rc;
+      if (strncmp(line + 5, "REFRESH_SKIPPED", 15) == 0)
+        cy->skipped = 1;
+      if ((sscanf(line + 5, "FRAME_STORE rc=%d", &rc) == 1 ||
+           sscanf(line + 5, "FRAME_SHOWN rc=%d", &rc) == 1) &&
+          rc != 0)
+        cy->sd_fail = 1;
+      if (opt.verbose)
+        printf("[PICO] %s\n", line + 5);
+    } else if (strncmp(line, "PICODONE", 8) == 0) {
+      cy->done = 1;
+      break;
+    } else if (strncmp(line, "SENDIMG", 7) == 0) {
+      int64_t t_req = now_us();
+      static char req[LINE_MAX_LEN + TILE_HASH_BLOCK(TILE_MAX) + 1];
+      size_t rlen = strlen(line);
+      memcpy(req, line, rlen);
+      req[rlen++] = '\n';
+      int tiles = link_parse_tiles(line);
+      if (tiles > TILE_MAX)
+        tiles = 0;
+      size_t block = tiles ? TILE_HASH_BLOCK(tiles) : 0;
+      int ok = 1;
+      for (size_t i = 0; i < block && ok; i++) {
+        int h = read_byte(&rd, 1000);
+        ok = h >= 0;
+        req[rlen++] = (char)h;
+      }
+      if (!ok)
+        continue;  // cut-off hash block: the firmware will time out
+      if (block)
+        t_req = now_us();
+      cy->attempts++;
+      attempt_t at;
+      serve(master, peer, req, t_req, &at);
+      if (at.answered) {
+        sum->ttfb_ms += at.ttfb_ms;
+        sum->payload_ms += at.payload_ms;
+        sum->wire += at.wire;
+        (*answered)++;
+      }
+    }
+  }
+  cy->total_ms = (double)(now_us() - t_on) / 1000.0;
+  kill(pid, SIGKILL);  // the ESP32 cuts power
+  waitpid(pid, NULL, 0);
+  close(slave);
+  close(master);
+
+  cy->panel = -1;
+  FILE* f = fopen(panel_path, "rb");
+  if (f) {
+    static uint8_t shown[SAMPLE_FRAME_SIZE];
+    cy->panel = fread(shown, 1, sizeof(shown), f) == sizeof(shown) &&
+                memcmp(shown, frame, sizeof(shown)) == 0;
+    fclose(f);
+  }
+
+  int ok = cycle_ok(cy);
+  printf("cycle %d: %s  attempts %d  rc", c, ok ? "ok" : "FAILED",
+         cy->attempts);
+  for (int i = 0; i < cy->n_rcs; i++)
+    printf("%s%d", i ? "," : " ", cy->rcs[i]);
+  printf("  panel %s%s%s  power-on to PICODONE %.0f ms\n",
+         cy->panel > 0 ? "shows it" : cy->panel ? "blank" : "DIFFERS",
+         cy->skipped ? " (refresh skipped)" : "",
+         cy->sd_fail ? "  SD FAILED" : "", cy->total_ms);
+}
+
+static int parse_options(int argc, char** argv) {
+  static const uint32_t rates[] = {2000000, 921600};
+  opt.cycles = 3;
+  memcpy(opt.rates, rates, sizeof(rates));
+  opt.n_rates = 2;
+  opt.has_cts = 1;
+  opt.formats = LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC | LINK_FMT_DELTA;
+  opt.reliable_max = 4000000;
+  opt.latency_ms = 5;
+  opt.panel_scale = "0.01";
+  int ch;
+  while ((ch = getopt(argc, argv, "+n:b:RLF:l:j:r:f:d:m:i:p:P:s:v")) != -1) {
+    switch (ch) {
+      case 'n':
+        opt.cycles = atoi(optarg);
+        break;
+      case 'b': {
+        opt.n_rates = 0;
+        for (char* t = strtok(optarg, ","); t && opt.n_rates < LINK_MAX_RATES;
+             t = strtok(NULL, ","))
+          if (atol(t) > 0)
+            opt.rates[opt.n_rates++] = (uint32_t)atol(t);
+        break;
+      }
+      case 'R':
+        opt.has_cts = 0;
+        break;
+      case 'L':
+        opt.legacy = 1;
+        break;
+      case 'F':
+        opt.formats = 0;
+        if (strstr(optarg, "LZ"))
+          opt.formats |= LINK_FMT_LZ;
+        if (strstr(optarg, "P3"))
+          opt.formats |= LINK_FMT_P3;
+        if (strstr(optarg, "CRC"))
+          opt.formats |= LINK_FMT_CRC;
+        if (strstr(optarg, "DELTA"))
+          opt.formats |= LINK_FMT_DELTA;
+        break;
+      case 'l':
+        opt.latency_ms = atoi(optarg);
+        break;
+      case 'j':
+        opt.jitter_ms = atoi(optarg);
+        break;
+      case 'r':
+        opt.reliable_max = (uint32_t)atol(optarg);
+        break;
+      case 'f':
+        opt.flip_ppm = (uint32_t)atol(optarg);
+        break;
+      case 'd':
+        opt.drop_ppm = (uint32_t)atol(optarg);
+        break;
+      case 'm':
+        opt.mute = atoi(optarg);
+        break;
+      case 'i':
+        opt.frame_file = optarg;
+        break;
+      case 'p':
+        opt.panel_scale = optarg;
+        break;
+      case 'P': {
+        opt.panel_fail = optarg[0];
+        const char* at = strchr(optarg, '@');
+        opt.panel_fail_from = at ? atoi(at + 1) : 1;
+        if (opt.panel_fail != 'A' && opt.panel_fail != 'B')
+          return -1;
+        break;
+      }
+      case 's':
+        seed = (uint32_t)atol(optarg);
+        break;
+      case 'v':
+        opt.verbose = 1;
+        break;
+      default:
+        return -1;
+    }
+  }
+  return (optind < argc) ? optind : -1;
+}
+
+int main(int argc, char** argv) {
+  int first = parse_options(argc, argv);
+  if (first < 0) {
+    fprintf(stderr,
+            "usage: %s [options] firmware [args]\n"
+            "  -n cycles      power cycles (3)\n"
+            "  -b r1,r2       rates the peer can switch to (2000000,921600;"
+            " 0: none)\n"
+            "  -R             peer has no CTS, never confirms FLOW=RTS\n"
+            "  -L             legacy peer: bare ACK, 115200 only\n"
+            "  -F LZ,P3,CRC,DELTA  formats the peer produces (all)\n"
+            "  -l ms          reply latency before the ACK (5)\n"
+            "  -j ms          random extra latency, and stalls up to ms"
+            " every 4 KB (0)\n"
+            "  -r baud        bit errors on frames faster than this\n"
+            "  -f ppm, -d ppm bit flips / dropped bytes after the ACK\n"
+            "  -m n           leave the first n requests unanswered\n"
+            "  -i file        raw 4bpp frame to send (default: dashboard,"
+            " one minute per cycle)\n"
+            "  -p scale       panel timing scale for the firmware (0.01)\n"
+            "  -P A|B[@n]     panel fails like Bug #15 mode A or B (from"
+            " cycle n)\n"
+            "  -s seed        fault / jitter PRNG seed\n"
+            "  -v             show firmware output and PLOG lines\n",
+            argv[0]);
+    return 2;
+  }
+  if (opt.frame_file) {
+    FILE* f = fopen(opt.frame_file, "rb");
+    if (!f || fread(frame, 1, sizeof(frame), f) != sizeof(frame)) {
+      fprintf(stderr, "%s: need a %d-byte raw frame\n", opt.frame_file,
+              SAMPLE_FRAME_SIZE);
+      return 2;
+    }
+    fclose(f);
+  }
+  char sd_dir[] = "/tmp/fake_esp32.XXXXXX";
+  if (!mkdtemp(sd_dir)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  setenv("PICO_SD_DIR", sd_dir, 1);
+  snprintf(panel_path, sizeof(panel_path), "%s/panel.bin", sd_dir);
+  signal(SIGPIPE, SIG_IGN);
+
+  fake_peer_t peer;
+  fake_peer_init(&peer, opt.rates, opt.n_rates, opt.has_cts,
+                 opt.reliable_max);
+  peer.legacy = opt.legacy;
+  peer.formats = opt.formats;
+
+  attempt_t sum = {0, 0, 0, 0};
+  int answered = 0, ok = 0, retries = 0;
+  for (int c = 1; c <= opt.cycles; c++) {
+    if (!opt.frame_file)
+      sample_frame_dashboard(frame, c);
+    cycle_t cy;
+    run_cycle(c, argv + first, &peer, &cy, &sum, &answered);
+    ok += cycle_ok(&cy);
+    retries += cy.attempts > 1 ? cy.attempts - 1 : 0;
+  }
+  printf("%d cycles, %d ok, %d retries", opt.cycles, ok, retries);
+  if (answered)
+    printf("; mean ttfb %.1f ms, payload %.1f ms, wire %zu B",
+           sum.ttfb_ms / answered, sum.payload_ms / answered,
+           sum.wire / (size_t)answered);
+  printf("\n");
+
+  static const char* const sd_files[] = {"lastframe.bin", "shown.bin"};
+  for (size_t i = 0; i < sizeof(sd_files) / sizeof(sd_files[0]); i++) {
+    char path[sizeof(sd_dir) + 32];
+    snprintf(path, sizeof(path), "%s/%s", sd_dir, sd_files[i]);
+    unlink(path);
+  }
+  unlink(panel_path);
+  rmdir(sd_dir);
+  return ok == opt.cycles ? 0 : 1;
+}
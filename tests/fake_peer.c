@@ -0,0 +1,261 @@
+#include "fake_peer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/Link/crc32.h"
+#include "../lib/Link/lz_decode.h"
+#include "../lib/Link/pack3.h"
+#include "../lib/Link/tiles.h"
+#include "../tools/lz_encode.h"
+
+void fake_peer_init(fake_peer_t* peer,
+                    const uint32_t* rates,
+                    int n_rates,
+                    int has_cts,
+                    uint32_t reliable_max) {
+  memset(peer, 0, sizeof(*peer));
+  if (n_rates > LINK_MAX_RATES)
+    n_rates = LINK_MAX_RATES;
+  memcpy(peer->rates, rates, sizeof(uint32_t) * (size_t)n_rates);
+  peer->n_rates = n_rates;
+  peer->has_cts = has_cts;
+  peer->reliable_max = reliable_max;
+  peer->frame_baud = LINK_BASE_BAUD;
+  peer->frame_width = 800;
+  peer->seed = 0x12345678u;
+}
+
+static uint32_t next_rand(fake_peer_t* peer) {
+  peer->seed = peer->seed * 1664525u + 1013904223u;
+  return peer->seed >> 8;
+}
+
+// Pick the first offered rate (offers are fastest first) the peer supports.
+static uint32_t choose_rate(const fake_peer_t* peer,
+                            const uint32_t* offered,
+                            int n_offered) {
+  for (int i = 0; i < n_offered; i++)
+    for (int j = 0; j < peer->n_rates; j++)
+      if (offered[i] == peer->rates[j])
+        return offered[i];
+  return LINK_BASE_BAUD;
+}
+
+// Delta body for frame against the Pico's tile hashes: bitmap of the tiles
+// that differ, then those tiles. Returns its length (0 if every tile
+// matches); *tiles_len gets the length of the tile part.
+static size_t build_delta(const tile_grid_t* g,
+                          const uint32_t* have,
+                          const uint8_t* frame,
+                          uint8_t* out,
+                          size_t* tiles_len) {
+  static uint32_t want[TILE_MAX];
+  tile_hashes(g, frame, want);
+  size_t bm_len = TILE_BITMAP_BYTES((size_t)g->count);
+  memset(out, 0, bm_len);
+  size_t n = bm_len;
+  for (int i = 0; i < g->count; i++) {
+    if (want[i] == have[i])
+      continue;
+    out[i >> 3] |= (uint8_t)(1u << (i & 7));
+    tile_get(g, frame, i, out + n);
+    n += TILE_BYTES;
+  }
+  *tiles_len = n - bm_len;
+  return *tiles_len ? n : 0;
+}
+
+// Encode src (head bytes kept as-is, then body) as fmt. Returns the payload
+// length, or 0 when out of memory; *out must be freed by the caller.
+static size_t encode(uint8_t fmt,
+                     const uint8_t* src,
+                     size_t head,
+                     size_t body,
+                     uint8_t** out) {
+  size_t groups = body / PACK3_GROUP_OUT;
+  size_t len = head + body;
+  uint8_t* p3 = NULL;
+  if (fmt & LINK_FMT_P3) {
+    if (!(p3 = malloc(head + groups * PACK3_GROUP_IN)))
+      return 0;
+    memcpy(p3, src, head);
+    pack3_pack(p3 + head, src + head, groups);
+    src = p3;
+    len = head + groups * PACK3_GROUP_IN;
+  }
+  if (fmt & LINK_FMT_LZ) {
+    uint8_t* lz = malloc(LZ_BOUND(len));
+    len = lz ? lz_encode(src, len, lz) : 0;
+    free(p3);
+    *out = lz;
+    return len;
+  }
+  if (!p3 && (p3 = malloc(len)))
+    memcpy(p3, src, len);
+  *out = p3;
+  return p3 ? len : 0;
+}
+
+size_t fake_peer_respond(fake_peer_t* peer,
+                         const char* request,
+                         const uint8_t* frame,
+                         size_t frame_len,
+                         uint8_t* out,
+                         size_t cap) {
+  // The request line ends at '\n'; a TILES= hash block may follow it.
+  char line[160];
+  size_t line_len = strcspn(request, "\n");
+  if (line_len >= sizeof(line))
+    return 0;
+  memcpy(line, request, line_len);
+  line[line_len] = '\0';
+
+  uint32_t offered[LINK_MAX_RATES];
+  int flow_req = 0;
+  uint8_t fmt_req = 0;
+  int n_offered = link_parse_request(line, offered, LINK_MAX_RATES,
+                                     &flow_req, &fmt_req);
+  if (n_offered < 0)
+    return 0;
+  uint8_t usable = peer->legacy ? 0 : (uint8_t)(fmt_req & peer->formats);
+
+  // Resume only for the frame the Pico was receiving, at a P3 group
+  // boundary if the rest is to be packed.
+  link_resume_t req_resume;
+  int req_has_id = link_parse_resume(line, &req_resume);
+  peer->frame_id = crc32_update(0, frame, frame_len);
+  peer->frame_from = 0;
+  if ((usable & LINK_FMT_CRC) && req_has_id && req_resume.from &&
+      req_resume.id == peer->frame_id && req_resume.from < frame_len)
+    peer->frame_from = req_resume.from;
+  if (peer->frame_from % PACK3_GROUP_OUT)
+    usable &= (uint8_t)~LINK_FMT_P3;
+  frame += peer->frame_from;
+  frame_len -= peer->frame_from;
+
+  // A delta needs the whole frame and a hash block that survived the trip.
+  static uint32_t have[TILE_MAX];
+  tile_grid_t grid;
+  int n_tiles = link_parse_tiles(line);
+  if (!(usable & LINK_FMT_DELTA) || peer->frame_from || n_tiles <= 0 ||
+      tile_grid_init(&grid, peer->frame_width,
+                     (int)(frame_len * 2 / (size_t)peer->frame_width)) ||
+      grid.count != n_tiles ||
+      tile_hashes_unpack((const uint8_t*)request + line_len + 1, n_tiles,
+                         have) != 0)
+    usable &= (uint8_t)~LINK_FMT_DELTA;
+  uint8_t* delta = NULL;
+  size_t delta_len = 0, delta_tiles = 0;
+  peer->frame_tiles = 0;
+  if ((usable & LINK_FMT_DELTA) &&
+      (delta = malloc(TILE_BITMAP_BYTES(TILE_MAX) + frame_len))) {
+    delta_len = build_delta(&grid, have, frame, delta, &delta_tiles);
+    peer->frame_tiles = (int)(delta_tiles / TILE_BYTES);
+  }
+
+  // Send the smallest of the formats both sides support. LZ alone often
+  // beats LZ|P3 on flat dashboards, since packing breaks byte-aligned runs.
+  uint8_t* payload = NULL;
+  size_t payload_len = 0;
+  peer->frame_fmt = LINK_FMT_RAW;
+  for (int c = 0; c < 8; c++) {
+    uint8_t fmt = (uint8_t)(((c & 1) ? LINK_FMT_LZ : 0) |
+                            ((c & 2) ? LINK_FMT_P3 : 0) |
+                            ((c & 4) ? LINK_FMT_DELTA : 0));
+    if ((fmt & ~usable) || ((fmt & LINK_FMT_DELTA) && !delta_len))
+      continue;
+    uint8_t* enc = NULL;
+    size_t n = (fmt & LINK_FMT_DELTA)
+                   ? encode(fmt, delta, delta_len - delta_tiles, delta_tiles,
+                            &enc)
+                   : encode(fmt, frame, 0, frame_len, &enc);
+    if (enc && (!payload || n < payload_len)) {
+      free(payload);
+      payload = enc;
+      payload_len = n;
+      peer->frame_fmt = fmt;
+    } else {
+      free(enc);
+    }
+  }
+  free(delta);
+  if (!payload)
+    return 0;
+  if (!(peer->frame_fmt & LINK_FMT_DELTA))
+    peer->frame_tiles = 0;
+  const int chunked = (usable & LINK_FMT_CRC) != 0;
+  if (chunked)
+    peer->frame_fmt |= LINK_FMT_CRC;
+  peer->frame_wire_len = payload_len;
+
+  peer->frame_baud = LINK_BASE_BAUD;
+  peer->frame_flow = 0;
+  char ack[96];
+  int alen = snprintf(ack, sizeof(ack), "ACK");
+  if (!peer->legacy) {
+    peer->frame_baud = choose_rate(peer, offered, n_offered);
+    peer->frame_flow =
+        (peer->frame_baud != LINK_BASE_BAUD) && flow_req && peer->has_cts;
+    if (peer->frame_baud != LINK_BASE_BAUD)
+      alen += snprintf(ack + alen, sizeof(ack) - (size_t)alen,
+                       " BAUD=%lu%s", (unsigned long)peer->frame_baud,
+                       peer->frame_flow ? " FLOW=RTS" : "");
+    if (peer->frame_from)
+      alen += snprintf(ack + alen, sizeof(ack) - (size_t)alen, " FROM=%lu",
+                       (unsigned long)peer->frame_from);
+    if (chunked)
+      alen += snprintf(ack + alen, sizeof(ack) - (size_t)alen, " ID=%08lX",
+                       (unsigned long)peer->frame_id);
+  }
+  snprintf(ack + alen, sizeof(ack) - (size_t)alen, "\n");
+
+  size_t ack_len = strlen(ack);
+  size_t body = chunked ? LINK_CHUNKED_LEN(payload_len) : payload_len;
+  size_t need = 2 * ack_len + 8 + body;
+  size_t n = 0;
+  if (need > cap)
+    goto out;
+  memcpy(out + n, ack, ack_len);
+  n += ack_len;
+  memcpy(out + n, ack, ack_len);
+  n += ack_len;
+
+  // Everything below travels at frame_baud.
+  size_t frame_start = n;
+  static const uint8_t sof[4] = {0xAA, 0x55, 0xAA, 0x55};
+  memcpy(out + n, sof, 4);
+  n += 4;
+  uint32_t hdr = ((uint32_t)peer->frame_fmt << 24) | (uint32_t)payload_len;
+  out[n++] = (uint8_t)(hdr >> 24);
+  out[n++] = (uint8_t)(hdr >> 16);
+  out[n++] = (uint8_t)(hdr >> 8);
+  out[n++] = (uint8_t)hdr;
+  for (size_t off = 0; off < payload_len;) {
+    size_t len = payload_len - off;
+    if (chunked && len > LINK_CHUNK_SIZE)
+      len = LINK_CHUNK_SIZE;
+    memcpy(out + n, payload + off, len);
+    n += len;
+    if (chunked) {
+      uint32_t crc = crc32_update(0, payload + off, len);
+      out[n++] = (uint8_t)(crc >> 24);
+      out[n++] = (uint8_t)(crc >> 16);
+      out[n++] = (uint8_t)(crc >> 8);
+      out[n++] = (uint8_t)crc;
+    }
+    off += len;
+  }
+
+  if (peer->frame_baud > peer->reliable_max) {
+    // Roughly one bit error per 1000 bytes past the switch.
+    for (size_t i = frame_start; i < n; i++)
+      if (next_rand(peer) % 1000 == 0)
+        out[i] ^= (uint8_t)(1u << (next_rand(peer) & 7));
+  }
+
+out:
+  free(payload);
+  return n;
+}
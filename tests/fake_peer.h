@@ -0,0 +1,55 @@
+#ifndef _FAKE_PEER_H_
+#define _FAKE_PEER_H_
+
+// Host stand-in for the ESP32 side of the SENDIMG protocol.
+//
+// fake_peer_respond() takes one request line and produces the byte stream
+// the ESP32 would send back: ACK lines (with the negotiated options), SOF,
+// 4-byte big-endian size header and the payload (packed and/or LZ-compressed
+// when the request offers FMT=P3 / FMT=LZ and the peer supports them), cut
+// into CRC32-checked chunks with FMT=CRC. A FROM= / ID= resume request for
+// the same frame is honoured, and with FMT=DELTA and a TILES= hash block
+// after the request line only the changed tiles are sent when that is
+// smaller. The line rate of the frame is recorded in
+// frame_baud; frames sent faster than reliable_max get bit errors, which
+// models a link that cannot carry the negotiated rate.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../lib/Link/link_proto.h"
+
+typedef struct {
+  uint32_t rates[LINK_MAX_RATES];  // rates the peer can switch to
+  int n_rates;
+  int has_cts;            // peer honours FLOW=RTS
+  int legacy;             // reply with a bare "ACK" (pre-negotiation peer)
+  uint8_t formats;        // LINK_FMT_* bits the peer can produce
+  uint32_t reliable_max;  // frames above this rate are corrupted
+  uint32_t frame_baud;    // rate used for the last frame
+  int frame_flow;         // flow control used for the last frame
+  uint8_t frame_fmt;      // payload format of the last frame
+  size_t frame_wire_len;  // payload bytes on the wire for the last frame
+  uint32_t frame_id;      // CRC32 of the last frame (ACK ID=)
+  uint32_t frame_from;    // resume offset honoured for the last frame
+  int frame_tiles;        // tiles sent in the last frame (delta only)
+  int frame_width;        // pixels per row, for the delta tile grid
+  uint32_t seed;          // corruption PRNG state
+} fake_peer_t;
+
+void fake_peer_init(fake_peer_t* peer,
+                    const uint32_t* rates,
+                    int n_rates,
+                    int has_cts,
+                    uint32_t reliable_max);
+
+// request is what the Pico sent: the SENDIMG line and, with TILES=, the hash
+// block right after its '\n'. Returns the number of bytes written to out (0
+// if request is not SENDIMG or out is too small).
+size_t fake_peer_respond(fake_peer_t* peer,
+                         const char* request,
+                         const uint8_t* frame,
+                         size_t frame_len,
+                         uint8_t* out,
+                         size_t cap);
+
+#endif
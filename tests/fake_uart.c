@@ -0,0 +1,104 @@
+#include "fake_uart.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+// Match UART_RX_POLL_US and UART_RX_DMA_MARGIN in lib/Link/uart_rx.c.
+#define FAKE_UART_POLL_US 50
+#define FAKE_UART_DMA_MARGIN 512
+
+int64_t fake_uart_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us) {
+  struct timespec ts = {us / 1000000, (long)(us % 1000000) * 1000};
+  nanosleep(&ts, NULL);
+}
+
+static void* wire_thread(void* arg) {
+  fake_uart_t* fu = arg;
+  int64_t t0 = fake_uart_now_us();
+  while (!fu->stop && fu->sent < fu->src_len) {
+    size_t due = fu->src_len;
+    if (fu->baud) {
+      int64_t elapsed = fake_uart_now_us() - t0;
+      due = (size_t)(elapsed * (int64_t)fu->baud / 10 / 1000000);
+      if (due > fu->src_len)
+        due = fu->src_len;
+    }
+    while (fu->sent < due) {
+      if (!fu->baud &&
+          fu->ring.head - fu->ring.tail >= fu->ring.size - fu->ring.margin)
+        break;  // unthrottled: behave like a flow-controlled link
+      uint8_t c = fu->src[fu->sent++];
+      if (fu->dma) {
+        // DMA never waits for the reader: it wraps and overwrites.
+        uint32_t head = fu->ring.head;
+        fu->ring.buf[head & (fu->ring.size - 1)] = c;
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        fu->ring.head = head + 1;
+      } else {
+        rx_ring_put(&fu->ring, c);
+      }
+    }
+    if (fu->baud)
+      sleep_us(FAKE_UART_POLL_US);
+  }
+  return NULL;
+}
+
+int fake_uart_start(fake_uart_t* fu,
+                    uint32_t ring_size,
+                    uint32_t baud,
+                    int dma,
+                    const uint8_t* src,
+                    size_t src_len) {
+  if (ring_size == 0 || (ring_size & (ring_size - 1)) != 0)
+    return -1;
+  fu->storage = malloc(ring_size);
+  if (!fu->storage)
+    return -1;
+  rx_ring_init(&fu->ring, fu->storage, ring_size);
+  if (dma) {
+    // Rings smaller than the firmware's keep half of themselves as margin.
+    fu->ring.margin = ring_size > FAKE_UART_DMA_MARGIN ? FAKE_UART_DMA_MARGIN
+                                                       : ring_size / 2;
+  }
+  fu->baud = baud;
+  fu->dma = dma;
+  fu->src = src;
+  fu->src_len = src_len;
+  fu->sent = 0;
+  fu->stop = 0;
+  if (pthread_create(&fu->thread, NULL, wire_thread, fu) != 0) {
+    free(fu->storage);
+    return -1;
+  }
+  return 0;
+}
+
+size_t fake_uart_read(fake_uart_t* fu,
+                      uint8_t* buf,
+                      size_t n,
+                      int32_t timeout_ms) {
+  size_t got = 0;
+  int64_t deadline = fake_uart_now_us() + (int64_t)timeout_ms * 1000;
+  for (;;) {
+    got += fu->ring.lost ? 0 : rx_ring_read(&fu->ring, buf + got,
+                                            (uint32_t)(n - got));
+    if (got >= n || fu->ring.lost || fake_uart_now_us() >= deadline)
+      break;
+    sleep_us(FAKE_UART_POLL_US);
+  }
+  return got;
+}
+
+void fake_uart_stop(fake_uart_t* fu) {
+  fu->stop = 1;
+  pthread_join(fu->thread, NULL);
+  free(fu->storage);
+  fu->storage = NULL;
+}
@@ -0,0 +1,46 @@
+#ifndef _FAKE_UART_H_
+#define _FAKE_UART_H_
+
+// Host stand-in for the Pico UART RX engine (lib/Link/uart_rx.c).
+//
+// A producer thread plays the wire: it paces bytes from a source buffer at a
+// given baud rate (8N1, 10 bits per byte) into the same rx_ring_t the firmware
+// uses, either dropping on full like the IRQ path or overwriting like the DMA
+// ring (with the firmware's DMA margin). fake_uart_read() mirrors
+// uart_rx_read(), including returning early once ring.lost is set, so receive
+// code and benchmarks see the same semantics as on the Pico.
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../lib/Link/rx_ring.h"
+
+typedef struct {
+  rx_ring_t ring;
+  uint8_t* storage;
+  uint32_t baud;  // 0 = unthrottled, waits for ring space
+  int dma;        // 1 = overwrite on lap (DMA), 0 = drop when full (IRQ)
+  const uint8_t* src;
+  size_t src_len;
+  size_t sent;
+  pthread_t thread;
+  volatile int stop;
+} fake_uart_t;
+
+// ring_size must be a power of two. Returns 0 on success.
+int fake_uart_start(fake_uart_t* fu,
+                    uint32_t ring_size,
+                    uint32_t baud,
+                    int dma,
+                    const uint8_t* src,
+                    size_t src_len);
+size_t fake_uart_read(fake_uart_t* fu,
+                      uint8_t* buf,
+                      size_t n,
+                      int32_t timeout_ms);
+void fake_uart_stop(fake_uart_t* fu);
+
+// Monotonic microseconds, shared by the host benchmarks.
+int64_t fake_uart_now_us(void);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef _HOST_FF_H_
+#define _HOST_FF_H_
+
+// The FatFs calls lib/Link/frame_store.c makes, on plain files in the
+// directory named by $PICO_SD_DIR (default: the current one), so the delta
+// base survives from one host firmware run to the next like the SD card.
+// The card only answers while its CS and MISO pins are muxed for it
+// (host_sd_wired() in tests/host/host_pico.c).
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef enum { FR_OK = 0, FR_DISK_ERR, FR_NO_FILE } FRESULT;
+typedef unsigned int UINT;
+typedef unsigned char BYTE;
+typedef struct {
+  int unused;
+} FATFS;
+typedef struct {
+  FILE* f;
+} FIL;
+
+#define FA_READ 0x01
+#define FA_WRITE 0x02
+#define FA_CREATE_ALWAYS 0x08
+
+bool host_sd_wired(void);
+
+static inline FRESULT f_mount(FATFS* fs, const char* path, BYTE opt) {
+  (void)fs;
+  (void)path;
+  (void)opt;
+  return host_sd_wired() ? FR_OK : FR_DISK_ERR;
+}
+
+static inline FRESULT f_open(FIL* fp, const char* name, BYTE mode) {
+  if (!host_sd_wired())
+    return FR_DISK_ERR;
+  const char* dir = getenv("PICO_SD_DIR");
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", dir ? dir : ".", name);
+  fp->f = fopen(path, (mode & FA_WRITE) ? "wb" : "rb");
+  return fp->f ? FR_OK : FR_NO_FILE;
+}
+
+static inline FRESULT f_read(FIL* fp, void* buf, UINT n, UINT* got) {
+  *got = (UINT)fread(buf, 1, n, fp->f);
+  return ferror(fp->f) ? FR_DISK_ERR : FR_OK;
+}
+
+static inline FRESULT f_write(FIL* fp, const void* buf, UINT n, UINT* put) {
+  *put = (UINT)fwrite(buf, 1, n, fp->f);
+  return (*put == n) ? FR_OK : FR_DISK_ERR;
+}
+
+static inline FRESULT f_close(FIL* fp) {
+  return fclose(fp->f) == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+#endif
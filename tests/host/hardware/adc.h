@@ -0,0 +1,4 @@
+#ifndef _HOST_HARDWARE_ADC_H_
+#define _HOST_HARDWARE_ADC_H_
+
+#endif
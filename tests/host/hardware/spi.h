@@ -0,0 +1,7 @@
+#ifndef _HOST_HARDWARE_SPI_H_
+#define _HOST_HARDWARE_SPI_H_
+
+// Included by DEV_Config.h; the host build replaces DEV_Config.c with
+// tests/host/host_dev.c and needs nothing from here.
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef _HOST_HARDWARE_UART_H_
+#define _HOST_HARDWARE_UART_H_
+
+// UART1 on the pseudo-terminal named by $PICO_UART (see host_pico.c).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t* const uart0;
+extern uart_inst_t* const uart1;
+
+unsigned int uart_init(uart_inst_t* uart, unsigned int baud);
+unsigned int uart_set_baudrate(uart_inst_t* uart, unsigned int baud);
+void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts);
+void uart_puts(uart_inst_t* uart, const char* s);
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len);
+void uart_tx_wait_blocking(uart_inst_t* uart);
+
+#endif
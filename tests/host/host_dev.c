@@ -0,0 +1,281 @@
+// Host stand-in for lib/Config/DEV_Config.c: no SPI or I2C, but a virtual
+// 7.3" ACeP panel behind the pins, so lib/e-Paper/EPD_7in3f.c runs
+// unchanged and what it draws can be looked at.
+//
+// The controller follows the command/data stream: 0x10 fills its 4bpp
+// frame RAM, 0x12 shows it, 0x04/0x02 switch the booster, 0x07 0xA5 puts
+// it to sleep until the next reset pulse. BUSY (LOW = busy) drops for a
+// while after a reset pulse, POWER_ON (only when the panel was off),
+// DISPLAY_REFRESH and POWER_OFF.
+//
+//   $PICO_PANEL_MS     reset,power_on,refresh,power_off BUSY times in ms
+//                      (100,100,30600,150: a healthy panel)
+//   $PICO_PANEL_SCALE  scales those, DEV_Delay_ms() and DEV_Deadline_ms()
+//                      (default 1; fake_esp32 passes 0.01 so a cycle does
+//                      not take 35 s)
+//   $PICO_PANEL_FAIL   A or B: the Bug #15 failure modes (host_panel.h)
+//   $PICO_PANEL_PPM    each refresh writes the shown frame there as a PPM
+//   $PICO_PANEL_RAW    ... and as the raw 4bpp frame, which the next run
+//                      starts out showing
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DEV_Config.h"
+#include "host_panel.h"
+
+enum { PANEL_RESET, PANEL_POWER_ON, PANEL_REFRESH, PANEL_POWER_OFF };
+
+// ACeP colour indices 0-7 (7: "clean", shown grey).
+static const UBYTE panel_rgb[8][3] = {
+    {0, 0, 0},     {255, 255, 255}, {0, 160, 0},   {0, 0, 200},
+    {200, 0, 0},   {255, 220, 0},   {255, 128, 0}, {160, 160, 160}};
+
+static int panel_ms[4] = {100, 100, 30600, 150};
+static double panel_scale_f = 1.0;
+static char panel_fail = 0;
+static const char* panel_ppm = NULL;
+static const char* panel_raw = NULL;
+
+static UBYTE pin_dc = 1;
+static UBYTE pin_rst = 1;
+static int panel_on = 0;
+static int panel_asleep = 0;
+static absolute_time_t busy_until = 0;
+static int busy_low = 0;  // a fall was counted, its rise not yet
+
+static UBYTE panel_cmd = 0;
+static UDOUBLE panel_frame_n = 0;  // data bytes since the last 0x10
+static UBYTE panel_ram[HOST_PANEL_FRAME_BYTES];
+static UBYTE panel_shown[HOST_PANEL_FRAME_BYTES];
+static int panel_refreshes = 0;
+
+volatile UDOUBLE dev_busy_rises = 0;
+volatile UDOUBLE dev_busy_falls = 0;
+volatile uint64_t dev_busy_rise_us = 0;
+volatile uint64_t dev_busy_fall_us = 0;
+
+static void panel_setup(void) {
+  static int done = 0;
+  if (done)
+    return;
+  done = 1;
+  const char* s = getenv("PICO_PANEL_SCALE");
+  if (s && atof(s) >= 0)
+    panel_scale_f = atof(s);
+  s = getenv("PICO_PANEL_MS");
+  if (s)
+    sscanf(s, "%d,%d,%d,%d", &panel_ms[PANEL_RESET], &panel_ms[PANEL_POWER_ON],
+           &panel_ms[PANEL_REFRESH], &panel_ms[PANEL_POWER_OFF]);
+  s = getenv("PICO_PANEL_FAIL");
+  if (s && (s[0] == 'A' || s[0] == 'B'))
+    panel_fail = s[0];
+  panel_ppm = getenv("PICO_PANEL_PPM");
+  panel_raw = getenv("PICO_PANEL_RAW");
+  memset(panel_ram, 0x11, sizeof(panel_ram));
+  memset(panel_shown, 0x11, sizeof(panel_shown));
+  // The picture outlives the power cut: pick up where the last run left it.
+  FILE* f = panel_raw ? fopen(panel_raw, "rb") : NULL;
+  if (f) {
+    if (fread(panel_shown, 1, sizeof(panel_shown), f) != sizeof(panel_shown))
+      memset(panel_shown, 0x11, sizeof(panel_shown));
+    fclose(f);
+  }
+}
+
+static void panel_busy(int phase) {
+  uint64_t us = (uint64_t)(panel_ms[phase] * panel_scale_f * 1000);
+  if (panel_ms[phase] && us < 1000)
+    us = 1000;  // still seen LOW right after the command
+  absolute_time_t now = get_absolute_time();
+  busy_until = now + us;
+  if (us && !busy_low) {
+    busy_low = 1;
+    dev_busy_falls++;
+    dev_busy_fall_us = now;
+  }
+}
+
+// The GPIO IRQ of the real board: the rise is counted once BUSY has gone
+// HIGH, stamped with when it did.
+static void panel_edges(void) {
+  if (busy_low && time_reached(busy_until)) {
+    busy_low = 0;
+    dev_busy_rises++;
+    dev_busy_rise_us = busy_until;
+  }
+}
+
+static void panel_save(void) {
+  if (panel_raw) {
+    FILE* f = fopen(panel_raw, "wb");
+    if (f) {
+      fwrite(panel_shown, 1, sizeof(panel_shown), f);
+      fclose(f);
+    }
+  }
+  if (panel_ppm) {
+    FILE* f = fopen(panel_ppm, "wb");
+    if (!f)
+      return;
+    fprintf(f, "P6\n800 480\n255\n");
+    for (UDOUBLE i = 0; i < sizeof(panel_shown); i++) {
+      fwrite(panel_rgb[(panel_shown[i] >> 4) & 7], 1, 3, f);
+      fwrite(panel_rgb[panel_shown[i] & 7], 1, 3, f);
+    }
+    fclose(f);
+  }
+}
+
+static void panel_refresh(void) {
+  if (panel_frame_n != HOST_PANEL_FRAME_BYTES)
+    fprintf(stderr, "[PANEL] refresh after %lu of %d frame bytes\n",
+            (unsigned long)panel_frame_n, HOST_PANEL_FRAME_BYTES);
+  memcpy(panel_shown, panel_ram, sizeof(panel_shown));
+  panel_refreshes++;
+  panel_save();
+}
+
+static void panel_command(UBYTE cmd) {
+  if (panel_asleep)
+    return;
+  panel_cmd = cmd;
+  switch (cmd) {
+    case 0x10:
+      panel_frame_n = 0;
+      break;
+    case 0x04:
+      if (panel_fail != 'A' && !panel_on)
+        panel_busy(PANEL_POWER_ON);
+      panel_on = 1;
+      break;
+    case 0x12:
+      if (panel_fail)
+        break;  // no refresh, BUSY never drops
+      panel_busy(PANEL_REFRESH);
+      panel_refresh();
+      break;
+    case 0x02:
+      if (!panel_fail && panel_on)
+        panel_busy(PANEL_POWER_OFF);
+      panel_on = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+static void panel_data(UBYTE b) {
+  if (panel_asleep)
+    return;
+  if (panel_cmd == 0x10) {
+    if (panel_frame_n < HOST_PANEL_FRAME_BYTES)
+      panel_ram[panel_frame_n] = b;
+    panel_frame_n++;
+  } else if (panel_cmd == 0x07 && b == 0xA5) {
+    panel_asleep = 1;
+  }
+}
+
+void DEV_Digital_Write(UWORD Pin, UBYTE Value) {
+  panel_setup();
+  if (Pin == EPD_DC_PIN) {
+    pin_dc = Value;
+  } else if (Pin == EPD_RST_PIN) {
+    if (Value && !pin_rst) {
+      panel_on = 0;
+      panel_asleep = 0;
+      panel_busy(PANEL_RESET);
+    }
+    pin_rst = Value;
+  }
+}
+
+UBYTE DEV_Digital_Read(UWORD Pin) {
+  if (Pin == EPD_BUSY_PIN) {
+    panel_edges();
+    return time_reached(busy_until) ? 1 : 0;
+  }
+  return 0;
+}
+
+// Only BUSY changes by itself: sleep to its rise or the timeout.
+int DEV_Wait_Pin(UWORD Pin, UBYTE Value, UDOUBLE timeout_ms) {
+  absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+  if (Pin == EPD_BUSY_PIN && Value && busy_until < deadline)
+    sleep_until(busy_until);
+  if (DEV_Digital_Read(Pin) == Value)
+    return 0;
+  sleep_until(deadline);
+  return (DEV_Digital_Read(Pin) == Value) ? 0 : -1;
+}
+
+void DEV_SPI_WriteByte(UBYTE Value) {
+  panel_setup();
+  if (pin_dc)
+    panel_data(Value);
+  else
+    panel_command(Value);
+}
+
+void DEV_SPI_Write_nByte(UBYTE* pData, UDOUBLE Len) {
+  for (UDOUBLE i = 0; i < Len; i++)
+    DEV_SPI_WriteByte(pData[i]);
+}
+
+// No DMA on the host: the write is done (and Done called) before returning.
+void DEV_SPI_Write_nByte_DMA(const UBYTE* pData,
+                             UDOUBLE Len,
+                             void (*Done)(void* Ctx),
+                             void* Ctx) {
+  DEV_SPI_Write_nByte((UBYTE*)pData, Len);
+  if (Done)
+    Done(Ctx);
+}
+
+void DEV_SPI_DMA_Wait(void) {}
+
+void I2C_Write_Byte(UBYTE Reg, UBYTE Value) {
+  (void)Reg;
+  (void)Value;
+}
+
+UBYTE I2C_Read_Byte(UBYTE Reg) {
+  (void)Reg;
+  return 0;
+}
+
+void DEV_Delay_ms(UDOUBLE xms) {
+  panel_setup();
+  sleep_us((uint64_t)(xms * panel_scale_f * 1000));
+}
+
+uint64_t DEV_Deadline_ms(UDOUBLE xms) {
+  panel_setup();
+  return time_us_64() + (uint64_t)(xms * panel_scale_f * 1000);
+}
+
+UBYTE DEV_Module_Init(void) {
+  return 0;
+}
+
+void DEV_Module_Exit(void) {}
+
+const UBYTE* host_panel_frame(void) {
+  panel_setup();
+  return panel_shown;
+}
+
+int host_panel_refreshes(void) {
+  return panel_refreshes;
+}
+
+UDOUBLE host_panel_written(void) {
+  return panel_frame_n;
+}
+
+void host_panel_set_fail(char mode) {
+  panel_setup();
+  panel_fail = mode;
+}
@@ -0,0 +1,22 @@
+#ifndef _HOST_PANEL_H_
+#define _HOST_PANEL_H_
+
+// The virtual panel behind tests/host/host_dev.c, for host tests that drive
+// lib/e-Paper/EPD_7in3f.c directly.
+
+#include "DEV_Config.h"
+
+#define HOST_PANEL_FRAME_BYTES (800 * 480 / 2)
+
+// Frame shown by the last refresh (4bpp, as written after 0x10; all white
+// before the first one) and how many refreshes really happened.
+const UBYTE* host_panel_frame(void);
+int host_panel_refreshes(void);
+// Bytes written after the last 0x10 (past the end included).
+UDOUBLE host_panel_written(void);
+// Bug #15 failure modes from the next command on: 'A' BUSY stays HIGH on
+// POWER_ON, DISPLAY_REFRESH and POWER_OFF; 'B' POWER_ON still drops BUSY
+// but the refresh does not happen; 0 healthy. Also set by $PICO_PANEL_FAIL.
+void host_panel_set_fail(char mode);
+
+#endif
@@ -0,0 +1,233 @@
+// Host stand-ins for the Pico SDK and lib/Link/uart_rx.c, so main.c runs on
+// Linux against tests/fake_esp32.c.
+//
+// UART1 is the pseudo-terminal named by $PICO_UART. A reader thread plays
+// the DMA channel: it copies whatever the peer wrote into the same 8 KB
+// rx_ring_t the firmware uses, lapping a slow reader (counted as overruns)
+// unless RTS flow control is on, in which case it stops reading while the
+// ring is full and the peer's writes back up. Baud rates are recorded but
+// a pty has no line rate; the peer paces itself. GPIO4/5 carry UART1 only
+// while muxed to it: with the SD card holding them, writes go nowhere and
+// the peer's bytes are lost, as on the board.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "../../lib/Link/rx_ring.h"
+#include "../../lib/Link/uart_rx.h"
+#include "DEV_Config.h"
+#include "pico/stdlib.h"
+
+#define UART_RX_RING_SIZE 8192  // as UART_RX_RING_BITS 13 in uart_rx.c
+#define UART_RX_POLL_US 50
+#define UART_TX_GPIO 4  // UART_TX_PIN / UART_RX_PIN in main.c
+#define UART_RX_GPIO 5
+
+struct uart_inst {
+  int fd;
+  unsigned int baud;
+  int rts;
+};
+
+static struct uart_inst uart_insts[2] = {{-1, 0, 0}, {-1, 0, 0}};
+uart_inst_t* const uart0 = &uart_insts[0];
+uart_inst_t* const uart1 = &uart_insts[1];
+
+static uint8_t rx_buf[UART_RX_RING_SIZE];
+static rx_ring_t rx_ring;
+static pthread_t rx_thread;
+static uint32_t rx_gap_max_us = 0;
+static uint32_t rx_gaps = 0;
+static uint32_t rx_gap_threshold_us = UINT32_MAX;
+static volatile int gpio_fn[30];
+
+bool stdio_init_all(void) {
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  return true;
+}
+
+void gpio_set_function(uint gpio, int fn) {
+  if (gpio < sizeof(gpio_fn) / sizeof(gpio_fn[0]))
+    gpio_fn[gpio] = fn;
+}
+
+void gpio_put(uint gpio, bool value) {
+  (void)gpio;
+  (void)value;
+}
+
+// The SD card sees its chip select and drives MISO only when they are
+// wired through: CS as a plain GPIO, MISO on the SPI.
+bool host_sd_wired(void) {
+  return gpio_fn[SD_CS_PIN] == GPIO_FUNC_SIO &&
+         gpio_fn[SD_MISO_PIN] == GPIO_FUNC_SPI;
+}
+
+bool gpio_get(uint gpio) {
+  return gpio == 24;  // VBUS: powered from USB
+}
+
+unsigned int uart_init(uart_inst_t* uart, unsigned int baud) {
+  const char* path = getenv("PICO_UART");
+  if (!path) {
+    fprintf(stderr, "PICO_UART is not set\n");
+    exit(2);
+  }
+  uart->fd = open(path, O_RDWR | O_NOCTTY);
+  if (uart->fd < 0) {
+    perror(path);
+    exit(2);
+  }
+  struct termios tio;
+  if (tcgetattr(uart->fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(uart->fd, TCSANOW, &tio);
+  }
+  uart->baud = baud;
+  return baud;
+}
+
+unsigned int uart_set_baudrate(uart_inst_t* uart, unsigned int baud) {
+  uart->baud = baud;
+  return baud;
+}
+
+void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts) {
+  (void)cts;
+  uart->rts = rts;
+}
+
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len) {
+  if (gpio_fn[UART_TX_GPIO] != GPIO_FUNC_UART)
+    return;  // TX pin lent to the SD card
+  while (len) {
+    ssize_t n = write(uart->fd, src, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return;  // peer gone: like a Pico whose power was cut
+    src += n;
+    len -= (size_t)n;
+  }
+}
+
+void uart_puts(uart_inst_t* uart, const char* s) {
+  uart_write_blocking(uart, (const uint8_t*)s, strlen(s));
+}
+
+void uart_tx_wait_blocking(uart_inst_t* uart) {
+  (void)uart;  // writes to the pty are complete when write() returns
+}
+
+// The "DMA channel": pty bytes into the ring, overwriting like the real
+// one. With RTS it waits for room instead.
+static void* rx_pump(void* arg) {
+  uart_inst_t* uart = arg;
+  uint8_t tmp[256];
+  for (;;) {
+    while (uart->rts && rx_ring.head - rx_ring.tail + sizeof(tmp) +
+                            rx_ring.margin > rx_ring.size)
+      usleep(UART_RX_POLL_US);
+    ssize_t n = read(uart->fd, tmp, sizeof(tmp));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return NULL;
+    if (gpio_fn[UART_RX_GPIO] != GPIO_FUNC_UART)
+      continue;  // RX pin lent to the SD card
+    uint32_t head = rx_ring.head;
+    for (ssize_t i = 0; i < n; i++)
+      rx_ring.buf[(head + (uint32_t)i) & (rx_ring.size - 1)] = tmp[i];
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    rx_ring.head = head + (uint32_t)n;
+  }
+}
+
+void uart_rx_init(uart_inst_t* uart) {
+  rx_ring_init(&rx_ring, rx_buf, sizeof(rx_buf));
+  rx_ring.margin = 512;  // UART_RX_DMA_MARGIN in lib/Link/uart_rx.c
+  pthread_create(&rx_thread, NULL, rx_pump, uart);
+}
+
+// A read waited on an empty ring from idle_since until now.
+static void uart_rx_note_gap(uint64_t idle_since) {
+  uint64_t us = time_us_64() - idle_since;
+  if (us > UINT32_MAX)
+    us = UINT32_MAX;
+  if (us > rx_gap_max_us)
+    rx_gap_max_us = (uint32_t)us;
+  if (us > rx_gap_threshold_us)
+    rx_gaps++;
+}
+
+size_t uart_rx_read(uint8_t* buf, size_t n, int32_t timeout_ms) {
+  size_t got = 0;
+  uint64_t idle_since = 0;  // 0: not waiting
+  absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+  for (;;) {
+    uint32_t k = rx_ring.lost ? 0 : rx_ring_read(&rx_ring, buf + got,
+                                                 (uint32_t)(n - got));
+    if (k && idle_since) {
+      uart_rx_note_gap(idle_since);
+      idle_since = 0;
+    }
+    got += k;
+    if (got >= n || rx_ring.lost || time_reached(deadline))
+      break;
+    if (!idle_since)
+      idle_since = time_us_64();
+    sleep_us(UART_RX_POLL_US);
+  }
+  if (idle_since)
+    uart_rx_note_gap(idle_since);
+  return got;
+}
+
+size_t uart_rx_read_some(uint8_t* buf, size_t n, int32_t timeout_ms) {
+  size_t got = 0;
+  uint64_t idle_since = 0;
+  absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+  for (;;) {
+    got = rx_ring.lost ? 0 : rx_ring_read(&rx_ring, buf, (uint32_t)n);
+    if (got || rx_ring.lost || time_reached(deadline))
+      break;
+    if (!idle_since)
+      idle_since = time_us_64();
+    sleep_us(UART_RX_POLL_US);
+  }
+  if (idle_since)
+    uart_rx_note_gap(idle_since);
+  return got;
+}
+
+void uart_rx_flush(void) {
+  rx_ring_drop(&rx_ring);
+}
+
+int uart_rx_lost(void) {
+  (void)rx_ring_pending(&rx_ring);
+  return rx_ring.lost;
+}
+
+void uart_rx_get_stats(uart_rx_stats_t* out) {
+  (void)rx_ring_pending(&rx_ring);  // folds any lap into overruns
+  out->bytes = rx_ring.head;
+  out->overruns = rx_ring.overruns;
+  out->hw_overruns = 0;
+  out->hw_errors = 0;
+  out->high_water = rx_ring.high_water;
+  out->dma = 1;
+  out->max_gap_us = rx_gap_max_us;
+  out->gaps = rx_gaps;
+}
+
+void uart_rx_reset_gaps(uint32_t threshold_us) {
+  rx_gap_max_us = 0;
+  rx_gaps = 0;
+  rx_gap_threshold_us = threshold_us;
+}
@@ -0,0 +1,40 @@
+#ifndef _HOST_HW_CONFIG_H_
+#define _HOST_HW_CONFIG_H_
+
+#include <stdbool.h>
+
+#include "DEV_Config.h"
+#include "ff.h"
+#include "pico/stdlib.h"
+
+// The card of lib/Config/hw_config.c, with the fields frame_store.c uses
+// named as in sd_driver/spi.h and sd_card.h and the pins from DEV_Config.h.
+typedef struct {
+  uint miso_gpio;
+  uint mosi_gpio;
+  uint sck_gpio;
+} spi_t;
+
+typedef struct {
+  const char* pcName;
+  spi_t* spi;
+  uint ss_gpio;
+  FATFS fatfs;
+  bool mounted;
+} sd_card_t;
+
+static inline sd_card_t* sd_get_by_num(size_t num) {
+  static spi_t spi = {
+      .miso_gpio = SD_MISO_PIN,
+      .mosi_gpio = SD_MOSI_PIN,
+      .sck_gpio = SD_CLK_PIN,
+  };
+  static sd_card_t sd = {
+      .pcName = "0:",
+      .spi = &spi,
+      .ss_gpio = SD_CS_PIN,
+  };
+  return num == 0 ? &sd : NULL;
+}
+
+#endif
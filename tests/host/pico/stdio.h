@@ -0,0 +1,6 @@
+#ifndef _HOST_PICO_STDIO_H_
+#define _HOST_PICO_STDIO_H_
+
+#include "pico/stdlib.h"
+
+#endif
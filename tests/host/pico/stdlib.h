@@ -0,0 +1,27 @@
+#ifndef _HOST_PICO_STDLIB_H_
+#define _HOST_PICO_STDLIB_H_
+
+// Host stand-in for the Pico SDK calls the firmware makes (see
+// tests/host/host_pico.c). Only what main.c and the e-Paper driver use.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pico/time.h"
+
+typedef unsigned int uint;
+
+#define GPIO_FUNC_SPI 1
+#define GPIO_FUNC_UART 2
+#define GPIO_FUNC_SIO 5
+
+bool stdio_init_all(void);
+void gpio_set_function(uint gpio, int fn);
+bool gpio_get(uint gpio);
+void gpio_put(uint gpio, bool value);
+
+#include "hardware/uart.h"
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _HOST_PICO_TIME_H_
+#define _HOST_PICO_TIME_H_
+
+// Pico SDK time API on CLOCK_MONOTONIC microseconds.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef uint64_t absolute_time_t;
+
+static inline absolute_time_t get_absolute_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static inline uint64_t time_us_64(void) {
+  return get_absolute_time();
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from,
+                                            absolute_time_t to) {
+  return (int64_t)(to - from);
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+  return get_absolute_time() + (uint64_t)ms * 1000u;
+}
+
+static inline bool time_reached(absolute_time_t t) {
+  return get_absolute_time() >= t;
+}
+
+static inline void sleep_us(uint64_t us) {
+  struct timespec ts = {(time_t)(us / 1000000u), (long)(us % 1000000u) * 1000};
+  nanosleep(&ts, NULL);
+}
+
+static inline void sleep_until(absolute_time_t t) {
+  absolute_time_t now = get_absolute_time();
+  if (t > now)
+    sleep_us(t - now);
+}
+
+static inline void sleep_ms(uint32_t ms) {
+  sleep_us((uint64_t)ms * 1000u);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "sample_frames.h"
+
+#include <string.h>
+
+enum { BLACK, WHITE, GREEN, BLUE, RED, YELLOW, ORANGE };
+
+static void set_px(uint8_t* f, int x, int y, int c) {
+  if (x < 0 || y < 0 || x >= SAMPLE_WIDTH || y >= SAMPLE_HEIGHT)
+    return;
+  uint8_t* p = &f[y * SAMPLE_ROW_BYTES + x / 2];
+  if (x & 1)
+    *p = (uint8_t)((*p & 0xF0) | c);
+  else
+    *p = (uint8_t)((*p & 0x0F) | (c << 4));
+}
+
+static void fill_rect(uint8_t* f, int x0, int y0, int x1, int y1, int c) {
+  for (int y = y0; y < y1; y++)
+    for (int x = x0; x < x1; x++)
+      set_px(f, x, y, c);
+}
+
+static void frame_rect(uint8_t* f, int x0, int y0, int x1, int y1, int c) {
+  fill_rect(f, x0, y0, x1, y0 + 2, c);
+  fill_rect(f, x0, y1 - 2, x1, y1, c);
+  fill_rect(f, x0, y0, x0 + 2, y1, c);
+  fill_rect(f, x1 - 2, y0, x1, y1, c);
+}
+
+static uint32_t mix(uint32_t v) {
+  v ^= v >> 16;
+  v *= 0x7feb352du;
+  v ^= v >> 15;
+  v *= 0x846ca68bu;
+  v ^= v >> 16;
+  return v;
+}
+
+// A line of n pseudo-glyphs (8x12 cells, ~35% ink) starting at x, y.
+static void text(uint8_t* f, int x, int y, int n, uint32_t seed, int c) {
+  for (int g = 0; g < n; g++) {
+    uint32_t gs = mix(seed * 131u + (uint32_t)g);
+    if ((gs & 7) == 0)
+      continue;  // space
+    for (int gy = 1; gy < 11; gy++)
+      for (int gx = 1; gx < 7; gx++)
+        if (mix(gs + (uint32_t)(gy * 8 + gx)) % 100 < 35)
+          set_px(f, x + g * 8 + gx, y + gy, c);
+  }
+}
+
+// Seven-segment digit, 48x96, stroke 10.
+static void digit(uint8_t* f, int x, int y, int d, int c) {
+  static const uint8_t seg[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66,
+                                  0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+  static const int8_t box[7][4] = {
+      {0, 0, 48, 10},  {38, 0, 48, 48},  {38, 48, 48, 96}, {0, 86, 48, 96},
+      {0, 48, 10, 96}, {0, 0, 10, 48},   {0, 43, 48, 53},
+  };
+  for (int i = 0; i < 7; i++)
+    if (seg[d % 10] & (1 << i))
+      fill_rect(f, x + box[i][0], y + box[i][1], x + box[i][2],
+                y + box[i][3], c);
+}
+
+void sample_frame_dashboard(uint8_t* f, int minute) {
+  memset(f, (WHITE << 4) | WHITE, SAMPLE_FRAME_SIZE);
+
+  // Header bar with title and date.
+  fill_rect(f, 0, 0, SAMPLE_WIDTH, 56, BLUE);
+  text(f, 24, 22, 18, 1, WHITE);
+  text(f, 560, 22, 26, 2 + (uint32_t)(minute / 1440), WHITE);
+
+  // Clock HH:MM.
+  int hh = (7 + minute / 60) % 24, mm = minute % 60;
+  frame_rect(f, 20, 72, 380, 212, BLACK);
+  digit(f, 50, 94, hh / 10, BLACK);
+  digit(f, 110, 94, hh % 10, BLACK);
+  fill_rect(f, 176, 120, 186, 130, BLACK);
+  fill_rect(f, 176, 160, 186, 170, BLACK);
+  digit(f, 200, 94, mm / 10, BLACK);
+  digit(f, 260, 94, mm % 10, BLACK);
+
+  // Weather: sun icon, temperature changes every 10 minutes.
+  frame_rect(f, 400, 72, 780, 212, BLACK);
+  for (int y = -36; y <= 36; y++)
+    for (int x = -36; x <= 36; x++)
+      if (x * x + y * y <= 36 * 36)
+        set_px(f, 470 + x, 142 + y, YELLOW);
+  text(f, 530, 110, 10, 100 + (uint32_t)(minute / 10), RED);
+  text(f, 530, 150, 24, 200 + (uint32_t)(minute / 60), BLACK);
+
+  // Calendar: 7 x 3 day boxes with a few events.
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 7; c++) {
+      int x0 = 20 + c * 110, y0 = 232 + r * 80;
+      frame_rect(f, x0, y0, x0 + 104, y0 + 74, BLACK);
+      text(f, x0 + 6, y0 + 4, 2, 300 + (uint32_t)(r * 7 + c), BLACK);
+      uint32_t ev = mix((uint32_t)(r * 7 + c));
+      if (ev % 3 == 0) {
+        fill_rect(f, x0 + 4, y0 + 24, x0 + 100, y0 + 42,
+                  (ev & 8) ? GREEN : ORANGE);
+        text(f, x0 + 8, y0 + 27, 10, ev, WHITE);
+      }
+    }
+  }
+}
+
+void sample_frame_noise(uint8_t* f, uint32_t seed) {
+  for (size_t i = 0; i < SAMPLE_FRAME_SIZE; i++) {
+    uint32_t v = mix(seed + (uint32_t)i);
+    f[i] = (uint8_t)(((v % 7) << 4) | ((v >> 8) % 7));
+  }
+}
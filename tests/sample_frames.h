@@ -0,0 +1,22 @@
+#ifndef _SAMPLE_FRAMES_H_
+#define _SAMPLE_FRAMES_H_
+
+// Synthetic 800x480 4bpp panel frames for the host benchmarks: a kitchen
+// dashboard (flat background, header bar, calendar boxes, text-like glyph
+// runs, weather icon, clock) whose clock / temperature change with `minute`,
+// so consecutive minutes behave like consecutive refresh cycles.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SAMPLE_WIDTH 800
+#define SAMPLE_HEIGHT 480
+#define SAMPLE_ROW_BYTES (SAMPLE_WIDTH / 2)
+#define SAMPLE_FRAME_SIZE (SAMPLE_ROW_BYTES * SAMPLE_HEIGHT)
+
+void sample_frame_dashboard(uint8_t* frame, int minute);
+
+// Uniform random colors 0..6 everywhere: incompressible worst case.
+void sample_frame_noise(uint8_t* frame, uint32_t seed);
+
+#endif
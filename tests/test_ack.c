@@ -1,7 +1,8 @@
 #include <stdio.h>
 #include <string.h>
 
-// Simple local implementation matching contains_ack behavior for unit testing
+// Simple local implementation matching the ACK line test in
+// lib/Link/frame_parser.c for unit testing
 int contains_ack_test(const char* s) {
   if (!s)
     return 0;
@@ -0,0 +1,168 @@
+// Host test for SENDIMG baud negotiation and fallback (lib/Link/link_proto.c)
+// against the stand-in peer in tests/fake_peer.c.
+//
+//   gcc tests/test_baud_negotiation.c tests/fake_peer.c lib/Link/link_proto.c
+//       lib/Link/pack3.c lib/Link/tiles.c lib/Link/crc32.c tools/lz_encode.c
+//       -o test_baud_negotiation
+//   ./test_baud_negotiation
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../lib/Link/link_proto.h"
+#include "fake_peer.h"
+
+#define FRAME_LEN 19200
+#define MAX_ATTEMPTS 3
+
+static uint8_t frame[FRAME_LEN];
+static uint8_t wire[FRAME_LEN + 256];
+static int failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("FAILED: ");       \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      failures++;               \
+    }                           \
+  } while (0)
+
+// One SENDIMG cycle from the Pico's point of view. Returns 1 if the frame
+// arrived intact. *rate_out gets the rate the Pico switched to.
+static int attempt(link_baud_t* lb,
+                   fake_peer_t* peer,
+                   char* req,
+                   size_t req_len,
+                   uint32_t* rate_out) {
+  link_format_request(lb, LINK_FMT_RAW, NULL, 0, req, req_len);
+  size_t n =
+      fake_peer_respond(peer, req, frame, FRAME_LEN, wire, sizeof(wire));
+  CHECK(n > 0, "peer ignored request '%s'", req);
+
+  // First line must carry the ACK.
+  char line[64];
+  size_t i = 0;
+  while (i < n && i < sizeof(line) - 1 && wire[i] != '\n') {
+    line[i] = (char)wire[i];
+    i++;
+  }
+  line[i] = '\0';
+  CHECK(strstr(line, "ACK") != NULL, "no ACK in '%s'", line);
+  *rate_out = link_parse_ack(lb, line);
+  CHECK(*rate_out == peer->frame_baud, "pico at %u, peer at %u",
+        (unsigned)*rate_out, (unsigned)peer->frame_baud);
+  CHECK(lb->flow == peer->frame_flow, "flow mismatch pico=%d peer=%d",
+        lb->flow, peer->frame_flow);
+
+  // Scan for SOF (second ACK line is noise), then size + payload.
+  int ok = 0;
+  for (size_t p = i; p + 8 <= n; p++) {
+    if (wire[p] == 0xAA && wire[p + 1] == 0x55 && wire[p + 2] == 0xAA &&
+        wire[p + 3] == 0x55) {
+      size_t size = ((size_t)wire[p + 4] << 24) |
+                    ((size_t)wire[p + 5] << 16) |
+                    ((size_t)wire[p + 6] << 8) | wire[p + 7];
+      ok = (size == FRAME_LEN && p + 8 + size <= n &&
+            memcmp(wire + p + 8, frame, size) == 0);
+      break;
+    }
+  }
+  link_baud_frame_done(lb, ok);
+  CHECK(lb->current == LINK_BASE_BAUD, "did not return to base rate");
+  return ok;
+}
+
+// Run up to MAX_ATTEMPTS like main() does; record the rate of each attempt.
+static int run_cycle(link_baud_t* lb,
+                     fake_peer_t* peer,
+                     uint32_t* rates,
+                     char reqs[][64]) {
+  for (int a = 0; a < MAX_ATTEMPTS; a++) {
+    if (attempt(lb, peer, reqs[a], 64, &rates[a]))
+      return a + 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  for (size_t i = 0; i < FRAME_LEN; i++)
+    frame[i] = (uint8_t)(i * 7);
+
+  static const uint32_t pico_rates[] = {2000000, 921600};
+  static const uint32_t esp_all[] = {2000000, 921600};
+  static const uint32_t esp_slow[] = {921600};
+  link_baud_t lb;
+  fake_peer_t peer;
+  uint32_t rates[MAX_ATTEMPTS];
+  char reqs[MAX_ATTEMPTS][64];
+
+  // 1. Both sides support 2 Mbaud with flow control: first attempt wins.
+  link_baud_init(&lb, pico_rates, 2, 1);
+  fake_peer_init(&peer, esp_all, 2, 1, 4000000);
+  CHECK(run_cycle(&lb, &peer, rates, reqs) == 1, "case 1 attempts");
+  CHECK(!strcmp(reqs[0], "SENDIMG BAUD=2000000,921600 FLOW=RTS\n"),
+        "case 1 request '%s'", reqs[0]);
+  CHECK(rates[0] == 2000000, "case 1 rate %u", (unsigned)rates[0]);
+
+  // 2. Peer only supports 921600 and has no CTS.
+  link_baud_init(&lb, pico_rates, 2, 1);
+  fake_peer_init(&peer, esp_slow, 1, 0, 4000000);
+  CHECK(run_cycle(&lb, &peer, rates, reqs) == 1, "case 2 attempts");
+  CHECK(rates[0] == 921600 && lb.flow == 0, "case 2 rate %u",
+        (unsigned)rates[0]);
+
+  // 3. Legacy peer answers a bare ACK: stay at the base rate.
+  link_baud_init(&lb, pico_rates, 2, 1);
+  fake_peer_init(&peer, esp_all, 2, 1, 4000000);
+  peer.legacy = 1;
+  CHECK(run_cycle(&lb, &peer, rates, reqs) == 1, "case 3 attempts");
+  CHECK(rates[0] == LINK_BASE_BAUD, "case 3 rate %u", (unsigned)rates[0]);
+
+  // 4. Link only reliable up to 921600: 2 Mbaud frame fails, next succeeds.
+  link_baud_init(&lb, pico_rates, 2, 1);
+  fake_peer_init(&peer, esp_all, 2, 1, 921600);
+  CHECK(run_cycle(&lb, &peer, rates, reqs) == 2, "case 4 attempts");
+  CHECK(rates[0] == 2000000 && rates[1] == 921600, "case 4 rates %u,%u",
+        (unsigned)rates[0], (unsigned)rates[1]);
+  CHECK(!strcmp(reqs[1], "SENDIMG BAUD=921600 FLOW=RTS\n"),
+        "case 4 request '%s'", reqs[1]);
+
+  // 5. Link only reliable at the base rate: fall all the way back.
+  link_baud_init(&lb, pico_rates, 2, 1);
+  fake_peer_init(&peer, esp_all, 2, 1, LINK_BASE_BAUD);
+  CHECK(run_cycle(&lb, &peer, rates, reqs) == 3, "case 5 attempts");
+  CHECK(rates[2] == LINK_BASE_BAUD, "case 5 rate %u", (unsigned)rates[2]);
+  CHECK(!strcmp(reqs[2], "SENDIMG\n"), "case 5 request '%s'", reqs[2]);
+
+  // 6. Negotiation disabled: request is the original bare SENDIMG.
+  link_baud_init(&lb, pico_rates, 0, 1);
+  link_format_request(&lb, LINK_FMT_RAW, NULL, 0, reqs[0], sizeof(reqs[0]));
+  CHECK(!strcmp(reqs[0], "SENDIMG\n"), "case 6 request '%s'", reqs[0]);
+
+  // 7. ACK naming a rate we never offered is ignored.
+  link_baud_init(&lb, pico_rates, 2, 0);
+  CHECK(link_parse_ack(&lb, "ACK BAUD=3000000 FLOW=RTS") == LINK_BASE_BAUD,
+        "case 7 accepted unoffered rate");
+  CHECK(lb.flow == 0, "case 7 flow without request");
+
+  // 8. A buffer too small for the request gets no cut-off line.
+  link_baud_init(&lb, pico_rates, 2, 1);
+  char small[16];
+  CHECK(link_format_request(&lb, LINK_FMT_RAW, NULL, 0, small,
+                            sizeof(small)) == -1,
+        "case 8 overflow not reported");
+  CHECK(small[0] == '\0', "case 8 left '%s'", small);
+  CHECK(link_format_request(&lb, LINK_FMT_RAW, NULL, 0, reqs[0],
+                            sizeof(reqs[0])) == (int)strlen(reqs[0]),
+        "case 8 length");
+  CHECK(link_format_request(&lb, LINK_FMT_RAW, NULL, 0, small, 0) == -1,
+        "case 8 zero length");
+
+  if (failures == 0) {
+    printf("All baud negotiation tests passed\n");
+    return 0;
+  }
+  return 1;
+}
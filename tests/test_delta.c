@@ -0,0 +1,264 @@
+// Host simulation of tile-hash delta transfers (LINK_FMT_DELTA: lib/Link/
+// tiles.c, lib/Link/payload.c) against the stand-in peer in tests/fake_peer.c.
+//
+// Each cycle mirrors request_and_receive_image() with a delta base: the Pico
+// hashes the frame it holds, sends TILES= plus the hash block, and patches
+// whatever tiles come back into its buffer. The patched buffer must match
+// the peer's frame and the ACK's ID. Wire bytes are compared with the best
+// full frame the same peer would send without FMT=DELTA.
+//
+// The default sequences are dashboard frames refreshed every minute for an
+// hour and every 15 minutes for a day; raw 192000-byte frames passed on the
+// command line are replayed in order instead.
+//
+//   gcc -O2 tests/test_delta.c tests/fake_peer.c tests/sample_frames.c
+//       lib/Link/link_proto.c lib/Link/payload.c lib/Link/pack3.c
+//       lib/Link/tiles.c lib/Link/lz_decode.c lib/Link/crc32.c
+//       tools/lz_encode.c -o test_delta
+//   ./test_delta [frame.bin ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/Link/crc32.h"
+#include "../lib/Link/link_proto.h"
+#include "../lib/Link/payload.h"
+#include "../lib/Link/tiles.h"
+#include "fake_peer.h"
+#include "sample_frames.h"
+
+#define RX_CHUNK_SIZE 4096
+#define FORMATS (LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC)
+#define WIRE_CAP (LINK_CHUNKED_LEN(LZ_BOUND(SAMPLE_FRAME_SIZE)) + 256)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("FAILED: ");       \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      failures++;               \
+    }                           \
+  } while (0)
+
+static uint8_t wire[WIRE_CAP];
+static uint8_t buffer[SAMPLE_FRAME_SIZE] __attribute__((aligned(4)));
+static payload_decoder_t dec;
+static tile_grid_t grid;
+
+// One SENDIMG cycle into buffer, offering a delta when with_base is set. At
+// most keep wire bytes after the header reach the decoder (a cut-off
+// frame). Returns 0 when buffer holds the frame the ACK's ID names; *sent
+// gets the bytes after the ACK lines.
+static int cycle(fake_peer_t* peer,
+                 const uint8_t* frame,
+                 int with_base,
+                 size_t keep,
+                 size_t* sent) {
+  static uint32_t hashes[TILE_MAX];
+  link_baud_t lb;
+  link_baud_init(&lb, NULL, 0, 0);
+  uint8_t req[160 + TILE_HASH_BLOCK(TILE_MAX)];
+  const int tiles = with_base ? grid.count : 0;
+  const uint8_t formats = FORMATS | (tiles ? LINK_FMT_DELTA : 0);
+  int n = link_format_request(&lb, formats, NULL, tiles, (char*)req, 160);
+  if (tiles) {
+    tile_hashes(&grid, buffer, hashes);
+    tile_hashes_pack(hashes, tiles, req + n);
+  }
+  size_t len = fake_peer_respond(peer, (const char*)req, frame,
+                                 SAMPLE_FRAME_SIZE, wire, sizeof(wire));
+  CHECK(len > 0, "peer ignored '%.*s'", n - 1, (const char*)req);
+
+  char ack[96];
+  size_t i = 0;
+  while (i < len && wire[i] != '\n' && i < sizeof(ack) - 1) {
+    ack[i] = (char)wire[i];
+    i++;
+  }
+  ack[i] = '\0';
+  size_t p = 2 * (i + 1);
+  *sent = len - p;
+  link_resume_t ack_resume;
+  int ack_has_id = link_parse_resume(ack, &ack_resume);
+
+  // SOF + header.
+  p += 4;
+  uint32_t h = ((uint32_t)wire[p] << 24) | ((uint32_t)wire[p + 1] << 16) |
+               ((uint32_t)wire[p + 2] << 8) | wire[p + 3];
+  uint8_t fmt = LINK_HDR_FMT(h);
+  size_t hdr_len = LINK_HDR_LEN(h);
+  p += 4;
+  if ((fmt & ~formats) || hdr_len > payload_max_wire(fmt, SAMPLE_FRAME_SIZE))
+    return -1;
+
+  payload_init(&dec, fmt, hdr_len, buffer, SAMPLE_FRAME_SIZE);
+  if (fmt & LINK_FMT_DELTA)
+    payload_set_tiles(&dec, &grid);
+  size_t wire_len = (fmt & LINK_FMT_CRC) ? LINK_CHUNKED_LEN(hdr_len) : hdr_len;
+  if (wire_len > keep)
+    wire_len = keep;
+  int rc = 0;
+  for (size_t off = 0; off < wire_len && rc == 0; off += RX_CHUNK_SIZE) {
+    size_t k = wire_len - off;
+    if (k > RX_CHUNK_SIZE)
+      k = RX_CHUNK_SIZE;
+    rc = payload_feed(&dec, wire + p + off, k);
+  }
+  if (rc != 0 || !payload_complete(&dec))
+    return -3;
+  if (!ack_has_id || crc32_update(0, buffer, SAMPLE_FRAME_SIZE) !=
+                         ack_resume.id)
+    return -2;
+  return 0;
+}
+
+static fake_peer_t make_peer(uint8_t formats) {
+  fake_peer_t peer;
+  fake_peer_init(&peer, NULL, 0, 0, 4000000);
+  peer.formats = formats;
+  return peer;
+}
+
+// Replay frames[0..n): full frames vs deltas against the previous one.
+static void sequence(const char* name, uint8_t* const* frames, int n) {
+  fake_peer_t full = make_peer(FORMATS);
+  fake_peer_t delta = make_peer(FORMATS | LINK_FMT_DELTA);
+  size_t full_bytes = 0, delta_bytes = 0, sent;
+  int deltas = 0, tiles = 0;
+
+  memset(buffer, 0xFF, sizeof(buffer));
+  for (int i = 0; i < n; i++) {
+    CHECK(cycle(&full, frames[i], 0, SIZE_MAX, &sent) == 0,
+          "%s: full frame %d", name, i);
+    full_bytes += sent;
+  }
+  memset(buffer, 0xFF, sizeof(buffer));
+  for (int i = 0; i < n; i++) {
+    CHECK(cycle(&delta, frames[i], i > 0, SIZE_MAX, &sent) == 0,
+          "%s: delta frame %d", name, i);
+    CHECK(memcmp(buffer, frames[i], SAMPLE_FRAME_SIZE) == 0,
+          "%s: frame %d differs after patching", name, i);
+    delta_bytes += sent;
+    if (delta.frame_fmt & LINK_FMT_DELTA) {
+      deltas++;
+      tiles += delta.frame_tiles;
+    }
+  }
+  CHECK(delta_bytes <= full_bytes, "%s: delta sent more bytes", name);
+  printf("%-16s %3d frames  full %8zu B (%6zu/frame)  delta %8zu B "
+         "(%6zu/frame)  saved %5.1f%%  %d deltas, %.1f tiles/delta\n",
+         name, n, full_bytes, full_bytes / (size_t)n, delta_bytes,
+         delta_bytes / (size_t)n,
+         100.0 * (double)(full_bytes - delta_bytes) / (double)full_bytes,
+         deltas, deltas ? (double)tiles / deltas : 0.0);
+}
+
+static void test_fallbacks(void) {
+  static uint8_t a[SAMPLE_FRAME_SIZE], b[SAMPLE_FRAME_SIZE];
+  sample_frame_dashboard(a, 0);
+  sample_frame_dashboard(b, 1);
+  size_t sent;
+
+  // A peer without FMT=DELTA ignores the hash block.
+  fake_peer_t old = make_peer(FORMATS);
+  memcpy(buffer, a, sizeof(buffer));
+  CHECK(cycle(&old, b, 1, SIZE_MAX, &sent) == 0 &&
+            !(old.frame_fmt & LINK_FMT_DELTA),
+        "delta from a peer that does not offer it");
+
+  // Nothing changed: the peer still sends a full frame, never an empty
+  // delta, so the Pico always gets an ID to check.
+  fake_peer_t peer = make_peer(FORMATS | LINK_FMT_DELTA);
+  memcpy(buffer, b, sizeof(buffer));
+  CHECK(cycle(&peer, b, 1, SIZE_MAX, &sent) == 0 &&
+            !(peer.frame_fmt & LINK_FMT_DELTA),
+        "empty delta");
+
+  // A noise frame: every tile differs and a full frame is smaller.
+  static uint8_t noise[SAMPLE_FRAME_SIZE];
+  sample_frame_noise(noise, 5);
+  memcpy(buffer, a, sizeof(buffer));
+  CHECK(cycle(&peer, noise, 1, SIZE_MAX, &sent) == 0 &&
+            !(peer.frame_fmt & LINK_FMT_DELTA),
+        "delta chosen for a full-screen change");
+
+  // A base that does not match its hashes (damaged block): full frame.
+  memcpy(buffer, a, sizeof(buffer));
+  uint8_t req[160 + TILE_HASH_BLOCK(TILE_MAX)];
+  static uint32_t hashes[TILE_MAX];
+  link_baud_t lb;
+  link_baud_init(&lb, NULL, 0, 0);
+  int n = link_format_request(&lb, FORMATS | LINK_FMT_DELTA, NULL,
+                              grid.count, (char*)req, 160);
+  tile_hashes(&grid, buffer, hashes);
+  tile_hashes_pack(hashes, grid.count, req + n);
+  req[n + 17] ^= 0x04;
+  CHECK(fake_peer_respond(&peer, (const char*)req, b, sizeof(b), wire,
+                          sizeof(wire)) > 0 &&
+            !(peer.frame_fmt & LINK_FMT_DELTA),
+        "delta against a damaged hash block");
+
+  // Cut off half way: the retry hashes the half-patched buffer and gets
+  // only the tiles still missing. Noise in the top half makes the delta
+  // span many chunks.
+  static uint8_t c[SAMPLE_FRAME_SIZE];
+  memcpy(c, noise, SAMPLE_FRAME_SIZE / 2);
+  memcpy(c + SAMPLE_FRAME_SIZE / 2, a + SAMPLE_FRAME_SIZE / 2,
+         SAMPLE_FRAME_SIZE / 2);
+  memcpy(buffer, a, sizeof(buffer));
+  CHECK(cycle(&peer, c, 1, SIZE_MAX, &sent) == 0, "delta a->c");
+  int all = peer.frame_tiles;
+  size_t whole = sent;
+  memcpy(buffer, a, sizeof(buffer));
+  CHECK(cycle(&peer, c, 1, whole / 2, &sent) == -3, "cut-off delta accepted");
+  CHECK(cycle(&peer, c, 1, SIZE_MAX, &sent) == 0 &&
+            memcmp(buffer, c, sizeof(buffer)) == 0,
+        "retry after a cut-off delta");
+  CHECK(peer.frame_tiles > 0 && peer.frame_tiles < all,
+        "retry sent %d of %d tiles", peer.frame_tiles, all);
+  printf("cut-off retry    %d of %d tiles resent\n", peer.frame_tiles, all);
+}
+
+int main(int argc, char** argv) {
+  CHECK(tile_grid_init(&grid, SAMPLE_WIDTH, SAMPLE_HEIGHT) == 0 &&
+            grid.count == 375,
+        "800x480 grid");
+  test_fallbacks();
+
+  if (argc > 1) {
+    uint8_t** frames = calloc((size_t)argc - 1, sizeof(*frames));
+    for (int i = 1; i < argc; i++) {
+      FILE* f = fopen(argv[i], "rb");
+      frames[i - 1] = calloc(1, SAMPLE_FRAME_SIZE);
+      if (!f) {
+        perror(argv[i]);
+        return 1;
+      }
+      size_t got = fread(frames[i - 1], 1, SAMPLE_FRAME_SIZE, f);
+      fclose(f);
+      CHECK(got == SAMPLE_FRAME_SIZE, "%s: short frame", argv[i]);
+    }
+    sequence("files", frames, argc - 1);
+  } else {
+    // One refresh a minute for an hour, then one every 15 minutes for a day.
+    static uint8_t* frames[96];
+    for (int i = 0; i < 96; i++)
+      frames[i] = malloc(SAMPLE_FRAME_SIZE);
+    for (int i = 0; i < 60; i++)
+      sample_frame_dashboard(frames[i], i);
+    sequence("every minute", frames, 60);
+    for (int i = 0; i < 96; i++)
+      sample_frame_dashboard(frames[i], i * 15);
+    sequence("every 15 min", frames, 96);
+  }
+
+  if (failures == 0) {
+    printf("All delta tests passed\n");
+    return 0;
+  }
+  return 1;
+}
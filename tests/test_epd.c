@@ -0,0 +1,243 @@
+// Host harness for the panel driver (lib/e-Paper/EPD_7in3f.c) against the
+// virtual panel in tests/host/host_dev.c.
+//
+// Every way of writing a frame (Clear, Show7Block, Display, DisplayStream)
+// must leave exactly the expected 4bpp frame on the panel after one
+// refresh; an aborted DisplayStream must not refresh. The bus trace must
+// show the frame write and a refresh that dropped BUSY. The background
+// prepare must reset, init and power the panel up in order. Bug #15 failure
+// modes A and B must come back as a REFRESH timeout with the BUSY
+// signatures listed in the README. Panel times run at 1/1000; the failure
+// cases still wait the driver's 2 s for BUSY to drop. Set $PICO_PANEL_PPM
+// to look at the last frame shown.
+//
+//   gcc -O2 -Itests/host -Ilib/Config -Ilib/e-Paper tests/test_epd.c
+//       lib/e-Paper/EPD_7in3f.c tests/host/host_dev.c -o test_epd
+//   ./test_epd
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "EPD_7in3f.h"
+#include "host_panel.h"
+
+#define FRAME_BYTES (EPD_7IN3F_ROW_BYTES * EPD_7IN3F_HEIGHT)
+
+// The driver reports its progress on stdout, so results go to `out`.
+#define CHECK(cond, ...)            \
+  do {                              \
+    if (!(cond)) {                  \
+      fprintf(out, "FAILED: ");     \
+      fprintf(out, __VA_ARGS__);    \
+      fprintf(out, "\n");           \
+      failures++;                   \
+    }                               \
+  } while (0)
+
+static FILE* out;
+static int failures = 0;
+static UBYTE image[FRAME_BYTES];
+
+// Both pixels of each byte cycle through the seven colours, out of step.
+static UBYTE pattern_byte(UDOUBLE i) {
+  return (UBYTE)((((i * 5 + i / 800) % 7) << 4) | ((i / 3) % 7));
+}
+
+static int pattern_rows(UBYTE* Rows, UWORD Y, UWORD Count, void* Ctx) {
+  (void)Ctx;
+  UDOUBLE off = (UDOUBLE)Y * EPD_7IN3F_ROW_BYTES;
+  for (UDOUBLE i = 0; i < (UDOUBLE)Count * EPD_7IN3F_ROW_BYTES; i++)
+    Rows[i] = pattern_byte(off + i);
+  return 0;
+}
+
+// Gives up once past half the frame, noting at which row in *Ctx.
+static int abort_rows(UBYTE* Rows, UWORD Y, UWORD Count, void* Ctx) {
+  memset(Rows, 0x00, (size_t)Count * EPD_7IN3F_ROW_BYTES);
+  *(UWORD*)Ctx = Y;
+  return Y >= EPD_7IN3F_HEIGHT / 2;
+}
+
+static int all_bytes(const UBYTE* p, UDOUBLE n, UBYTE v) {
+  for (UDOUBLE i = 0; i < n; i++)
+    if (p[i] != v)
+      return 0;
+  return 1;
+}
+
+static void test_clear(void) {
+  int before = host_panel_refreshes();
+  EPD_7IN3F_Clear(EPD_7IN3F_GREEN);
+  CHECK(host_panel_refreshes() == before + 1, "clear: %d refreshes",
+        host_panel_refreshes() - before);
+  CHECK(host_panel_written() == FRAME_BYTES, "clear: wrote %lu bytes",
+        (unsigned long)host_panel_written());
+  CHECK(all_bytes(host_panel_frame(), FRAME_BYTES, 0x22),
+        "clear: frame is not all green");
+}
+
+static void test_show7block(void) {
+  EPD_7IN3F_Show7Block();
+  const UBYTE* f = host_panel_frame();
+  const UBYTE* bottom = f + (UDOUBLE)240 * EPD_7IN3F_ROW_BYTES;
+  static const UBYTE top_colors[4] = {0x00, 0x33, 0x22, 0x66};
+  static const UBYTE bottom_colors[4] = {0x44, 0x55, 0x11, 0x11};
+  for (int k = 0; k < 4; k++) {
+    CHECK(f[k * 100] == top_colors[k] && f[k * 100 + 99] == top_colors[k],
+          "show7block: top block %d", k);
+    CHECK(bottom[k * 100] == bottom_colors[k] &&
+              bottom[239 * EPD_7IN3F_ROW_BYTES + k * 100 + 99] ==
+                  bottom_colors[k],
+          "show7block: bottom block %d", k);
+  }
+  CHECK(f[239 * EPD_7IN3F_ROW_BYTES] == 0x00, "show7block: row 239");
+}
+
+static void test_display(void) {
+  for (UDOUBLE i = 0; i < FRAME_BYTES; i++)
+    image[i] = pattern_byte(i);
+  int before = host_panel_refreshes();
+  int rc = EPD_7IN3F_Display(image);
+  CHECK(rc == 0, "display: rc=%d", rc);
+  CHECK(host_panel_refreshes() == before + 1, "display: %d refreshes",
+        host_panel_refreshes() - before);
+  CHECK(memcmp(host_panel_frame(), image, FRAME_BYTES) == 0,
+        "display: panel differs from the image");
+  CHECK(epd_write_bytes == FRAME_BYTES, "display: epd_write_bytes=%lu",
+        (unsigned long)epd_write_bytes);
+  CHECK(epd_refresh_edges == 2, "display: %ld BUSY edges",
+        (long)epd_refresh_edges);
+}
+
+static void test_display_stream(void) {
+  EPD_7IN3F_Clear(EPD_7IN3F_WHITE);
+  int before = host_panel_refreshes();
+  int rc = EPD_7IN3F_DisplayStream(pattern_rows, NULL);
+  CHECK(rc == 0, "stream: rc=%d", rc);
+  CHECK(host_panel_refreshes() == before + 1, "stream: %d refreshes",
+        host_panel_refreshes() - before);
+  CHECK(memcmp(host_panel_frame(), image, FRAME_BYTES) == 0,
+        "stream: panel differs from the image");
+
+  // Half a frame, then the provider gives up: nothing new is shown.
+  UWORD stop = 0;
+  rc = EPD_7IN3F_DisplayStream(abort_rows, &stop);
+  CHECK(rc == -4, "stream abort: rc=%d", rc);
+  CHECK(host_panel_refreshes() == before + 1, "stream abort: refreshed");
+  CHECK(host_panel_written() == (UDOUBLE)stop * EPD_7IN3F_ROW_BYTES,
+        "stream abort: wrote %lu bytes", (unsigned long)host_panel_written());
+  CHECK(memcmp(host_panel_frame(), image, FRAME_BYTES) == 0,
+        "stream abort: shown frame changed");
+}
+
+// The bus trace of Display(): one DTM with the whole frame, then the
+// refresh with BUSY dropping, without a wait timing out.
+static void test_trace(void) {
+  static EPD_7IN3F_TraceEntry tr[EPD_7IN3F_TRACE_LEN];
+  EPD_7IN3F_Display(image);
+  UDOUBLE lost;
+  UWORD n = EPD_7IN3F_TraceRead(tr, EPD_7IN3F_TRACE_LEN, &lost);
+  int dtm = -1, drf = -1;
+  for (UWORD i = 0; i < n; i++) {
+    if (tr[i].kind == EPD_7IN3F_TR_CMD && tr[i].code == 0x10)
+      dtm = i;
+    if (tr[i].kind == EPD_7IN3F_TR_CMD && tr[i].code == 0x12)
+      drf = i;
+  }
+  CHECK(dtm >= 0 && tr[dtm].len == FRAME_BYTES && tr[dtm].d0 == image[0],
+        "trace: no DTM with the frame");
+  CHECK(drf > dtm && tr[drf].len == 1 && tr[drf].busy == 0x2,
+        "trace: DRF missing or BUSY did not drop");
+  for (UWORD i = drf + 1; i < n && tr[i].kind == EPD_7IN3F_TR_WAIT; i++)
+    CHECK((tr[i].busy & 1) == tr[i].code, "trace: wait %u timed out", i);
+}
+
+// PrepareBegin() + PreparePoll() in steps: the reset, the register table
+// and POWER_ON in that order, BUSY waited for after each, and the panel
+// takes a frame after it.
+static void test_prepare(void) {
+  static EPD_7IN3F_TraceEntry tr[EPD_7IN3F_TRACE_LEN];
+  EPD_7IN3F_PrepareBegin(1);
+  uint64_t wake = 0;
+  int rc, polls = 0;
+  while ((rc = EPD_7IN3F_PreparePoll(&wake)) == 1 && polls++ < 100000) {
+    uint64_t now = time_us_64();
+    CHECK(wake > now - 1000 && wake < now + 1000000,
+          "prepare: next step in %lld us", (long long)(wake - now));
+    if (wake > now)
+      sleep_us(wake - now);
+  }
+  CHECK(rc == 0, "prepare: rc=%d", rc);
+  CHECK(epd_busy_after_reset == 0 && epd_busy_after_cmd04 == 0,
+        "prepare: BUSY after reset %d, after POWER_ON %d",
+        epd_busy_after_reset, epd_busy_after_cmd04);
+  UDOUBLE lost;
+  UWORD n = EPD_7IN3F_TraceRead(tr, EPD_7IN3F_TRACE_LEN, &lost);
+  int rs = -1, cmdh = -1, pon = -1;
+  for (UWORD i = 0; i < n; i++) {
+    if (tr[i].kind == EPD_7IN3F_TR_RESET)
+      rs = i;
+    else if (tr[i].kind == EPD_7IN3F_TR_CMD && tr[i].code == 0xAA)
+      cmdh = i;
+    else if (tr[i].kind == EPD_7IN3F_TR_CMD && tr[i].code == 0x04)
+      pon = i;
+  }
+  CHECK(rs >= 0 && tr[rs + 1].kind == EPD_7IN3F_TR_WAIT && cmdh > rs + 1 &&
+            pon > cmdh && pon + 1 == n - 1 &&
+            tr[pon + 1].kind == EPD_7IN3F_TR_WAIT,
+        "prepare: trace RS %d CMDH %d PON %d of %u", rs, cmdh, pon, n);
+  rc = EPD_7IN3F_Display(image);
+  CHECK(rc == 0 && memcmp(host_panel_frame(), image, FRAME_BYTES) == 0,
+        "prepare: display rc=%d", rc);
+}
+
+// A: POWER_ON leaves BUSY HIGH (busy=1->1); B: it drops as usual. Neither
+// refreshes, and the panel is fine again once healthy.
+static void test_failure_mode(char mode) {
+  host_panel_set_fail(mode);
+  int before = host_panel_refreshes();
+  int rc = EPD_7IN3F_Display(image);
+  int busy04 = epd_busy_after_cmd04;
+  int32_t refresh_ms = epd_phase_refresh_ms;
+  CHECK(rc == -2, "mode %c: rc=%d", mode, rc);
+  CHECK(host_panel_refreshes() == before, "mode %c: refreshed", mode);
+  CHECK(busy04 == (mode == 'A'), "mode %c: EPD_BUSY04 ->%d", mode, busy04);
+  CHECK(epd_busy_after_cmd12 == 1 && epd_refresh_low_us == -1,
+        "mode %c: BUSY dropped on refresh", mode);
+  host_panel_set_fail(0);
+  rc = EPD_7IN3F_Display(image);
+  CHECK(rc == 0 && host_panel_refreshes() == before + 1,
+        "mode %c: no recovery (rc=%d)", mode, rc);
+  fprintf(out, "failure mode %c: rc=-2 busy04=1->%d refresh_ms=%ld\n", mode,
+          busy04, (long)refresh_ms);
+}
+
+int main(void) {
+  setenv("PICO_PANEL_SCALE", "0.001", 0);
+  fflush(stdout);
+  out = fdopen(dup(fileno(stdout)), "w");
+  setvbuf(out, NULL, _IOLBF, 0);
+  if (!freopen("/dev/null", "w", stdout))
+    return 1;
+
+  DEV_Module_Init();
+  int rc = EPD_7IN3F_Init();
+  CHECK(rc == 0, "init: rc=%d", rc);
+  test_clear();
+  test_show7block();
+  test_display();
+  test_display_stream();
+  test_trace();
+  test_prepare();
+  test_failure_mode('A');
+  test_failure_mode('B');
+  rc = EPD_7IN3F_Sleep();
+  CHECK(rc == 0, "sleep: rc=%d", rc);
+
+  if (failures == 0) {
+    fprintf(out, "All epd tests passed\n");
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,382 @@
+// Host harness for the incremental frame parser (lib/Link/frame_parser.c):
+// resync over noisy streams and parse throughput.
+//
+// Streams come from the stand-in peer in tests/fake_peer.c (ACK lines, SOF,
+// size header, payload). The stress test puts junk lines before the ACK and
+// noise thick with partial SOF markers before the SOF, then feeds the result
+// in random piece sizes, the way DMA blocks or a cooperative loop would hand
+// it over. Every run must report the peer's ACK line and header, decode a
+// frame identical to the source and count each junk byte in `skipped`. The
+// benchmark reports wire MB/s through frame_parser_feed() per format.
+//
+//   gcc -O2 tests/test_frame_parser.c tests/fake_peer.c tests/sample_frames.c
+//       lib/Link/frame_parser.c lib/Link/link_proto.c lib/Link/payload.c
+//       lib/Link/pack3.c lib/Link/tiles.c lib/Link/lz_decode.c
+//       lib/Link/crc32.c tools/lz_encode.c -o test_frame_parser
+//   ./test_frame_parser
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lib/Link/frame_parser.h"
+#include "../lib/Link/link_proto.h"
+#include "../lib/Link/payload.h"
+#include "fake_peer.h"
+#include "sample_frames.h"
+
+#define STRESS_RUNS 300
+#define NOISE_MAX 3000
+#define BENCH_NOISE (1 << 20)  // noise before the SOF in the hunt benchmark
+#define BENCH_MIN_S 0.3
+#define WIRE_CAP \
+  (LINK_CHUNKED_LEN(SAMPLE_FRAME_SIZE) + BENCH_NOISE + 64 * 128 + 256)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("FAILED: ");       \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      failures++;               \
+    }                           \
+  } while (0)
+
+static const uint8_t sof[4] = {0xAA, 0x55, 0xAA, 0x55};
+
+static uint8_t wire[WIRE_CAP];
+static uint8_t stream[WIRE_CAP];
+static uint8_t buffer[SAMPLE_FRAME_SIZE] __attribute__((aligned(4)));
+static payload_decoder_t dec;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t next_rand(uint32_t* s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s >> 8;
+}
+
+static size_t find_sof(const uint8_t* p, size_t from, size_t n) {
+  for (size_t i = from; i + sizeof(sof) <= n; i++)
+    if (memcmp(p + i, sof, sizeof(sof)) == 0)
+      return i;
+  return n;
+}
+
+// A frame as it should come out of the parser.
+typedef struct {
+  char ack[96];  // first ACK line, CR/LF stripped
+  uint8_t fmt;
+  size_t len;
+  size_t skipped;  // bytes between the ACK line and the SOF
+} expect_t;
+
+// Peer response for frame offering formats, with `lines` junk lines before
+// it and `noise` bytes of SOF-like noise in front of the SOF. Returns the
+// stream length in stream[].
+static size_t make_stream(const uint8_t* frame,
+                          uint8_t formats,
+                          int lines,
+                          size_t noise,
+                          uint32_t seed,
+                          expect_t* ex) {
+  fake_peer_t peer;
+  fake_peer_init(&peer, NULL, 0, 0, 4000000);
+  peer.formats = LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC;
+  link_baud_t lb;
+  link_baud_init(&lb, NULL, 0, 0);
+  char req[128];
+  link_format_request(&lb, formats, NULL, 0, req, sizeof(req));
+  size_t n = fake_peer_respond(&peer, req, frame, SAMPLE_FRAME_SIZE, wire,
+                               sizeof(wire));
+  CHECK(n > 0, "peer ignored '%s'", req);
+  ex->fmt = peer.frame_fmt;
+  ex->len = peer.frame_wire_len;
+  size_t eol = (size_t)((uint8_t*)memchr(wire, '\n', n) - wire);
+  memcpy(ex->ack, wire, eol);
+  ex->ack[eol] = '\0';
+  size_t at = find_sof(wire, eol, n);
+
+  // Junk lines never contain an 'A', some are longer than the line buffer.
+  size_t s = 0;
+  for (int l = 0; l < lines; l++) {
+    size_t len = next_rand(&seed) % 128;
+    for (size_t i = 0; i < len; i++) {
+      uint8_t c = (uint8_t)next_rand(&seed);
+      stream[s++] = (c == '\n' || c == 'A') ? '.' : c;
+    }
+    if (next_rand(&seed) & 1)
+      stream[s++] = '\r';
+    stream[s++] = '\n';
+  }
+  memcpy(stream + s, wire, at);
+  s += at;
+
+  // Noise: mostly AA / 55 so partial markers are everywhere. None may
+  // complete a SOF, also not together with the real one right after it.
+  size_t noise_at = s;
+  for (size_t i = 0; i < noise; i++) {
+    uint32_t r = next_rand(&seed) % 8;
+    stream[s++] = (r < 3) ? 0xAA : (r < 6) ? 0x55 : (uint8_t)next_rand(&seed);
+  }
+  memcpy(stream + s, wire + at, n - at);
+  s += n - at;
+  size_t real = noise_at + noise;
+  size_t hit = noise_at;
+  while ((hit = find_sof(stream, hit, s)) < real)
+    stream[hit + (hit + 3 < real ? 3 : 0)] = 0x00;
+  ex->skipped = (at - eol - 1) + noise;
+  return s;
+}
+
+// Result of parsing a whole stream.
+typedef struct {
+  int acks;
+  int headers;
+  frame_event_t last;
+  size_t unused;  // bytes left after the final event
+} result_t;
+
+// Feed stream[0..n) in pieces of 1..max_piece bytes (seed 0: max_piece
+// exactly), setting up the decoder at the header like the firmware does.
+static result_t parse(frame_parser_t* p,
+                      size_t n,
+                      size_t max_piece,
+                      uint32_t seed,
+                      const expect_t* ex) {
+  result_t r = {0, 0, FRAME_EV_NONE, 0};
+  frame_parser_init(p);
+  size_t off = 0;
+  while (off < n) {
+    size_t piece = seed ? 1 + next_rand(&seed) % max_piece : max_piece;
+    if (piece > n - off)
+      piece = n - off;
+    size_t used;
+    frame_event_t ev = frame_parser_feed(p, stream + off, piece, &used);
+    off += used;
+    if (ev == FRAME_EV_ACK) {
+      r.acks++;
+      if (ex)
+        CHECK(strcmp(p->line, ex->ack) == 0, "ACK line '%s', expected '%s'",
+              p->line, ex->ack);
+    } else if (ev == FRAME_EV_HEADER) {
+      r.headers++;
+      CHECK(p->state == FRAME_ST_READY, "state %d after header", p->state);
+      size_t none;
+      CHECK(frame_parser_feed(p, stream + off, n - off, &none) ==
+                    FRAME_EV_NONE &&
+                none == 0,
+            "parser ran past the header");
+      payload_init(&dec, p->fmt, p->len, buffer, sizeof(buffer));
+      frame_parser_begin_payload(p, &dec);
+    } else if (ev == FRAME_EV_DONE || ev == FRAME_EV_ERROR) {
+      r.last = ev;
+      break;
+    } else {
+      CHECK(used == piece, "only %zu of %zu bytes used without an event",
+            used, piece);
+    }
+  }
+  r.unused = n - off;
+  return r;
+}
+
+static void test_resync_cases(void) {
+  static const struct {
+    const char* name;
+    uint8_t junk[12];
+    size_t len;
+  } cases[] = {
+      {"none", {0}, 0},
+      {"AA", {0xAA}, 1},
+      {"AA AA", {0xAA, 0xAA}, 2},
+      {"AA 55 00", {0xAA, 0x55, 0x00}, 3},
+      {"AA 55 AA", {0xAA, 0x55, 0xAA}, 3},
+      {"AA 55 AA AA", {0xAA, 0x55, 0xAA, 0xAA}, 4},
+      {"AA 55 55", {0xAA, 0x55, 0x55}, 3},
+      {"AA 55 AA 00", {0xAA, 0x55, 0xAA, 0x00}, 4},
+      {"55 AA 55 55 AA", {0x55, 0xAA, 0x55, 0x55, 0xAA}, 5},
+      {"55 55 AA 55 AA", {0x55, 0x55, 0xAA, 0x55, 0xAA}, 5},
+  };
+  static const uint8_t payload[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    size_t n = 0;
+    memcpy(stream, "junk\nACK\nACK\n", 13);
+    n += 13;
+    memcpy(stream + n, cases[c].junk, cases[c].len);
+    n += cases[c].len;
+    memcpy(stream + n, sof, 4);
+    n += 4;
+    const uint8_t hdr[4] = {0, 0, 0, sizeof(payload)};
+    memcpy(stream + n, hdr, 4);
+    n += 4;
+    memcpy(stream + n, payload, sizeof(payload));
+    n += sizeof(payload);
+    stream[n++] = 0x42;  // trailing byte the parser must leave alone
+    const size_t pieces[] = {1, 2, 3, 5, 8, n};
+    for (size_t k = 0; k < sizeof(pieces) / sizeof(pieces[0]); k++) {
+      const size_t piece = pieces[k];
+      frame_parser_t p;
+      result_t r = parse(&p, n, piece, 0, NULL);
+      CHECK(r.acks == 1 && r.headers == 1 && r.last == FRAME_EV_DONE,
+            "%s piece %zu: acks %d headers %d last %d", cases[c].name, piece,
+            r.acks, r.headers, r.last);
+      CHECK(p.skipped == 4 + cases[c].len,
+            "%s piece %zu: skipped %zu, expected %zu", cases[c].name, piece,
+            p.skipped, 4 + cases[c].len);
+      CHECK(r.unused == 1 && memcmp(buffer, payload, sizeof(payload)) == 0,
+            "%s piece %zu: payload or trailing byte wrong", cases[c].name,
+            piece);
+    }
+  }
+}
+
+static void test_errors(void) {
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  sample_frame_dashboard(frame, 0);
+  expect_t ex;
+  frame_parser_t p;
+
+  // A flipped payload bit fails its chunk CRC.
+  size_t n = make_stream(frame, LINK_FMT_CRC, 0, 0, 1, &ex);
+  stream[n / 2] ^= 0x04;
+  result_t r = parse(&p, n, 4096, 0, &ex);
+  CHECK(r.last == FRAME_EV_ERROR && p.error == FRAME_ERR_CRC,
+        "bit flip: last %d error %d", r.last, p.error);
+
+  // An LZ payload cut short by its header never expands to a whole frame.
+  n = make_stream(frame, LINK_FMT_LZ, 0, 0, 1, &ex);
+  size_t hdr = find_sof(stream, 0, n) + 4;
+  CHECK(ex.fmt == LINK_FMT_LZ, "peer sent fmt %u for LZ", ex.fmt);
+  uint32_t len = (uint32_t)ex.len / 2;
+  stream[hdr + 1] = (uint8_t)(len >> 16);
+  stream[hdr + 2] = (uint8_t)(len >> 8);
+  stream[hdr + 3] = (uint8_t)len;
+  r = parse(&p, n, 4096, 0, &ex);
+  CHECK(r.last == FRAME_EV_ERROR && p.error == FRAME_ERR_SHORT,
+        "short LZ: last %d error %d", r.last, p.error);
+
+  // A raw payload longer than the frame does not fit the buffer.
+  n = make_stream(frame, 0, 0, 0, 1, &ex);
+  hdr = find_sof(stream, 0, n) + 4;
+  len = SAMPLE_FRAME_SIZE + 1;
+  stream[hdr + 1] = (uint8_t)(len >> 16);
+  stream[hdr + 2] = (uint8_t)(len >> 8);
+  stream[hdr + 3] = (uint8_t)len;
+  stream[n++] = 0;
+  r = parse(&p, n, 4096, 0, &ex);
+  CHECK(r.last == FRAME_EV_ERROR && p.error == FRAME_ERR_CORRUPT,
+        "oversized raw: last %d error %d", r.last, p.error);
+
+  // No ACK line, no SOF: everything is taken and nothing reported.
+  n = make_stream(frame, 0, 0, 0, 1, &ex);
+  r = parse(&p, find_sof(stream, 0, n), 4096, 0, &ex);
+  CHECK(r.acks == 1 && r.headers == 0 && p.state == FRAME_ST_SOF &&
+            r.unused == 0,
+        "stream cut before the SOF: state %d", p.state);
+  memset(stream, 'x', 1000);
+  r = parse(&p, 1000, 64, 0, NULL);
+  CHECK(r.acks == 0 && p.state == FRAME_ST_ACK && r.unused == 0,
+        "no ACK line: acks %d state %d", r.acks, p.state);
+}
+
+static void test_stress(void) {
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  static const uint8_t offers[] = {
+      0,
+      LINK_FMT_CRC,
+      LINK_FMT_P3,
+      LINK_FMT_LZ | LINK_FMT_CRC,
+      LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC,
+  };
+  static const size_t pieces[] = {1, 7, 64, 1500, 4096, 65536};
+  uint32_t seed = 12345;
+  size_t junk = 0, parsed = 0;
+  int ok = 0;
+  for (int run = 0; run < STRESS_RUNS; run++) {
+    if (run % 40 == 39)
+      sample_frame_noise(frame, (uint32_t)run);
+    else
+      sample_frame_dashboard(frame, run);
+    uint8_t formats = offers[next_rand(&seed) % sizeof(offers)];
+    int lines = (int)(next_rand(&seed) % 5);
+    size_t noise = next_rand(&seed) % (NOISE_MAX + 1);
+    expect_t ex;
+    size_t n = make_stream(frame, formats, lines, noise, seed, &ex);
+    size_t max_piece = pieces[next_rand(&seed) % 6];
+    memset(buffer, 0xFF, sizeof(buffer));
+    frame_parser_t p;
+    result_t r = parse(&p, n, max_piece, next_rand(&seed) | 1, &ex);
+    int good = r.acks == 1 && r.headers == 1 && r.last == FRAME_EV_DONE &&
+               p.fmt == ex.fmt && p.len == ex.len &&
+               p.skipped == ex.skipped && r.unused == 0 &&
+               memcmp(buffer, frame, SAMPLE_FRAME_SIZE) == 0;
+    CHECK(good,
+          "run %d fmt %u pieces <= %zu: acks %d headers %d last %d "
+          "error %d skipped %zu/%zu",
+          run, ex.fmt, max_piece, r.acks, r.headers, r.last, p.error,
+          p.skipped, ex.skipped);
+    ok += good;
+    junk += ex.skipped;
+    parsed += n;
+  }
+  printf("stress: %d/%d frames intact, %zu junk bytes skipped, %.1f MB "
+         "parsed\n",
+         ok, STRESS_RUNS, junk, (double)parsed / 1e6);
+}
+
+static void bench_one(const char* name, size_t n, size_t piece) {
+  frame_parser_t p;
+  int reps = 0;
+  double t0 = now_s(), t;
+  do {
+    result_t r = parse(&p, n, piece, 0, NULL);
+    if (r.last != FRAME_EV_DONE) {
+      printf("  %-16s failed\n", name);
+      failures++;
+      return;
+    }
+    reps++;
+  } while ((t = now_s() - t0) < BENCH_MIN_S);
+  printf("  %-16s %4zu B pieces %8zu wire bytes %8.1f MB/s %8.0f frames/s\n",
+         name, piece, n, (double)n * reps / t / 1e6, reps / t);
+}
+
+static void bench(void) {
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  expect_t ex;
+  printf("parse throughput (2 Mbaud is 0.2 MB/s):\n");
+  sample_frame_dashboard(frame, 0);
+  for (size_t piece = 64; piece <= 4096; piece *= 64) {
+    size_t n = make_stream(frame, 0, 0, 0, 1, &ex);
+    bench_one("raw", n, piece);
+    n = make_stream(frame, LINK_FMT_CRC, 0, 0, 1, &ex);
+    bench_one("raw+CRC", n, piece);
+    n = make_stream(frame, LINK_FMT_LZ | LINK_FMT_CRC, 0, 0, 1, &ex);
+    bench_one("LZ+CRC", n, piece);
+  }
+  sample_frame_noise(frame, 1);
+  size_t n = make_stream(frame, LINK_FMT_P3 | LINK_FMT_CRC, 0, 0, 1, &ex);
+  bench_one("P3+CRC (noise)", n, 4096);
+  n = make_stream(frame, LINK_FMT_P3 | LINK_FMT_CRC, 0, BENCH_NOISE, 1, &ex);
+  bench_one("1 MB SOF hunt", n, 4096);
+}
+
+int main(void) {
+  test_resync_cases();
+  test_errors();
+  test_stress();
+  if (failures == 0) {
+    printf("All frame_parser tests passed\n");
+    bench();
+    return failures ? 1 : 0;
+  }
+  return 1;
+}
@@ -0,0 +1,329 @@
+// Host test and benchmark for the LINK_FMT_P3 unpacker (lib/Link/pack3.c)
+// and the payload decode pipeline (lib/Link/payload.c).
+//
+// Checks every possible 8-pixel group, in-place unpacking, streaming with
+// ragged read sizes, LZ|P3 frames and streaming to a sink without a frame
+// buffer, then prints unpack throughput.
+//
+//   gcc -O2 tests/test_pack3.c tests/sample_frames.c lib/Link/pack3.c
+//       lib/Link/payload.c lib/Link/tiles.c lib/Link/lz_decode.c
+//       lib/Link/crc32.c tools/lz_encode.c -o test_pack3
+//   ./test_pack3
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lib/Link/crc32.h"
+#include "../lib/Link/link_proto.h"
+#include "../lib/Link/pack3.h"
+#include "../lib/Link/payload.h"
+#include "../tools/lz_encode.h"
+#include "sample_frames.h"
+
+#define RX_CHUNK_SIZE 4096
+#define BENCH_REPS 50
+#define P3_FRAME_SIZE PACK3_SIZE(SAMPLE_FRAME_SIZE)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("FAILED: ");       \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      failures++;               \
+    }                           \
+  } while (0)
+
+static uint8_t frame[SAMPLE_FRAME_SIZE] __attribute__((aligned(4)));
+static uint8_t packed[P3_FRAME_SIZE] __attribute__((aligned(4)));
+static uint8_t out[SAMPLE_FRAME_SIZE + 16] __attribute__((aligned(4)));
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// All 2^24 packed groups must survive unpack -> pack, and unpacked nibbles
+// must stay below 8.
+static void test_all_groups(void) {
+  enum { BATCH = 4096 };
+  static uint8_t in[BATCH * 3] __attribute__((aligned(4)));
+  static uint8_t px[BATCH * 4] __attribute__((aligned(4)));
+  static uint8_t back[BATCH * 3];
+  int bad = 0;
+  for (uint32_t base = 0; base < (1u << 24) && !bad; base += BATCH) {
+    for (uint32_t i = 0; i < BATCH; i++) {
+      uint32_t v = base + i;
+      in[i * 3] = (uint8_t)(v >> 16);
+      in[i * 3 + 1] = (uint8_t)(v >> 8);
+      in[i * 3 + 2] = (uint8_t)v;
+    }
+    pack3_unpack(px, in, BATCH);
+    for (size_t i = 0; i < sizeof(px); i++)
+      bad |= px[i] & 0x88;
+    pack3_pack(back, px, BATCH);
+    bad |= memcmp(back, in, sizeof(in)) != 0;
+  }
+  CHECK(!bad, "exhaustive group round trip");
+
+  // Pixel order: p0 is the high nibble of the first byte.
+  static const uint8_t px8[4] = {0x01, 0x23, 0x45, 0x67};
+  uint8_t p[3];
+  pack3_pack(p, px8, 1);
+  CHECK(p[0] == 0x05 && p[1] == 0x39 && p[2] == 0x77,
+        "pack order %02X %02X %02X", p[0], p[1], p[2]);
+}
+
+// A frame received into the tail of its own buffer unpacks in place.
+static void test_in_place(void) {
+  sample_frame_dashboard(frame, 0);
+  pack3_pack(packed, frame, SAMPLE_FRAME_SIZE / 4);
+  memcpy(out + SAMPLE_FRAME_SIZE - P3_FRAME_SIZE, packed, P3_FRAME_SIZE);
+  pack3_unpack(out, out + SAMPLE_FRAME_SIZE - P3_FRAME_SIZE,
+               SAMPLE_FRAME_SIZE / 4);
+  CHECK(!memcmp(out, frame, SAMPLE_FRAME_SIZE), "in-place unpack");
+}
+
+// Streaming with read sizes that split groups every possible way.
+static void test_stream(void) {
+  sample_frame_noise(frame, 7);
+  pack3_pack(packed, frame, SAMPLE_FRAME_SIZE / 4);
+  static const size_t steps[] = {1, 2, 5, 4096, 7, 3, 1000, 11};
+  pack3_stream_t s;
+  pack3_stream_init(&s);
+  size_t off = 0, produced = 0;
+  for (int i = 0; off < P3_FRAME_SIZE; i++) {
+    size_t n = steps[i % 8];
+    if (n > P3_FRAME_SIZE - off)
+      n = P3_FRAME_SIZE - off;
+    produced += pack3_unpack_stream(&s, packed + off, n, out + produced);
+    off += n;
+  }
+  CHECK(produced == SAMPLE_FRAME_SIZE && s.ncarry == 0,
+        "stream produced %zu", produced);
+  CHECK(!memcmp(out, frame, SAMPLE_FRAME_SIZE), "stream unpack");
+}
+
+// Feed a wire payload through the decoder in pieces of `step` bytes.
+static int feed_all(payload_decoder_t* p, const uint8_t* wire, size_t len,
+                    size_t step) {
+  for (size_t off = 0; off < len; off += step) {
+    size_t n = (len - off < step) ? len - off : step;
+    if (payload_feed(p, wire + off, n) != 0)
+      return -1;
+  }
+  return payload_complete(p) ? 0 : -1;
+}
+
+static void test_payload(void) {
+  static payload_decoder_t dec;
+  static uint8_t wire[LZ_BOUND(SAMPLE_FRAME_SIZE)];
+  sample_frame_dashboard(frame, 754);
+  pack3_pack(packed, frame, SAMPLE_FRAME_SIZE / 4);
+
+  // P3 only, odd read sizes.
+  payload_init(&dec, LINK_FMT_P3, P3_FRAME_SIZE, out, SAMPLE_FRAME_SIZE);
+  CHECK(feed_all(&dec, packed, P3_FRAME_SIZE, 1001) == 0 &&
+            !memcmp(out, frame, SAMPLE_FRAME_SIZE),
+        "payload P3");
+
+  // LZ|P3 through the stage buffer.
+  size_t n = lz_encode(packed, P3_FRAME_SIZE, wire);
+  CHECK(n <= payload_max_wire(LINK_FMT_LZ | LINK_FMT_P3, SAMPLE_FRAME_SIZE),
+        "LZ|P3 exceeds max wire");
+  memset(out, 0, sizeof(out));
+  payload_init(&dec, LINK_FMT_LZ | LINK_FMT_P3, n, out, SAMPLE_FRAME_SIZE);
+  CHECK(feed_all(&dec, wire, n, 333) == 0 &&
+            !memcmp(out, frame, SAMPLE_FRAME_SIZE),
+        "payload LZ|P3");
+
+  // A short P3 frame is not complete; a long one overflows.
+  payload_init(&dec, LINK_FMT_P3, P3_FRAME_SIZE - 3, out, SAMPLE_FRAME_SIZE);
+  CHECK(feed_all(&dec, packed, P3_FRAME_SIZE - 3, 4096) != 0,
+        "short P3 frame accepted");
+  payload_init(&dec, LINK_FMT_P3, P3_FRAME_SIZE, out, SAMPLE_FRAME_SIZE - 4);
+  CHECK(feed_all(&dec, packed, P3_FRAME_SIZE, 4096) != 0,
+        "oversized P3 frame accepted");
+}
+
+typedef struct {
+  size_t at;       // frame bytes received so far
+  size_t max_run;  // largest single sink call
+} sink_state_t;
+
+static void to_out(void* ctx, const uint8_t* data, size_t n) {
+  sink_state_t* s = ctx;
+  if (s->at + n <= sizeof(out))
+    memcpy(out + s->at, data, n);
+  s->at += n;
+  if (n > s->max_run)
+    s->max_run = n;
+}
+
+// Cut a payload into CRC32-checked chunks. Returns the wire length.
+static size_t add_crcs(const uint8_t* in, size_t len, uint8_t* wire) {
+  size_t n = 0;
+  for (size_t off = 0; off < len; off += LINK_CHUNK_SIZE) {
+    size_t k = (len - off < LINK_CHUNK_SIZE) ? len - off : LINK_CHUNK_SIZE;
+    memcpy(wire + n, in + off, k);
+    n += k;
+    uint32_t crc = crc32_update(0, in + off, k);
+    for (int i = 3; i >= 0; i--)
+      wire[n++] = (uint8_t)(crc >> (8 * i));
+  }
+  return n;
+}
+
+// Every format streamed through a small window must come out in order and
+// equal to the buffered decode, whatever the read size.
+static void test_sink(void) {
+  static payload_decoder_t dec;
+  static uint8_t enc[LZ_BOUND(SAMPLE_FRAME_SIZE)];
+  static uint8_t wire[LINK_CHUNKED_LEN(LZ_BOUND(SAMPLE_FRAME_SIZE))];
+  static uint8_t win[1024] __attribute__((aligned(4)));
+  static const uint8_t fmts[] = {LINK_FMT_RAW, LINK_FMT_P3, LINK_FMT_LZ,
+                                 LINK_FMT_LZ | LINK_FMT_P3};
+  sample_frame_dashboard(frame, 1234);
+  pack3_pack(packed, frame, SAMPLE_FRAME_SIZE / 4);
+  for (size_t f = 0; f < sizeof(fmts) * 2; f++) {
+    uint8_t fmt = fmts[f % sizeof(fmts)];
+    if (f >= sizeof(fmts))
+      fmt |= LINK_FMT_CRC;
+    const uint8_t* src = (fmt & LINK_FMT_P3) ? packed : frame;
+    size_t len = (fmt & LINK_FMT_P3) ? P3_FRAME_SIZE : SAMPLE_FRAME_SIZE;
+    if (fmt & LINK_FMT_LZ) {
+      len = lz_encode(src, len, enc);
+      src = enc;
+    }
+    size_t wire_len = len;
+    if (fmt & LINK_FMT_CRC)
+      wire_len = add_crcs(src, len, wire);
+    else
+      memcpy(wire, src, len);
+
+    memset(out, 0, sizeof(out));
+    sink_state_t s = {0, 0};
+    payload_init(&dec, fmt, len, NULL, SAMPLE_FRAME_SIZE);
+    payload_set_sink(&dec, to_out, &s, win, sizeof(win));
+    CHECK(feed_all(&dec, wire, wire_len, 777 + f) == 0 &&
+              s.at == SAMPLE_FRAME_SIZE && s.max_run <= sizeof(win) &&
+              !memcmp(out, frame, SAMPLE_FRAME_SIZE),
+          "sink fmt=%u: %zu bytes, largest run %zu", fmt, s.at, s.max_run);
+  }
+
+  // Delta frames patch a whole frame and cannot stream.
+  sink_state_t s = {0, 0};
+  payload_init(&dec, LINK_FMT_DELTA, 64, NULL, SAMPLE_FRAME_SIZE);
+  payload_set_sink(&dec, to_out, &s, win, sizeof(win));
+  CHECK(payload_feed(&dec, frame, 64) != 0, "delta frame streamed");
+}
+
+// Like a DMA reader: each window is only read at the next sink call, so
+// the decoder must not touch it before then.
+typedef struct {
+  size_t at;
+  const uint8_t* held;
+  size_t held_n;
+  int same;  // consecutive calls handed the same window
+} alt_state_t;
+
+static void to_out_late(void* ctx, const uint8_t* data, size_t n) {
+  alt_state_t* s = ctx;
+  if (s->held) {
+    if (s->at + s->held_n <= sizeof(out))
+      memcpy(out + s->at, s->held, s->held_n);
+    s->at += s->held_n;
+    s->same += (s->held == data);
+  }
+  s->held = data;
+  s->held_n = n;
+}
+
+// Two alternating windows: same output even though each one is only read
+// while the other fills.
+static void test_sink_alt(void) {
+  static payload_decoder_t dec;
+  static uint8_t enc[LZ_BOUND(SAMPLE_FRAME_SIZE)];
+  static uint8_t win[2][1024] __attribute__((aligned(4)));
+  static const uint8_t fmts[] = {LINK_FMT_RAW, LINK_FMT_P3, LINK_FMT_LZ,
+                                 LINK_FMT_LZ | LINK_FMT_P3};
+  sample_frame_dashboard(frame, 4321);
+  pack3_pack(packed, frame, SAMPLE_FRAME_SIZE / 4);
+  for (size_t f = 0; f < sizeof(fmts); f++) {
+    uint8_t fmt = fmts[f];
+    const uint8_t* src = (fmt & LINK_FMT_P3) ? packed : frame;
+    size_t len = (fmt & LINK_FMT_P3) ? P3_FRAME_SIZE : SAMPLE_FRAME_SIZE;
+    if (fmt & LINK_FMT_LZ) {
+      len = lz_encode(src, len, enc);
+      src = enc;
+    }
+    memset(out, 0, sizeof(out));
+    alt_state_t s = {0, NULL, 0, 0};
+    payload_init(&dec, fmt, len, NULL, SAMPLE_FRAME_SIZE);
+    payload_set_sink(&dec, to_out_late, &s, win[0], sizeof(win[0]));
+    payload_set_sink_alt(&dec, win[1]);
+    int rc = feed_all(&dec, src, len, 333 + f);
+    to_out_late(&s, NULL, 0);  // the last window goes out
+    CHECK(rc == 0 && s.at == SAMPLE_FRAME_SIZE && s.same == 0 &&
+              !memcmp(out, frame, SAMPLE_FRAME_SIZE),
+          "alt sink fmt=%u: %zu bytes, %d reused", fmt, s.at, s.same);
+  }
+}
+
+static void bench(void) {
+  static payload_decoder_t dec;
+  static uint8_t wire[LZ_BOUND(SAMPLE_FRAME_SIZE)];
+  sample_frame_dashboard(frame, 0);
+  pack3_pack(packed, frame, SAMPLE_FRAME_SIZE / 4);
+
+  double t0 = now_s();
+  for (int r = 0; r < BENCH_REPS; r++)
+    pack3_unpack(out, packed, SAMPLE_FRAME_SIZE / 4);
+  double block = (now_s() - t0) / BENCH_REPS;
+
+  t0 = now_s();
+  for (int r = 0; r < BENCH_REPS; r++) {
+    payload_init(&dec, LINK_FMT_P3, P3_FRAME_SIZE, out, SAMPLE_FRAME_SIZE);
+    feed_all(&dec, packed, P3_FRAME_SIZE, RX_CHUNK_SIZE);
+  }
+  double stream = (now_s() - t0) / BENCH_REPS;
+
+  size_t lz_raw = lz_encode(frame, SAMPLE_FRAME_SIZE, wire);
+  size_t lz_p3 = lz_encode(packed, P3_FRAME_SIZE, wire);
+  t0 = now_s();
+  for (int r = 0; r < BENCH_REPS; r++) {
+    payload_init(&dec, LINK_FMT_LZ | LINK_FMT_P3, lz_p3, out,
+                 SAMPLE_FRAME_SIZE);
+    feed_all(&dec, wire, lz_p3, RX_CHUNK_SIZE);
+  }
+  double lzp3 = (now_s() - t0) / BENCH_REPS;
+
+  printf("unpack block   %7.1f MB/s out (%.3f ms/frame)\n",
+         SAMPLE_FRAME_SIZE / block / 1e6, block * 1e3);
+  printf("unpack stream  %7.1f MB/s out (%.3f ms/frame, %d-byte reads)\n",
+         SAMPLE_FRAME_SIZE / stream / 1e6, stream * 1e3, RX_CHUNK_SIZE);
+  printf("LZ|P3 decode   %7.1f MB/s out (%.3f ms/frame)\n",
+         SAMPLE_FRAME_SIZE / lzp3 / 1e6, lzp3 * 1e3);
+  printf("dashboard wire: raw %d  P3 %d  LZ %zu  LZ|P3 %zu bytes\n",
+         SAMPLE_FRAME_SIZE, P3_FRAME_SIZE, lz_raw, lz_p3);
+}
+
+int main(void) {
+  test_all_groups();
+  test_in_place();
+  test_stream();
+  test_payload();
+  test_sink();
+  test_sink_alt();
+  if (failures == 0) {
+    printf("All pack3 tests passed\n");
+    bench();
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,406 @@
+// Host test for lib/GUI/GUI_Paint.c.
+//
+// Display list: a scene of overlapping primitives (clears, filled and
+// hollow rectangles, circles, dotted lines, points, text with and without a
+// background, a bitmap) is drawn once onto a full canvas and once recorded
+// with Paint_ListBegin() and rasterized by Paint_ListRows() in bands of
+// several heights. Both must come out byte for byte the same, for every
+// rotation and mirror and for scales 2 and 7. A list that ran out of room
+// must refuse to render.
+//
+// Span fills: Paint_ClearWindows() over every start and end alignment must
+// set the same pixels as Paint_SetPixel() one at a time, for scales 2, 4 and
+// 7 and every rotation and mirror.
+//
+// Glyphs: Paint_DrawChar() through the lookup tables must match the font
+// drawn bit by bit with Paint_SetPixel(), for every font, rotation and
+// mirror, odd and even positions, and opaque and transparent backgrounds.
+//
+// GB2312 strings: Paint_DrawString_CN() through the code index and the glyph
+// tables must match every character looked up in order and drawn bit by
+// bit, for both CN fonts and for a copy of one that has no index, including
+// characters the font lacks.
+//
+// Dirty rectangles: after each call of the scene every pixel that changed
+// must lie in one of at most PAINT_DIRTY_MAX rectangles, for every rotation
+// and mirror; recording a list and rendering it must leave them alone, a
+// line of text must come out as one rectangle, and Paint_ResetDirty() must
+// empty them.
+//
+//   gcc -O2 -Itests/host -Ilib/Config tests/test_paint.c lib/GUI/GUI_Paint.c
+//       lib/Fonts/font*.c -o test_paint
+//   ./test_paint
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/GUI/GUI_Paint.h"
+
+#define WIDTH 800
+#define HEIGHT 480
+#define CANVAS_BYTES (WIDTH / 2 * HEIGHT)
+#define LIST_OPS 256
+
+#define CHECK(cond, ...)          \
+  do {                            \
+    if (!(cond)) {                \
+      printf("FAILED: ");         \
+      printf(__VA_ARGS__);        \
+      printf("\n");               \
+      failures++;                 \
+    }                             \
+  } while (0)
+
+static int failures = 0;
+static UBYTE full[CANVAS_BYTES];
+static UBYTE banded[CANVAS_BYTES];
+static UBYTE bitmap[CANVAS_BYTES];
+static PAINT_OP ops[LIST_OPS];
+static char text[256];
+
+// Colours 0-6 for scale 7; scale 2 keeps to BLACK and WHITE.
+static UWORD colour(int scale, int i) {
+  if (scale == 2)
+    return (i & 1) ? WHITE : BLACK;
+  return (UWORD)(i % 7);
+}
+
+static void draw_scene(int scale) {
+  const char cn[] = {'a', 'b', Font12CN.table[0].index[0],
+                     Font12CN.table[0].index[1], 'c', 0};
+  Paint_Clear(colour(scale, 1));
+  Paint_DrawBitMap(bitmap);
+  Paint_ClearWindows(40, 30, 300, 200, colour(scale, 5));
+  for (int i = 0; i < 6; i++)
+    Paint_DrawRectangle(20 + 60 * i, 20 + 25 * i, 200 + 60 * i, 150 + 25 * i,
+                        colour(scale, i + 2), DOT_PIXEL_1X1, DRAW_FILL_FULL);
+  Paint_DrawRectangle(100, 90, 420, 300, colour(scale, 0), DOT_PIXEL_3X3,
+                      DRAW_FILL_EMPTY);
+  Paint_DrawCircle(300, 240, 120, colour(scale, 4), DOT_PIXEL_1X1,
+                   DRAW_FILL_FULL);
+  Paint_DrawCircle(330, 200, 90, colour(scale, 3), DOT_PIXEL_2X2,
+                   DRAW_FILL_EMPTY);
+  Paint_DrawLine(0, 0, 479, 479, colour(scale, 0), DOT_PIXEL_2X2,
+                 LINE_STYLE_DOTTED);
+  Paint_DrawLine(470, 10, 5, 400, colour(scale, 6), DOT_PIXEL_1X1,
+                 LINE_STYLE_SOLID);
+  for (int i = 0; i < 8; i++)
+    Paint_DrawPoint(50 + 40 * i, 420, colour(scale, i),
+                    (DOT_PIXEL)(1 + i % 4),
+                    (i & 1) ? DOT_FILL_RIGHTUP : DOT_FILL_AROUND);
+  Paint_DrawString_EN(30, 200, "Overlap 12:34", &Font24, colour(scale, 0),
+                      colour(scale, 1));
+  Paint_DrawString_EN(60, 215, "see-through", &Font16, WHITE, colour(scale, 2));
+  Paint_DrawNum(10, 450, 987654, &Font20, colour(scale, 6), colour(scale, 1));
+  Paint_DrawString_CN(200, 300, cn, &Font12CN, colour(scale, 3),
+                      colour(scale, 1));
+  Paint_DrawString_CN(210, 310, cn, &Font12CN, colour(scale, 0), WHITE);
+}
+
+static void new_canvas(UBYTE* image, int scale, UWORD rotate, UBYTE mirror) {
+  Paint_NewImage(image, WIDTH, HEIGHT, rotate, WHITE);
+  Paint_SetScale((UBYTE)scale);
+  Paint_SetMirroring(mirror);
+}
+
+// Scene on a full canvas vs. the same scene recorded and rendered in bands
+// of rows rows.
+static void test_list(int scale, UWORD rotate, UBYTE mirror) {
+  new_canvas(full, scale, rotate, mirror);
+  draw_scene(scale);
+  UDOUBLE bytes = (UDOUBLE)Paint.WidthByte * HEIGHT;
+
+  new_canvas(NULL, scale, rotate, mirror);
+  PAINT_LIST list;
+  Paint_ListBegin(&list, ops, LIST_OPS, text, sizeof(text));
+  draw_scene(scale);
+  Paint_ListEnd();
+  CHECK(!list.Overflow, "list: overflow with %u ops", list.Count);
+
+  static const UWORD band_rows[] = {1, 4, 7, 40, HEIGHT};
+  for (size_t b = 0; b < sizeof(band_rows) / sizeof(band_rows[0]); b++) {
+    UWORD rows = band_rows[b];
+    memset(banded, 0xA5, sizeof(banded));
+    int rc = 0;
+    for (UWORD y = 0; y < HEIGHT && rc == 0; y += rows) {
+      UWORD n = (HEIGHT - y < rows) ? HEIGHT - y : rows;
+      rc = Paint_ListRows(banded + (UDOUBLE)y * Paint.WidthByte, y, n, &list);
+    }
+    UDOUBLE diff = 0;
+    while (diff < bytes && full[diff] == banded[diff])
+      diff++;
+    CHECK(rc == 0 && diff == bytes,
+          "scale %d rotate %u mirror %u, %u-row bands: rc=%d, first "
+          "difference in row %lu",
+          scale, rotate, mirror, rows, rc,
+          (unsigned long)(diff / Paint.WidthByte));
+  }
+  CHECK(Paint.Image == NULL && Paint.Rotate == rotate,
+        "list: canvas state not restored");
+}
+
+// Rows 3-5 of the canvas (columns 3-5 when rotated), [x0, x1) for x0, x1
+// near the start, near the end and across byte and word boundaries.
+static void test_fill(int scale, UWORD rotate, UBYTE mirror) {
+  static const UWORD xs[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33,
+                             100, 463, 471, 472, 478, 479, 480};
+  const size_t n = sizeof(xs) / sizeof(xs[0]);
+  int bad = 0;
+  for (size_t i = 0; i < n && !bad; i++) {
+    for (size_t j = i; j < n && !bad; j++) {
+      UWORD x0 = xs[i], x1 = xs[j];
+      UWORD colour_fill = (UWORD)((i + j) % (scale == 7 ? 7 : scale));
+      if (scale == 2)
+        colour_fill = (i + j) & 1 ? WHITE : BLACK;
+      new_canvas(full, scale, rotate, mirror);
+      memset(full, 0x96, sizeof(full));
+      for (UWORD y = 3; y < 6; y++)
+        for (UWORD x = x0; x < x1; x++)
+          Paint_SetPixel(x, y, colour_fill);
+      new_canvas(banded, scale, rotate, mirror);
+      memset(banded, 0x96, sizeof(banded));
+      Paint_ClearWindows(x0, 3, x1, 6, colour_fill);
+      bad = memcmp(full, banded, sizeof(full)) != 0;
+      CHECK(!bad, "fill: scale %d rotate %u mirror %u, x %u..%u", scale,
+            rotate, mirror, x0, x1);
+    }
+  }
+}
+
+// Paint_DrawChar() as it was: one Paint_SetPixel() per font bit.
+static void reference_char(UWORD x, UWORD y, char c, sFONT* font, UWORD fg,
+                           UWORD bg) {
+  UWORD stride = (font->Width + 7) / 8;
+  const UBYTE* glyph = &font->table[(c - ' ') * font->Height * stride];
+  for (UWORD row = 0; row < font->Height; row++)
+    for (UWORD col = 0; col < font->Width; col++) {
+      if (glyph[row * stride + col / 8] & (0x80 >> (col % 8)))
+        Paint_SetPixel(x + col, y + row, fg);
+      else if (bg != FONT_BACKGROUND)
+        Paint_SetPixel(x + col, y + row, bg);
+    }
+}
+
+static void test_glyph(UWORD rotate, UBYTE mirror) {
+  static sFONT* const fonts[] = {&Font8, &Font12, &Font16, &Font20, &Font24};
+  static const UWORD backgrounds[] = {FONT_BACKGROUND, 3};
+  for (int f = 0; f < 5; f++)
+    for (int b = 0; b < 2; b++)
+      for (UWORD x = 20; x < 22; x++) {
+        memset(full, 0x65, sizeof(full));
+        memset(banded, 0x65, sizeof(banded));
+        for (int i = 0; i < 4; i++) {
+          char c = "@gQ~"[i];
+          UWORD cx = x + i * (fonts[f]->Width + 1), cy = 30 + i;
+          new_canvas(full, 7, rotate, mirror);
+          reference_char(cx, cy, c, fonts[f], i, backgrounds[b]);
+          new_canvas(banded, 7, rotate, mirror);
+          Paint_DrawChar(cx, cy, c, fonts[f], i, backgrounds[b]);
+        }
+        CHECK(memcmp(full, banded, sizeof(full)) == 0,
+              "glyph: font %u rotate %u mirror %u x %u background %u",
+              fonts[f]->Height, rotate, mirror, x, backgrounds[b]);
+      }
+}
+
+// Paint_DrawString_CN() as it was: a scan of the table per character, then
+// one Paint_SetPixel() per font bit.
+static void reference_cn(UWORD x, UWORD y, const char* str, const cFONT* font,
+                         UWORD fg, UWORD bg) {
+  for (const UBYTE* p = (const UBYTE*)str; *p;) {
+    int len = *p <= 0x7F ? 1 : 2;
+    for (UWORD n = 0; n < font->size; n++) {
+      const UBYTE* index = (const UBYTE*)font->table[n].index;
+      if (index[0] != p[0] || (len == 2 && index[1] != p[1]))
+        continue;
+      const UBYTE* bits = (const UBYTE*)font->table[n].matrix;
+      UWORD stride = (font->Width + 7) / 8;
+      for (UWORD row = 0; row < font->Height; row++)
+        for (UWORD col = 0; col < font->Width; col++) {
+          if (bits[row * stride + col / 8] & (0x80 >> (col % 8)))
+            Paint_SetPixel(x + col, y + row, fg);
+          else if (bg != FONT_BACKGROUND)
+            Paint_SetPixel(x + col, y + row, bg);
+        }
+      break;
+    }
+    x += len == 1 ? font->ASCII_Width : font->Width;
+    p += len;
+  }
+}
+
+static void test_cn(UWORD rotate, UBYTE mirror) {
+  static cFONT unindexed;
+  unindexed = Font24CN;
+  cFONT* const fonts[] = {&Font12CN, &Font24CN, &unindexed};
+  static const UWORD backgrounds[] = {FONT_BACKGROUND, 2};
+  for (int f = 0; f < 3; f++) {
+    // Every entry, last to first, then a character no font has and one past
+    // the right edge
+    char str[2 * 32 + 8];
+    int n = 0;
+    for (int e = fonts[f]->size - 1; e >= 0; e--) {
+      const char* index = fonts[f]->table[e].index;
+      str[n++] = index[0];
+      if ((UBYTE)index[0] > 0x7F)
+        str[n++] = index[1];
+    }
+    str[n++] = (char)0xB0;
+    str[n++] = (char)0xA1;
+    str[n++] = 'a';
+    str[n] = 0;
+    for (int b = 0; b < 2; b++)
+      for (UWORD x = 5; x < 7; x++) {
+        UWORD y = 60 + x;
+        memset(full, 0x43, sizeof(full));
+        memset(banded, 0x43, sizeof(banded));
+        new_canvas(full, 7, rotate, mirror);
+        reference_cn(x, y, str, fonts[f], 6, backgrounds[b]);
+        reference_cn(x, y + 50, str + 2, fonts[f], 1, backgrounds[b]);
+        new_canvas(banded, 7, rotate, mirror);
+        Paint_DrawString_CN(x, y, str, fonts[f], 6, backgrounds[b]);
+        Paint_DrawString_CN(x, y + 50, str + 2, fonts[f], 1, backgrounds[b]);
+        CHECK(memcmp(full, banded, sizeof(full)) == 0,
+              "cn: font %d rotate %u mirror %u x %u background %u", f, rotate,
+              mirror, x, backgrounds[b]);
+      }
+  }
+}
+
+static int in_dirty(UDOUBLE x, UDOUBLE y) {
+  const PAINT_RECT* rects;
+  UBYTE n = Paint_GetDirty(&rects);
+  for (UBYTE i = 0; i < n; i++)
+    if (x >= rects[i].X0 && x < rects[i].X1 && y >= rects[i].Y0 &&
+        y < rects[i].Y1)
+      return 1;
+  return 0;
+}
+
+// Pixels of full that differ from banded (scale 7) must be dirty.
+static int undirty_pixels(void) {
+  int bad = 0;
+  for (UDOUBLE i = 0; i < CANVAS_BYTES; i++) {
+    UBYTE diff = full[i] ^ banded[i];
+    UDOUBLE x = i % (WIDTH / 2) * 2, y = i / (WIDTH / 2);
+    bad += (diff & 0xF0) && !in_dirty(x, y);
+    bad += (diff & 0x0F) && !in_dirty(x + 1, y);
+  }
+  return bad;
+}
+
+// The scene on full, compared with banded (the canvas before) after each
+// call.
+static void test_dirty(UWORD rotate, UBYTE mirror) {
+  memset(full, 0x34, sizeof(full));
+  memset(banded, 0x34, sizeof(banded));
+  new_canvas(full, 7, rotate, mirror);
+  const PAINT_RECT* rects;
+  CHECK(Paint_GetDirty(&rects) == 0, "dirty: new canvas is dirty");
+
+  Paint_ClearWindows(40, 30, 300, 200, 5);
+  int bad = undirty_pixels();
+  Paint_DrawRectangle(100, 90, 420, 300, 0, DOT_PIXEL_3X3, DRAW_FILL_EMPTY);
+  bad += undirty_pixels();
+  Paint_DrawCircle(300, 240, 120, 4, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+  bad += undirty_pixels();
+  Paint_DrawCircle(5, 5, 90, 3, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+  bad += undirty_pixels();
+  Paint_DrawLine(0, 0, 150, 150, 0, DOT_PIXEL_2X2, LINE_STYLE_DOTTED);
+  bad += undirty_pixels();
+  for (int i = 0; i < 12; i++)
+    Paint_DrawPoint(50 + 37 * i, 420 - 29 * i, i % 7, (DOT_PIXEL)(1 + i % 4),
+                    (i & 1) ? DOT_FILL_RIGHTUP : DOT_FILL_AROUND);
+  bad += undirty_pixels();
+  Paint_SetPixel(Paint.Width - 1, Paint.Height - 1, 2);
+  Paint_DrawString_EN(30, 200, "Overlap 12:34", &Font24, 0, 1);
+  Paint_DrawString_CN(400, 10, "abc", &Font24CN, 3, FONT_BACKGROUND);
+  bad += undirty_pixels();
+  CHECK(bad == 0, "dirty: rotate %u mirror %u, %d changed pixels outside",
+        rotate, mirror, bad);
+  CHECK(Paint_GetDirty(&rects) <= PAINT_DIRTY_MAX, "dirty: too many");
+
+  // Recording and rendering a list draw nothing into Paint.Image
+  UBYTE before = Paint_GetDirty(&rects);
+  PAINT_RECT first = rects[0];
+  PAINT_LIST list;
+  Paint_ListBegin(&list, ops, LIST_OPS, text, sizeof(text));
+  Paint_DrawCircle(600, 10, 9, 1, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+  Paint_ListEnd();
+  Paint_ListRows(banded, 0, 8, &list);
+  CHECK(Paint_GetDirty(&rects) == before && rects[0].X0 == first.X0 &&
+            rects[0].Y1 == first.Y1,
+        "dirty: display list changed them");
+
+  // A line of text is one rectangle, the glyphs side by side
+  Paint_ResetDirty();
+  CHECK(Paint_GetDirty(&rects) == 0, "dirty: not reset");
+  Paint_DrawString_EN(20, 40, "dirty text", &Font16, 0, 1);
+  UBYTE n = Paint_GetDirty(&rects);
+  UWORD w = 10 * Font16.Width, h = Font16.Height;
+  UWORD long_side = rotate % 180 ? rects[0].Y1 - rects[0].Y0
+                                 : rects[0].X1 - rects[0].X0;
+  UWORD short_side = rotate % 180 ? rects[0].X1 - rects[0].X0
+                                  : rects[0].Y1 - rects[0].Y0;
+  CHECK(n == 1 && long_side == w && short_side == h,
+        "dirty: text as %u rectangles, first %ux%u", n, long_side,
+        short_side);
+
+  // Single pixels next to the last rectangle, once a reset or a new rotation
+  // has made what Paint_SetPixel() knows of it stale
+  Paint_SetPixel(10, 10, 1);
+  Paint_SetPixel(11, 10, 2);
+  Paint_ResetDirty();
+  memcpy(banded, full, sizeof(full));
+  Paint_SetPixel(11, 10, 4);
+  bad = undirty_pixels();
+  Paint_SetPixel(30, 20, 1);
+  Paint_SetPixel(31, 20, 2);
+  Paint_SetRotate((rotate + 90) % 360);
+  Paint_SetPixel(31, 20, 4);
+  bad += undirty_pixels();
+  CHECK(bad == 0, "dirty: rotate %u, %d single pixels outside", rotate, bad);
+}
+
+static void test_overflow(void) {
+  new_canvas(NULL, 7, ROTATE_0, MIRROR_NONE);
+  PAINT_LIST list;
+  Paint_ListBegin(&list, ops, 4, text, sizeof(text));
+  draw_scene(7);
+  Paint_ListEnd();
+  CHECK(list.Overflow && list.Count == 4, "overflow: count %u", list.Count);
+  CHECK(Paint_ListRows(banded, 0, 4, &list) != 0, "overflow: rendered");
+}
+
+int main(void) {
+  for (UDOUBLE i = 0; i < sizeof(bitmap); i++)
+    bitmap[i] = (UBYTE)(((i / 400) % 3 == 0) ? 0x33 : ((i * 7) & 0x66));
+  static const UWORD rotations[] = {ROTATE_0, ROTATE_90, ROTATE_180,
+                                    ROTATE_270};
+  for (int r = 0; r < 4; r++)
+    for (UBYTE m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++)
+      test_list(7, rotations[r], m);
+  test_list(2, ROTATE_0, MIRROR_NONE);
+  test_list(2, ROTATE_90, MIRROR_VERTICAL);
+  static const int scales[] = {2, 4, 7};
+  for (int s = 0; s < 3; s++)
+    for (int r = 0; r < 4; r++)
+      for (UBYTE m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++)
+        test_fill(scales[s], rotations[r], m);
+  for (int r = 0; r < 4; r++)
+    for (UBYTE m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++)
+      test_glyph(rotations[r], m);
+  for (int r = 0; r < 4; r++)
+    for (UBYTE m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++)
+      test_cn(rotations[r], m);
+  for (int r = 0; r < 4; r++)
+    for (UBYTE m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++)
+      test_dirty(rotations[r], m);
+  test_overflow();
+
+  if (failures == 0) {
+    printf("All paint tests passed\n");
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,309 @@
+// Host harness for chunk CRCs and SENDIMG FROM= resume (lib/Link/payload.c,
+// lib/Link/link_proto.c) against the stand-in peer in tests/fake_peer.c.
+//
+// Each attempt mirrors request_and_receive_image(): request (with FROM= /
+// ID= after a failure), ACK, SOF, header, then the payload fed through the
+// payload decoder in RX_CHUNK_SIZE pieces. Faults (dropped bytes, bit flips)
+// are injected into everything after the ACK lines; a frame that ends short
+// counts as a data timeout. A frame is only accepted when its CRC32 matches
+// the ACK's ID, and the harness checks that no accepted frame differs from
+// what the peer sent.
+//
+//   gcc -O2 tests/test_resume.c tests/fake_peer.c tests/sample_frames.c
+//       lib/Link/link_proto.c lib/Link/payload.c lib/Link/pack3.c
+//       lib/Link/tiles.c lib/Link/lz_decode.c lib/Link/crc32.c
+//       tools/lz_encode.c -o test_resume
+//   ./test_resume
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/Link/crc32.h"
+#include "../lib/Link/link_proto.h"
+#include "../lib/Link/payload.h"
+#include "fake_peer.h"
+#include "sample_frames.h"
+
+#define RX_CHUNK_SIZE 4096
+#define MAX_ATTEMPTS 12
+#define WIRE_CAP (LINK_CHUNKED_LEN(LZ_BOUND(SAMPLE_FRAME_SIZE)) + 256)
+
+static int failures = 0;
+
+#define CHECK(cond, ...)        \
+  do {                          \
+    if (!(cond)) {              \
+      printf("FAILED: ");       \
+      printf(__VA_ARGS__);      \
+      printf("\n");             \
+      failures++;               \
+    }                           \
+  } while (0)
+
+typedef struct {
+  uint32_t flip_ppm;  // bit flips per million wire bytes
+  uint32_t drop_ppm;  // dropped bytes per million wire bytes
+  long flip_at;       // one extra flip at this payload offset (-1: none)
+  uint32_t seed;
+} faults_t;
+
+typedef struct {
+  int attempts;
+  size_t wire_bytes;  // bytes after the ACK lines, over all attempts
+  size_t resumed;     // attempts the peer resumed
+  int accepted_bad;   // accepted frames that differ from the source
+} stats_t;
+
+static uint8_t wire[WIRE_CAP];
+static uint8_t buffer[SAMPLE_FRAME_SIZE] __attribute__((aligned(4)));
+static payload_decoder_t dec;
+
+static uint32_t next_rand(uint32_t* s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s >> 8;
+}
+
+// Inject faults into wire[start..n); returns the new length.
+static size_t inject(faults_t* f, size_t start, size_t n) {
+  if (f->flip_at >= 0 && start + 8 + (size_t)f->flip_at < n) {
+    wire[start + 8 + (size_t)f->flip_at] ^= 0x10;
+    f->flip_at = -1;  // first attempt only
+  }
+  size_t w = start;
+  for (size_t r = start; r < n; r++) {
+    if (f->drop_ppm && next_rand(&f->seed) % 1000000 < f->drop_ppm)
+      continue;
+    uint8_t b = wire[r];
+    if (f->flip_ppm && next_rand(&f->seed) % 1000000 < f->flip_ppm)
+      b ^= (uint8_t)(1u << (next_rand(&f->seed) & 7));
+    wire[w++] = b;
+  }
+  return w;
+}
+
+// One SENDIMG cycle. Returns 0 when a frame was accepted.
+static int attempt(fake_peer_t* peer,
+                   const uint8_t* frame,
+                   uint8_t formats,
+                   link_resume_t* resume,
+                   faults_t* f,
+                   stats_t* st) {
+  link_baud_t lb;
+  link_baud_init(&lb, NULL, 0, 0);
+  char req[128];
+  link_format_request(&lb, formats, resume, 0, req, sizeof(req));
+  size_t n = fake_peer_respond(peer, req, frame, SAMPLE_FRAME_SIZE, wire,
+                               sizeof(wire));
+  CHECK(n > 0, "peer ignored '%s'", req);
+
+  // ACK line (sent twice), then everything else may be damaged.
+  char ack[96];
+  size_t i = 0;
+  while (i < n && wire[i] != '\n' && i < sizeof(ack) - 1) {
+    ack[i] = (char)wire[i];
+    i++;
+  }
+  ack[i] = '\0';
+  size_t start = 2 * (i + 1);
+  n = inject(f, start, n);
+  st->attempts++;
+  st->wire_bytes += n - start;
+
+  link_resume_t ack_resume;
+  int ack_has_id = link_parse_resume(ack, &ack_resume);
+  size_t from = 0;
+  if (ack_has_id && resume->from && ack_resume.from == resume->from &&
+      ack_resume.id == resume->id && resume->from < SAMPLE_FRAME_SIZE)
+    from = resume->from;
+  st->resumed += from != 0;
+
+  // SOF + header.
+  size_t p = start;
+  while (p + 4 <= n && !(wire[p] == 0xAA && wire[p + 1] == 0x55 &&
+                         wire[p + 2] == 0xAA && wire[p + 3] == 0x55))
+    p++;
+  if (p + 8 > n)
+    return -1;
+  uint32_t h = ((uint32_t)wire[p + 4] << 24) | ((uint32_t)wire[p + 5] << 16) |
+               ((uint32_t)wire[p + 6] << 8) | wire[p + 7];
+  uint8_t fmt = LINK_HDR_FMT(h);
+  size_t len = LINK_HDR_LEN(h);
+  p += 8;
+  if (!link_fmt_accepted(fmt, formats, from) ||
+      len > payload_max_wire(fmt, SAMPLE_FRAME_SIZE - from))
+    return -1;  // header damage: retry without changing the resume point
+
+  payload_init(&dec, fmt, len, buffer + from, SAMPLE_FRAME_SIZE - from);
+  size_t wire_len = (fmt & LINK_FMT_CRC) ? LINK_CHUNKED_LEN(len) : len;
+  size_t avail = n - p;
+  int rc = 0;
+  for (size_t off = 0; off < wire_len && rc == 0; off += RX_CHUNK_SIZE) {
+    size_t k = wire_len - off;
+    if (k > RX_CHUNK_SIZE)
+      k = RX_CHUNK_SIZE;
+    if (off + k > avail) {
+      rc = -1;  // ran dry: data timeout
+      if (off < avail)
+        rc = payload_feed(&dec, wire + p + off, avail - off) ? -3 : -1;
+      break;
+    }
+    rc = payload_feed(&dec, wire + p + off, k);
+  }
+  if (rc == 0 && !payload_complete(&dec))
+    rc = -3;
+  if (rc != 0) {
+    const int chunked = (fmt & LINK_FMT_CRC) && ack_has_id;
+    resume->from = chunked ? (uint32_t)(from + dec.verified) : 0;
+    resume->id = ack_resume.id;
+    return rc;
+  }
+  resume->from = 0;
+  if (ack_has_id &&
+      crc32_update(0, buffer, SAMPLE_FRAME_SIZE) != ack_resume.id)
+    return -2;
+  if (memcmp(buffer, frame, SAMPLE_FRAME_SIZE) != 0)
+    st->accepted_bad++;
+  return 0;
+}
+
+// Receive one frame, retrying like main(). Returns 1 on success.
+static int receive(fake_peer_t* peer,
+                   const uint8_t* frame,
+                   uint8_t formats,
+                   int use_resume,
+                   faults_t* f,
+                   stats_t* st) {
+  link_resume_t resume = {0, 0};
+  memset(buffer, 0xFF, sizeof(buffer));
+  for (int a = 0; a < MAX_ATTEMPTS; a++) {
+    if (attempt(peer, frame, formats, &resume, f, st) == 0)
+      return 1;
+    if (!use_resume)
+      resume.from = 0;
+  }
+  return 0;
+}
+
+static void test_single_flip(uint8_t formats, const char* name) {
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  sample_frame_noise(frame, 3);
+  static const uint32_t rates[] = {921600};
+  fake_peer_t peer;
+  fake_peer_init(&peer, rates, 1, 0, 4000000);
+  peer.formats = LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC;
+
+  // Flip a bit in chunk 20 of the payload: the retry resumes at chunk 20.
+  faults_t f = {0, 0, 20 * (LINK_CHUNK_SIZE + LINK_CRC_SIZE) + 100, 1};
+  stats_t st = {0};
+  CHECK(receive(&peer, frame, formats, 1, &f, &st) == 1, "%s: no frame",
+        name);
+  CHECK(st.attempts == 2 && st.resumed == 1, "%s: attempts=%d resumed=%zu",
+        name, st.attempts, st.resumed);
+  CHECK(st.accepted_bad == 0, "%s: accepted a corrupt frame", name);
+  printf("%-14s attempts=%d resumed_from=%-6u wire=%zu\n", name, st.attempts,
+         (unsigned)peer.frame_from, st.wire_bytes);
+}
+
+static void test_new_frame(void) {
+  // The peer moved on to a different frame: FROM= is ignored, full frame.
+  static uint8_t a[SAMPLE_FRAME_SIZE], b[SAMPLE_FRAME_SIZE];
+  sample_frame_dashboard(a, 0);
+  sample_frame_dashboard(b, 1);
+  fake_peer_t peer;
+  fake_peer_init(&peer, NULL, 0, 0, 4000000);
+  peer.formats = LINK_FMT_CRC;
+  char req[128];
+  link_baud_t lb;
+  link_baud_init(&lb, NULL, 0, 0);
+  link_resume_t r = {65536, crc32_update(0, a, sizeof(a))};
+  link_format_request(&lb, LINK_FMT_CRC, &r, 0, req, sizeof(req));
+  fake_peer_respond(&peer, req, b, sizeof(b), wire, sizeof(wire));
+  CHECK(peer.frame_from == 0, "resumed into a different frame");
+  fake_peer_respond(&peer, req, a, sizeof(a), wire, sizeof(wire));
+  CHECK(peer.frame_from == 65536, "same frame not resumed");
+}
+
+// Header formats a resumed frame may come in: an unaligned P3 rest would be
+// unpacked with word stores off a word boundary (a HardFault on the M0+).
+static void test_format_check(void) {
+  const uint8_t all = LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC | LINK_FMT_DELTA;
+  CHECK(link_fmt_accepted(LINK_FMT_P3 | LINK_FMT_CRC, all, 0) &&
+            link_fmt_accepted(LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC, all,
+                              8192) &&
+            link_fmt_accepted(LINK_FMT_LZ | LINK_FMT_CRC, all, 8190),
+        "format check: refused a good header");
+  CHECK(!link_fmt_accepted(LINK_FMT_P3 | LINK_FMT_CRC, all, 8190) &&
+            !link_fmt_accepted(LINK_FMT_LZ | LINK_FMT_P3, all, 1) &&
+            !link_fmt_accepted(LINK_FMT_DELTA, all, 4096) &&
+            !link_fmt_accepted(LINK_FMT_P3, LINK_FMT_LZ, 0),
+        "format check: took a bad header");
+
+  // Asked to resume off a group, the stand-in peer drops P3.
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  sample_frame_noise(frame, 5);
+  fake_peer_t peer;
+  fake_peer_init(&peer, NULL, 0, 0, 4000000);
+  peer.formats = LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC;
+  link_resume_t r = {8190, crc32_update(0, frame, sizeof(frame))};
+  faults_t f = {0, 0, -1, 1};
+  stats_t st = {0};
+  memset(buffer, 0, sizeof(buffer));
+  memcpy(buffer, frame, r.from);
+  CHECK(attempt(&peer, frame, peer.formats, &r, &f, &st) == 0 &&
+            peer.frame_from == 8190,
+        "format check: unaligned resume failed");
+}
+
+// Many frames over a noisy link, with and without resume.
+static void soak(const char* name, uint8_t formats, uint32_t flip_ppm,
+                 uint32_t drop_ppm) {
+  static uint8_t frame[SAMPLE_FRAME_SIZE];
+  fake_peer_t peer;
+  fake_peer_init(&peer, NULL, 0, 0, 4000000);
+  peer.formats = formats;
+  stats_t st[2] = {{0}, {0}};
+  int got[2] = {0, 0};
+  const int frames = 20;
+  for (int use = 0; use < 2; use++) {
+    faults_t f = {flip_ppm, drop_ppm, -1, 42};
+    for (int m = 0; m < frames; m++) {
+      if (m & 1)
+        sample_frame_noise(frame, (uint32_t)m);
+      else
+        sample_frame_dashboard(frame, m * 7);
+      got[use] += receive(&peer, frame, formats, use, &f, &st[use]);
+    }
+    // Without chunk CRCs (and so without an ID) damage goes unnoticed.
+    if (formats & LINK_FMT_CRC)
+      CHECK(st[use].accepted_bad == 0, "%s: %d corrupt frames accepted",
+            name, st[use].accepted_bad);
+  }
+  if (formats & LINK_FMT_CRC)
+    CHECK(got[1] >= got[0] && st[1].wire_bytes <= st[0].wire_bytes,
+          "%s: resume did not help", name);
+  printf("%-14s full: %2d/%d ok %3d tries %8zu B | resume: %2d/%d ok "
+         "%3d tries %8zu B %3zu resumed | bad accepted %d\n",
+         name, got[0], frames, st[0].attempts, st[0].wire_bytes, got[1],
+         frames, st[1].attempts, st[1].wire_bytes, st[1].resumed,
+         st[1].accepted_bad);
+}
+
+int main(void) {
+  test_single_flip(LINK_FMT_CRC, "raw+CRC");
+  test_single_flip(LINK_FMT_P3 | LINK_FMT_CRC, "P3+CRC");
+  test_single_flip(LINK_FMT_LZ | LINK_FMT_CRC, "LZ+CRC");
+  test_new_frame();
+  test_format_check();
+
+  soak("raw, no CRC", LINK_FMT_RAW, 3, 1);
+  soak("raw+CRC", LINK_FMT_CRC, 3, 1);
+  soak("LZ|P3+CRC", LINK_FMT_LZ | LINK_FMT_P3 | LINK_FMT_CRC, 3, 1);
+  soak("raw+CRC noisy", LINK_FMT_CRC, 20, 5);
+
+  if (failures == 0) {
+    printf("All resume tests passed\n");
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,92 @@
+// cn_index - generate lib/Fonts/fontCN_index.c, the sorted code index over
+// the CH_CN tables of the GB2312 fonts.
+//
+//   gcc -O2 -Ilib/Fonts tools/cn_index.c lib/Fonts/font12CN.c
+//       lib/Fonts/font24CN.c -o cn_index
+//   ./cn_index > lib/Fonts/fontCN_index.c
+//
+// Run it again whenever a CN font table changes. Each table gets its codes
+// (index[0] << 8 | index[1], or index[0] << 8 for ASCII, which
+// Paint_DrawString_CN() matches on the first byte alone) in ascending order
+// with the table position of each. Where a code occurs twice, the first
+// entry wins, as it does for a linear scan. A font that is missing from the
+// index, or whose index no longer matches its table, is still drawn through
+// a linear scan.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fonts.h"
+
+typedef struct {
+  const char* name;
+  const cFONT* font;
+} font_t;
+
+static const font_t fonts[] = {
+    {"Font12CN", &Font12CN},
+    {"Font24CN", &Font24CN},
+};
+
+typedef struct {
+  uint16_t code;
+  uint16_t entry;
+} code_key_t;
+
+static uint16_t code_of(const CH_CN* ch) {
+  uint8_t b0 = (uint8_t)ch->index[0], b1 = (uint8_t)ch->index[1];
+  return b0 < 0x80 ? (uint16_t)(b0 << 8) : (uint16_t)(b0 << 8 | b1);
+}
+
+static int by_code(const void* a, const void* b) {
+  const code_key_t *x = a, *y = b;
+  if (x->code != y->code)
+    return x->code < y->code ? -1 : 1;
+  return x->entry < y->entry ? -1 : x->entry > y->entry;
+}
+
+// Prints the two arrays for f; returns how many codes it kept.
+static uint16_t emit(const font_t* f) {
+  uint16_t n = f->font->size;
+  code_key_t* keys = malloc(n * sizeof(*keys));
+  if (!keys) {
+    perror("malloc");
+    exit(1);
+  }
+  for (uint16_t i = 0; i < n; i++) {
+    keys[i].code = code_of(&f->font->table[i]);
+    keys[i].entry = i;
+  }
+  qsort(keys, n, sizeof(*keys), by_code);
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < n; i++)
+    if (kept == 0 || keys[i].code != keys[kept - 1].code)
+      keys[kept++] = keys[i];
+
+  printf("static const uint16_t %s_Code[%u] = {", f->name, kept);
+  for (uint16_t i = 0; i < kept; i++)
+    printf("%s0x%04X,", i % 8 ? " " : "\n  ", keys[i].code);
+  printf("\n};\n\nstatic const uint16_t %s_Entry[%u] = {", f->name, kept);
+  for (uint16_t i = 0; i < kept; i++)
+    printf("%s%u,", i % 8 ? " " : "\n  ", keys[i].entry);
+  printf("\n};\n\n");
+  free(keys);
+  return kept;
+}
+
+int main(void) {
+  size_t count = sizeof(fonts) / sizeof(fonts[0]);
+  printf(
+      "// Generated by tools/cn_index.c from the CH_CN tables; do not edit.\n"
+      "// See that file for how to regenerate it.\n\n"
+      "#include \"fonts.h\"\n\n");
+  uint16_t kept[sizeof(fonts) / sizeof(fonts[0])];
+  for (size_t i = 0; i < count; i++)
+    kept[i] = emit(&fonts[i]);
+  printf("const cFONT_INDEX FontCN_Index[%zu] = {\n", count);
+  for (size_t i = 0; i < count; i++)
+    printf("  {&%s, %s_Code, %s_Entry, %u, %u},\n", fonts[i].name,
+           fonts[i].name, fonts[i].name, kept[i], fonts[i].font->size);
+  printf("};\n\nconst uint16_t FontCN_IndexCount = %zu;\n", count);
+  return 0;
+}
@@ -0,0 +1,154 @@
+// epd_trace - decode the panel bus trace from a PLOG capture.
+//
+//   gcc -O2 tools/epd_trace.c -o epd_trace
+//   ./epd_trace log.txt                 one table per EPD_TRACE in the log
+//   ./epd_trace -q log.txt > a.txt      without times, for diff(1) against
+//                                       another cycle
+//
+// Reads the EPD_TRACE / EPD_TR lines main.c logs at the end of a cycle (any
+// prefix, such as the ESP32's "[PICO] ", is skipped) from the files named or
+// stdin. Each entry is printed with its time since the first one, the BUSY
+// level at its start and end, and the command name, data length and first
+// data byte; a wait shows how long it took and whether BUSY got to the level
+// it was waiting for.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_MAX_LEN 1024
+
+typedef struct {
+  unsigned char code;
+  const char* name;
+} cmd_name_t;
+
+// UC8179-family names as in the Waveshare 7.3" F driver.
+static const cmd_name_t cmd_names[] = {
+    {0x00, "PSR panel setting"},     {0x01, "PWR power setting"},
+    {0x02, "POF power off"},         {0x03, "PFS power off sequence"},
+    {0x04, "PON power on"},          {0x05, "BTST1 booster"},
+    {0x06, "BTST2 booster"},         {0x07, "DSLP deep sleep"},
+    {0x08, "BTST3 booster"},         {0x10, "DTM frame data"},
+    {0x12, "DRF display refresh"},   {0x13, "IPC"},
+    {0x30, "PLL"},                   {0x41, "TSE temperature"},
+    {0x50, "CDI vcom/data interval"}, {0x60, "TCON"},
+    {0x61, "TRES resolution"},       {0x82, "VDCS vcom dc"},
+    {0x84, "T_VDCS"},                {0x86, "AGID"},
+    {0xAA, "CMDH"},                  {0xE0, "CCSET"},
+    {0xE3, "PWS power saving"},      {0xE6, "TSSET"},
+};
+
+static int quiet = 0;
+static int traces = 0;
+static unsigned long t_us;  // since the first entry of this trace
+
+static const char* cmd_name(unsigned code) {
+  for (size_t i = 0; i < sizeof(cmd_names) / sizeof(cmd_names[0]); i++)
+    if (cmd_names[i].code == code)
+      return cmd_names[i].name;
+  return "?";
+}
+
+// One token: <code><b0><b1>+<dt>[/<len>[=<d0>]].
+static void decode_token(const char* tok) {
+  if (strlen(tok) < 6 || tok[4] != '+') {
+    printf("  (bad token %s)\n", tok);
+    return;
+  }
+  char code[3] = {tok[0], tok[1], 0};
+  int b0 = tok[2] - '0', b1 = tok[3] - '0';
+  char* end;
+  unsigned long dt = strtoul(tok + 5, &end, 16);
+  unsigned long len = 0;
+  int has_len = 0, d0 = -1;
+  if (*end == '/') {
+    len = strtoul(end + 1, &end, 16);
+    has_len = 1;
+  }
+  if (*end == '=')
+    d0 = (int)strtol(end + 1, &end, 16);
+  t_us += dt;
+
+  if (!quiet)
+    printf("%10.3f %9.3f  ", t_us / 1000.0, dt / 1000.0);
+  printf("%d->%d  ", b0, b1);
+  if (!strcmp(code, "RS")) {
+    printf("reset pulse\n");
+  } else if (code[0] == 'W') {
+    int want = code[1] == 'H';
+    printf("wait BUSY %s", want ? "HIGH" : "LOW");
+    if (!quiet)
+      printf(" %.3f ms", len / 1000.0);
+    printf("%s\n", b1 == want ? "" : "  TIMEOUT");
+  } else {
+    unsigned c = (unsigned)strtoul(code, NULL, 16);
+    if (has_len)
+      printf("%02X %-22s %lu B", c, cmd_name(c), len);
+    else
+      printf("%02X %s", c, cmd_name(c));
+    if (d0 >= 0)
+      printf(" [%02X..]", d0);
+    printf("\n");
+  }
+}
+
+static void decode_line(char* line) {
+  char* p = strstr(line, "EPD_TRACE ");
+  if (p) {
+    unsigned n = 0;
+    unsigned long lost = 0, t0 = 0;
+    sscanf(p, "EPD_TRACE n=%u lost=%lu t0_us=%lu", &n, &lost, &t0);
+    if (traces++)
+      printf("\n");
+    printf("trace %d: %u entries", traces, n);
+    if (lost)
+      printf(", %lu older ones lost", lost);
+    if (!quiet)
+      printf(", first at %.3f s\n      t_ms     dt_ms  busy  event\n",
+             t0 / 1e6);
+    else
+      printf("\n");
+    t_us = 0;
+    return;
+  }
+  p = strstr(line, "EPD_TR ");
+  if (!p)
+    return;
+  for (char* tok = strtok(p + 7, " \r\n"); tok; tok = strtok(NULL, " \r\n"))
+    decode_token(tok);
+}
+
+static void decode_file(FILE* f) {
+  char line[LINE_MAX_LEN];
+  while (fgets(line, sizeof(line), f))
+    decode_line(line);
+}
+
+int main(int argc, char** argv) {
+  int argi = 1;
+  for (; argi < argc && argv[argi][0] == '-' && argv[argi][1]; argi++) {
+    if (!strcmp(argv[argi], "-q")) {
+      quiet = 1;
+    } else {
+      fprintf(stderr, "usage: %s [-q] [log ...]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (argi == argc)
+    decode_file(stdin);
+  for (; argi < argc; argi++) {
+    FILE* f = fopen(argv[argi], "r");
+    if (!f) {
+      perror(argv[argi]);
+      return 1;
+    }
+    decode_file(f);
+    fclose(f);
+  }
+  if (!traces) {
+    fprintf(stderr, "no EPD_TRACE in the input\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+// img_lz - compress a raw 4bpp panel frame into the LINK_FMT_LZ payload.
+//
+//   gcc -O2 tools/img_lz.c tools/lz_encode.c lib/Link/lz_decode.c
+//       lib/Link/pack3.c -o img_lz
+//   ./img_lz frame.bin frame.lz          payload only
+//   ./img_lz -f frame.bin frame.wire     SOF + size header + payload, ready to
+//                                        stream after the ACK lines
+//   ./img_lz -d frame.lz frame.bin       decode (round-trip check)
+//
+// With -f the header carries LINK_FMT_LZ in its top byte. If compression does
+// not pay off, the raw frame is written with LINK_FMT_RAW instead. -p packs
+// the frame to 3 bits per pixel (LINK_FMT_P3) before compressing, or unpacks
+// after decoding with -d.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/Link/link_proto.h"
+#include "../lib/Link/lz_decode.h"
+#include "../lib/Link/pack3.h"
+#include "lz_encode.h"
+
+static uint8_t* read_file(const char* path, size_t* len) {
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t* buf = malloc(n > 0 ? (size_t)n : 1);
+  if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+    free(buf);
+    buf = NULL;
+  }
+  fclose(f);
+  *len = (size_t)n;
+  return buf;
+}
+
+static int write_file(const char* path, const uint8_t* a, size_t alen,
+                      const uint8_t* b, size_t blen) {
+  FILE* f = fopen(path, "wb");
+  if (!f)
+    return -1;
+  int ok = fwrite(a, 1, alen, f) == alen && fwrite(b, 1, blen, f) == blen;
+  fclose(f);
+  return ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+  int decode = 0, frame = 0, p3 = 0;
+  int argi = 1;
+  for (; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (!strcmp(argv[argi], "-d"))
+      decode = 1;
+    else if (!strcmp(argv[argi], "-f"))
+      frame = 1;
+    else if (!strcmp(argv[argi], "-p"))
+      p3 = 1;
+  }
+  if (argc - argi != 2) {
+    fprintf(stderr, "usage: %s [-p] [-f|-d] <in> <out>\n", argv[0]);
+    return 2;
+  }
+  size_t in_len;
+  uint8_t* in = read_file(argv[argi], &in_len);
+  if (!in) {
+    perror(argv[argi]);
+    return 1;
+  }
+
+  if (decode) {
+    static lz_decoder_t dec;
+    lz_decoder_init(&dec);
+    size_t cap = in_len * 300 + 64;  // generous: long runs compress ~250x
+    uint8_t* out = malloc(cap);
+    size_t out_len = 0;
+    int32_t used = lz_decode(&dec, in, in_len, out, cap, &out_len);
+    if (used != (int32_t)in_len || !lz_decoder_idle(&dec)) {
+      fprintf(stderr, "corrupt or truncated stream\n");
+      return 1;
+    }
+    if (p3) {
+      size_t groups = out_len / PACK3_GROUP_IN;
+      uint8_t* px = malloc(groups * PACK3_GROUP_OUT + 4);
+      pack3_unpack(px, out, groups);
+      free(out);
+      out = px;
+      out_len = groups * PACK3_GROUP_OUT;
+    }
+    return write_file(argv[argi + 1], out, out_len, NULL, 0) ? 1 : 0;
+  }
+
+  uint8_t base = LINK_FMT_RAW;
+  if (p3) {
+    size_t groups = in_len / PACK3_GROUP_OUT;
+    pack3_pack(in, in, groups);  // packing shrinks, so in place is fine
+    in_len = groups * PACK3_GROUP_IN;
+    base = LINK_FMT_P3;
+  }
+
+  uint8_t* out = malloc(LZ_BOUND(in_len));
+  size_t out_len = lz_encode(in, in_len, out);
+  uint8_t fmt = base | LINK_FMT_LZ;
+  const uint8_t* payload = out;
+  if (out_len >= in_len) {
+    fmt = base;
+    payload = in;
+    out_len = in_len;
+  }
+  fprintf(stderr, "%zu -> %zu bytes (ratio %.1f:1, fmt=%u)\n", in_len, out_len,
+          (double)in_len / (double)out_len, fmt);
+
+  uint8_t hdr[8] = {0xAA, 0x55, 0xAA, 0x55};
+  uint32_t h = ((uint32_t)fmt << 24) | (uint32_t)out_len;
+  hdr[4] = (uint8_t)(h >> 24);
+  hdr[5] = (uint8_t)(h >> 16);
+  hdr[6] = (uint8_t)(h >> 8);
+  hdr[7] = (uint8_t)h;
+  if (!frame && !(fmt & LINK_FMT_LZ)) {
+    fprintf(stderr, "frame does not compress; use -f to emit it raw\n");
+    return 1;
+  }
+  return write_file(argv[argi + 1], hdr, frame ? sizeof(hdr) : 0, payload,
+                    out_len)
+             ? 1
+             : 0;
+}
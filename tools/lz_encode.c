@@ -0,0 +1,103 @@
+#include "lz_encode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lib/Link/lz_decode.h"
+
+#define HASH_BITS 15
+#define HASH_SIZE (1u << HASH_BITS)
+#define MAX_CHAIN 64
+#define NO_POS 0xFFFFFFFFu
+
+static uint32_t hash3(const uint8_t* p) {
+  uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+size_t lz_encode(const uint8_t* in, size_t in_len, uint8_t* out) {
+  uint32_t* head = malloc(HASH_SIZE * sizeof(uint32_t));
+  uint32_t* prev = malloc(LZ_WINDOW_SIZE * sizeof(uint32_t));
+  if (!head || !prev) {
+    free(head);
+    free(prev);
+    return 0;
+  }
+  for (size_t i = 0; i < HASH_SIZE; i++)
+    head[i] = NO_POS;
+
+  size_t op = 0;
+  size_t flag_pos = 0;
+  int nflags = 8;  // forces a new flag byte on the first item
+  size_t pos = 0;
+
+#define INSERT(p)                                   \
+  do {                                              \
+    if ((p) + LZ_MIN_MATCH <= in_len) {             \
+      uint32_t h_ = hash3(in + (p));                \
+      prev[(p) & (LZ_WINDOW_SIZE - 1)] = head[h_];  \
+      head[h_] = (uint32_t)(p);                     \
+    }                                               \
+  } while (0)
+
+  while (pos < in_len) {
+    if (nflags == 8) {
+      flag_pos = op;
+      out[op++] = 0;
+      nflags = 0;
+    }
+
+    size_t best_len = 0;
+    size_t best_dist = 0;
+    if (pos + LZ_MIN_MATCH <= in_len) {
+      uint32_t cand = head[hash3(in + pos)];
+      for (int chain = 0; chain < MAX_CHAIN && cand != NO_POS; chain++) {
+        size_t dist = pos - cand;
+        if (dist > LZ_MAX_DIST)
+          break;
+        size_t len = 0;
+        while (pos + len < in_len && in[cand + len] == in[pos + len])
+          len++;
+        if (len > best_len) {
+          best_len = len;
+          best_dist = dist;
+          if (pos + len == in_len)
+            break;
+        }
+        uint32_t next = prev[cand & (LZ_WINDOW_SIZE - 1)];
+        if (next == NO_POS || next >= cand)
+          break;  // slot reused by a newer position
+        cand = next;
+      }
+    }
+
+    if (best_len >= LZ_MIN_MATCH) {
+      out[flag_pos] |= (uint8_t)(1u << nflags);
+      size_t l = best_len - LZ_MIN_MATCH;
+      size_t d = best_dist - 1;
+      out[op++] = (uint8_t)(((l < 15 ? l : 15) << 4) | (d >> 8));
+      out[op++] = (uint8_t)(d & 0xFF);
+      if (l >= 15) {
+        size_t ext = l - 15;
+        while (ext >= 255) {
+          out[op++] = 255;
+          ext -= 255;
+        }
+        out[op++] = (uint8_t)ext;
+      }
+      for (size_t i = 0; i < best_len; i++)
+        INSERT(pos + i);
+      pos += best_len;
+    } else {
+      out[op++] = in[pos];
+      INSERT(pos);
+      pos++;
+    }
+    nflags++;
+  }
+#undef INSERT
+
+  free(head);
+  free(prev);
+  return op;
+}
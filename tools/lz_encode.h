@@ -0,0 +1,14 @@
+#ifndef _LZ_ENCODE_H_
+#define _LZ_ENCODE_H_
+
+// Host-side encoder for the LINK_FMT_LZ payload; see lib/Link/lz_decode.h
+// for the stream layout. Not built into the firmware.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compress in[0..in_len) into out (at least LZ_BOUND(in_len) bytes).
+// Returns the encoded length.
+size_t lz_encode(const uint8_t* in, size_t in_len, uint8_t* out);
+
+#endif